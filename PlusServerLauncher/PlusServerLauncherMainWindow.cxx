@@ -19,17 +19,22 @@ See License.txt for details.
 // Qt includes
 #include <QCheckBox>
 #include <QComboBox>
-#include <QDomDocument>
+#include <QCryptographicHash>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QHostAddress>
 #include <QHostInfo>
 #include <QIcon>
 #include <QKeyEvent>
+#include <QMutexLocker>
 #include <QNetworkInterface>
 #include <QProcess>
 #include <QRegExp>
 #include <QStatusBar>
 #include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
 #include <QTimer>
 
 // VTK includes
@@ -37,17 +42,33 @@ See License.txt for details.
 
 // STL includes
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 
+#if defined(__linux__)
+  #include <dirent.h>
+  #include <unistd.h>
+#endif
+
 // OpenIGTLinkIO includes
 #include <igtlioDevice.h>
 #include <igtlioCommand.h>
 
+// OpenIGTLink includes
+#include <igtlCommandMessage.h>
+#include <igtlMessageHeader.h>
+
 enum ServerTableColumns
 {
   ID,
   Name,
   Description,
+  Cpu,
+  Memory,
+  Threads,
+  Sockets,
+  Uptime,
   Button,
   ColumnCount,
 };
@@ -63,6 +84,125 @@ namespace
       pos += replace.length();
     }
   }
+
+  //----------------------------------------------------------------------------
+  // Read the current resource usage of a process from /proc. Returns false if the information is not available.
+  bool ReadProcessResourceUsage(qint64 pid, double& cpuTimeSec, unsigned long long& residentMemoryBytes, int& numberOfThreads, int& numberOfOpenSockets)
+  {
+#if defined(__linux__)
+    if (pid <= 0)
+    {
+      return false;
+    }
+    std::string procPath = std::string("/proc/") + igsioCommon::ToString<qint64>(pid);
+
+    std::ifstream statFile(procPath + "/stat");
+    std::string stat;
+    if (!statFile.is_open() || !std::getline(statFile, stat))
+    {
+      return false;
+    }
+    // The executable name is in parentheses and may contain spaces, fields are counted after it
+    size_t commandEnd = stat.find_last_of(')');
+    if (commandEnd == std::string::npos)
+    {
+      return false;
+    }
+    std::istringstream statFields(stat.substr(commandEnd + 1));
+    std::vector<std::string> fields;
+    std::string field;
+    while (statFields >> field)
+    {
+      fields.push_back(field);
+    }
+    // Fields after the executable name start with field 3 (state) of proc(5)
+    const size_t utimeIndex = 14 - 3;
+    const size_t stimeIndex = 15 - 3;
+    const size_t numThreadsIndex = 20 - 3;
+    const size_t rssIndex = 24 - 3;
+    if (fields.size() <= rssIndex)
+    {
+      return false;
+    }
+    const double clockTicksPerSec = static_cast<double>(sysconf(_SC_CLK_TCK));
+    const unsigned long long pageSizeBytes = static_cast<unsigned long long>(sysconf(_SC_PAGESIZE));
+    try
+    {
+      cpuTimeSec = (std::stoull(fields[utimeIndex]) + std::stoull(fields[stimeIndex])) / clockTicksPerSec;
+      numberOfThreads = std::stoi(fields[numThreadsIndex]);
+      residentMemoryBytes = std::stoull(fields[rssIndex]) * pageSizeBytes;
+    }
+    catch (const std::exception&)
+    {
+      // Malformed stat line, e.g., the process exited while it was read
+      return false;
+    }
+
+    numberOfOpenSockets = 0;
+    std::string fdPath = procPath + "/fd";
+    DIR* fdDir = opendir(fdPath.c_str());
+    if (fdDir != nullptr)
+    {
+      struct dirent* entry = nullptr;
+      char linkTarget[256];
+      while ((entry = readdir(fdDir)) != nullptr)
+      {
+        std::string entryPath = fdPath + "/" + entry->d_name;
+        ssize_t linkLength = readlink(entryPath.c_str(), linkTarget, sizeof(linkTarget) - 1);
+        if (linkLength > 0 && std::string(linkTarget, linkLength).compare(0, 7, "socket:") == 0)
+        {
+          numberOfOpenSockets++;
+        }
+      }
+      closedir(fdDir);
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+  QString FormatUptime(double uptimeSec)
+  {
+    qint64 totalSec = static_cast<qint64>(uptimeSec);
+    qint64 days = totalSec / 86400;
+    QString time = QString("%1:%2:%3")
+                   .arg((totalSec % 86400) / 3600, 2, 10, QChar('0'))
+                   .arg((totalSec % 3600) / 60, 2, 10, QChar('0'))
+                   .arg(totalSec % 60, 2, 10, QChar('0'));
+    if (days > 0)
+    {
+      return QString("%1d %2").arg(days).arg(time);
+    }
+    return time;
+  }
+
+  //----------------------------------------------------------------------------
+  std::string ComputeContentHash(const std::string& content)
+  {
+    return QCryptographicHash::hash(QByteArray::fromRawData(content.data(), static_cast<int>(content.size())), QCryptographicHash::Sha256).toHex().toStdString();
+  }
+
+  //----------------------------------------------------------------------------
+  // Compressed content is zlib compressed (preceded by the 4-byte big-endian uncompressed size, as in qCompress) and base64 encoded,
+  // so that it can be sent in metadata and XML
+  std::string CompressContent(const std::string& content)
+  {
+    return qCompress(QByteArray::fromRawData(content.data(), static_cast<int>(content.size()))).toBase64().toStdString();
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus DecompressContent(const std::string& compressedContent, std::string& content)
+  {
+    QByteArray uncompressed = qUncompress(QByteArray::fromBase64(QByteArray::fromStdString(compressedContent)));
+    if (uncompressed.isEmpty() && !compressedContent.empty())
+    {
+      return PLUS_FAIL;
+    }
+    content = uncompressed.toStdString();
+    return PLUS_SUCCESS;
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -70,7 +210,19 @@ PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*
   : QMainWindow(parent, flags)
   , m_DeviceSetSelectorWidget(NULL)
   , m_RemoteControlServerPort(remoteControlServerPort)
+  , m_RemoteControlServer(new QTcpServer(this))
+  , m_RemoteControlServerConnectorPort(0)
   , m_RemoteControlServerConnectorProcessTimer(new QTimer())
+  , m_RemoteControlServerPendingEvents(0)
+  , m_RemoteControlServerPendingEventsTime(0.0)
+  , m_RemoteControlLogFlushTimer(new QTimer())
+  , m_RemoteControlLogFlushRequested(false)
+  , m_RemoteControlLogFlushInProgress(false)
+  , m_ServerResourceMonitorTimer(new QTimer())
+  , m_ServerWatchdogTimer(new QTimer())
+  , m_ConfigFileListCacheValid(false)
+  , m_ConfigFileWatcher(new QFileSystemWatcher(this))
+  , m_NextBatchCommandId(0)
 {
   m_RemoteControlServerCallbackCommand = vtkSmartPointer<vtkCallbackCommand>::New();
   m_RemoteControlServerCallbackCommand->SetCallback(PlusServerLauncherMainWindow::OnRemoteControlServerEventReceived);
@@ -149,10 +301,20 @@ PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*
   ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::ID, new QTableWidgetItem("ID"));
   ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::Name, new QTableWidgetItem("Name"));
   ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::Description, new QTableWidgetItem("Description"));
+  ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::Cpu, new QTableWidgetItem("CPU"));
+  ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::Memory, new QTableWidgetItem("Memory"));
+  ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::Threads, new QTableWidgetItem("Threads"));
+  ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::Sockets, new QTableWidgetItem("Sockets"));
+  ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::Uptime, new QTableWidgetItem("Uptime"));
   ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::Button, new QTableWidgetItem(" "));
   ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::ID, QHeaderView::Stretch);
   ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Name, QHeaderView::Interactive);
   ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Description, QHeaderView::Stretch);
+  ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Cpu, QHeaderView::ResizeToContents);
+  ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Memory, QHeaderView::ResizeToContents);
+  ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Threads, QHeaderView::ResizeToContents);
+  ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Sockets, QHeaderView::ResizeToContents);
+  ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Uptime, QHeaderView::ResizeToContents);
   ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Button, QHeaderView::ResizeToContents);
 
   // Log server host name, domain, and IP addresses
@@ -193,9 +355,26 @@ PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*
     m_RemoteControlServerConnector->AddObserver(igtlioConnector::ConnectedEvent, m_RemoteControlServerCallbackCommand);
     m_RemoteControlServerConnector->AddObserver(igtlioConnector::ClientConnectedEvent, m_RemoteControlServerCallbackCommand);
     m_RemoteControlServerConnector->AddObserver(igtlioConnector::ClientDisconnectedEvent, m_RemoteControlServerCallbackCommand);
-    m_RemoteControlServerConnector->SetTypeServer(m_RemoteControlServerPort);
+    // The connector only listens on a local port, the data of the clients is forwarded to it so that it is only processed when needed
+    QTcpServer portFinder;
+    if (portFinder.listen(QHostAddress::LocalHost, 0))
+    {
+      m_RemoteControlServerConnectorPort = portFinder.serverPort();
+      portFinder.close();
+    }
+    else
+    {
+      LOG_ERROR("Failed to find a free local port for the remote control connector: " << portFinder.errorString().toStdString());
+    }
+    m_RemoteControlServerConnector->SetTypeServer(m_RemoteControlServerConnectorPort);
     m_RemoteControlServerConnector->Start();
 
+    connect(m_RemoteControlServer, &QTcpServer::newConnection, this, &PlusServerLauncherMainWindow::OnRemoteControlClientConnected);
+    if (!m_RemoteControlServer->listen(QHostAddress::Any, m_RemoteControlServerPort))
+    {
+      LOG_ERROR("Failed to start remote control server at port " << m_RemoteControlServerPort << ": " << m_RemoteControlServer->errorString().toStdString());
+    }
+
     ui.label_networkDetails->setText(ipAddresses + ", port " + QString::number(m_RemoteControlServerPort));
 
     vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::MessageLogged, m_RemoteControlLogMessageCallbackCommand);
@@ -204,9 +383,26 @@ PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*
 
   connect(ui.checkBox_writePermission, &QCheckBox::clicked, this, &PlusServerLauncherMainWindow::OnWritePermissionClicked);
 
+  // The connector is only processed while the events of forwarded client data are expected
+  m_RemoteControlServerConnectorProcessTimer->setSingleShot(true);
+  m_RemoteControlServerConnectorProcessTimer->setTimerType(Qt::PreciseTimer);
+  m_RemoteControlServerConnectorProcessTimer->setInterval(REMOTE_CONTROL_SERVER_PENDING_PROCESS_INTERVAL_MSEC);
   connect(m_RemoteControlServerConnectorProcessTimer, &QTimer::timeout, this, &PlusServerLauncherMainWindow::OnTimerTimeout);
 
-  m_RemoteControlServerConnectorProcessTimer->start(5);
+  // Resource usage is only sampled while there are servers running
+  connect(m_ServerResourceMonitorTimer, &QTimer::timeout, this, &PlusServerLauncherMainWindow::OnServerResourceMonitorTimerTimeout);
+  m_ServerResourceMonitorTimer->setInterval(SERVER_RESOURCE_MONITOR_INTERVAL_MSEC);
+
+  // Liveness is only checked while there are servers with a heartbeat timeout
+  connect(m_ServerWatchdogTimer, &QTimer::timeout, this, &PlusServerLauncherMainWindow::OnServerWatchdogTimerTimeout);
+  m_ServerWatchdogTimer->setInterval(SERVER_WATCHDOG_INTERVAL_MSEC);
+
+  connect(m_ConfigFileWatcher, &QFileSystemWatcher::fileChanged, this, &PlusServerLauncherMainWindow::OnConfigFileChanged);
+  connect(m_ConfigFileWatcher, &QFileSystemWatcher::directoryChanged, this, &PlusServerLauncherMainWindow::OnConfigFileDirectoryChanged);
+
+  // Log messages are only flushed while there are subscribed clients
+  connect(m_RemoteControlLogFlushTimer, &QTimer::timeout, this, &PlusServerLauncherMainWindow::FlushRemoteControlLogQueue);
+  m_RemoteControlLogFlushTimer->setInterval(REMOTE_CONTROL_LOG_FLUSH_INTERVAL_MSEC);
 
   ReadConfiguration();
 }
@@ -221,6 +417,16 @@ PlusServerLauncherMainWindow::~PlusServerLauncherMainWindow()
     m_RemoteControlServerLogic->RemoveObserver(m_RemoteControlServerCallbackCommand);
   }
 
+  m_RemoteControlServer->close();
+  for (std::map<QTcpSocket*, RemoteControlConnection>::iterator connectionIt = m_RemoteControlConnections.begin(); connectionIt != m_RemoteControlConnections.end(); ++connectionIt)
+  {
+    connectionIt->second.Client->disconnect(this);
+    connectionIt->second.Connector->disconnect(this);
+    connectionIt->second.Client->abort();
+    connectionIt->second.Connector->abort();
+  }
+  m_RemoteControlConnections.clear();
+
   if (m_RemoteControlServerConnector)
   {
     m_RemoteControlServerConnector->RemoveObserver(m_RemoteControlServerCallbackCommand);
@@ -247,8 +453,16 @@ PlusServerLauncherMainWindow::~PlusServerLauncherMainWindow()
   delete m_RemoteControlServerConnectorProcessTimer;
   m_RemoteControlServerConnectorProcessTimer = nullptr;
 
+  delete m_RemoteControlLogFlushTimer;
+  m_RemoteControlLogFlushTimer = nullptr;
+
+  delete m_ServerResourceMonitorTimer;
+  m_ServerResourceMonitorTimer = nullptr;
+
+  delete m_ServerWatchdogTimer;
+  m_ServerWatchdogTimer = nullptr;
+
   disconnect(ui.checkBox_writePermission, &QCheckBox::clicked, this, &PlusServerLauncherMainWindow::OnWritePermissionClicked);
-  connect(m_RemoteControlServerConnectorProcessTimer, &QTimer::timeout, this, &PlusServerLauncherMainWindow::OnTimerTimeout);
 
   WriteConfiguration();
 }
@@ -269,6 +483,9 @@ PlusStatus PlusServerLauncherMainWindow::ReadConfiguration()
   applicationConfigurationRoot->GetScalarAttribute("CurrentTab", currentTab);
   ui.tabWidget->setCurrentIndex(currentTab);
 
+  const char* restartServersOnCrash = applicationConfigurationRoot->GetAttribute("RestartServersOnCrash");
+  ui.checkBox_restartOnCrash->setChecked(restartServersOnCrash != NULL && igsioCommon::IsEqualInsensitive(restartServersOnCrash, "TRUE"));
+
   return PLUS_SUCCESS;
 }
 
@@ -285,6 +502,7 @@ PlusStatus PlusServerLauncherMainWindow::WriteConfiguration()
   }
 
   applicationConfigurationRoot->SetIntAttribute("CurrentTab", ui.tabWidget->currentIndex());
+  applicationConfigurationRoot->SetAttribute("RestartServersOnCrash", ui.checkBox_restartOnCrash->isChecked() ? "TRUE" : "FALSE");
 
   // Write configuration to file
   igsioCommon::XML::PrintXML(applicationConfigurationFilePath.c_str(), applicationConfigurationRoot);
@@ -294,17 +512,50 @@ PlusStatus PlusServerLauncherMainWindow::WriteConfiguration()
 
 //-----------------------------------------------------------------------------
 bool PlusServerLauncherMainWindow::StartServer(const QString& configFilePath, int logLevel)
+{
+  QProcess* newServerProcess = LaunchServerProcess(configFilePath, logLevel);
+  if (newServerProcess == nullptr)
+  {
+    LOG_ERROR("Failed to start server process");
+    return false;
+  }
+  newServerProcess->waitForFinished(500);
+
+  // During waitForFinished an error signal may be emitted, which may delete newServerProcess,
+  // therefore we need to check if the current server process still exists
+  if (GetServerInfoFromProcess(newServerProcess).Process && newServerProcess->state() == QProcess::Running)
+  {
+    LOG_INFO("Server process started successfully");
+    return true;
+  }
+  else
+  {
+    LOG_ERROR("Failed to start server process");
+    return false;
+  }
+}
+
+//-----------------------------------------------------------------------------
+QProcess* PlusServerLauncherMainWindow::LaunchServerProcess(const QString& configFilePath, int logLevel)
 {
   QProcess* newServerProcess = new QProcess();
   ServerInfo newServerInfo(vtksys::SystemTools::GetFilenameName(configFilePath.toStdString()), newServerProcess);
   m_ServerInstances.push_back(newServerInfo);
 
   std::string plusServerExecutable = vtkPlusConfig::GetInstance()->GetPlusExecutablePath("PlusServer");
+  // The server executable can be replaced, e.g., by a stub server for testing the launcher without devices
+  std::string plusServerExecutableOverride;
+  if (vtksys::SystemTools::GetEnv("PLUS_SERVER_LAUNCHER_SERVER_EXECUTABLE", plusServerExecutableOverride) && !plusServerExecutableOverride.empty())
+  {
+    plusServerExecutable = plusServerExecutableOverride;
+  }
   std::string plusServerLocation = vtksys::SystemTools::GetFilenamePath(plusServerExecutable);
   newServerProcess->setWorkingDirectory(QString(plusServerLocation.c_str()));
 
   connect(newServerProcess, SIGNAL(error(QProcess::ProcessError)), this, SLOT(ErrorReceived(QProcess::ProcessError)));
   connect(newServerProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(ServerExecutableFinished(int, QProcess::ExitStatus)));
+  connect(newServerProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(StdOutMsgReceived()));
+  connect(newServerProcess, SIGNAL(readyReadStandardError()), this, SLOT(StdErrMsgReceived()));
 
   // PlusServerLauncher wants at least LOG_LEVEL_INFO to parse status information from the PlusServer executable
   // Un-requested log entries that are captured from the PlusServer executable are parsed and dropped from output
@@ -320,25 +571,35 @@ bool PlusServerLauncherMainWindow::StartServer(const QString& configFilePath, in
   QString cmdLine = QString("\"%1\" --config-file=\"%2\" --verbose=%3").arg(plusServerExecutable.c_str()).arg(configFilePath).arg(logLevelToPlusServer);
   LOG_INFO("Server process command line: " << cmdLine.toLatin1().constData());
   newServerProcess->start(cmdLine);
-  newServerProcess->waitForFinished(500);
 
-  // During waitForFinished an error signal may be emitted, which may delete newServerProcess,
-  // therefore we need to check if the current server process still exists
-  if (GetServerInfoFromID(newServerInfo.ID).Process &&
-    newServerProcess && newServerProcess->state() == QProcess::Running)
+  // If the executable could not be started then the error signal may have already removed the process
+  if (GetServerInfoFromProcess(newServerProcess).Process == nullptr)
   {
-    LOG_INFO("Server process started successfully");
-    connect(newServerInfo.Process, SIGNAL(readyReadStandardOutput()), this, SLOT(StdOutMsgReceived()));
-    connect(newServerInfo.Process, SIGNAL(readyReadStandardError()), this, SLOT(StdErrMsgReceived()));
-    ui.comboBox_LogLevel->setEnabled(false);
-    UpdateRemoteServerTable();
-    return true;
+    return nullptr;
   }
-  else
+  if (newServerProcess->state() == QProcess::NotRunning)
   {
-    LOG_ERROR("Failed to start server process");
-    return false;
+    RemoveServerProcess(newServerProcess);
+    newServerProcess->deleteLater();
+    return nullptr;
   }
+
+  ui.comboBox_LogLevel->setEnabled(false);
+  UpdateRemoteServerTable();
+  if (!m_ServerResourceMonitorTimer->isActive())
+  {
+    m_ServerResourceMonitorTimer->start();
+  }
+  std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(newServerInfo.Filename);
+  if (supervisionIt != m_ServerSupervisionStates.end())
+  {
+    supervisionIt->second.LastHeartbeatTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    if (supervisionIt->second.Policy.HeartbeatTimeoutSec > 0 && !m_ServerWatchdogTimer->isActive())
+    {
+      m_ServerWatchdogTimer->start();
+    }
+  }
+  return newServerProcess;
 }
 
 //----------------------------------------------------------------------------
@@ -399,8 +660,14 @@ PlusStatus PlusServerLauncherMainWindow::RemoveServerProcess(QProcess* process)
 bool PlusServerLauncherMainWindow::LocalStartServer()
 {
   std::string filename = vtksys::SystemTools::GetFilenameName(m_LocalConfigFile);
+
+  ServerSupervisionState supervisionState;
+  supervisionState.Policy.RestartOnCrash = ui.checkBox_restartOnCrash->isChecked();
+  m_ServerSupervisionStates[filename] = supervisionState;
+
   if (!StartServer(QString::fromStdString(filename)))
   {
+    m_ServerSupervisionStates.erase(filename);
     return false;
   }
 
@@ -422,32 +689,14 @@ void PlusServerLauncherMainWindow::UpdateRemoteServerTable()
   for (std::deque<ServerInfo>::iterator server = m_ServerInstances.begin(); server != m_ServerInstances.end(); ++server)
   {
     std::string filename = server->Filename;
-    std::string filePath = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(filename));
-
-    QFile file(QString::fromStdString(filePath));
-    QFileInfo fileInfo(QString::fromStdString(filePath));
-    QDomDocument doc;
+    const ConfigFileCacheEntry& configFile = GetConfigFileCacheEntry(vtksys::SystemTools::GetFilenameName(filename));
 
     QString name = QString::fromStdString(filename);
     QString description;
-
-    if (doc.setContent(&file))
+    if (!configFile.DeviceSetName.empty() || !configFile.DeviceSetDescription.empty())
     {
-      QDomElement docElem = doc.documentElement();
-
-      // Check if the root element is PlusConfiguration and contains a DeviceSet child
-      if (!docElem.tagName().compare("PlusConfiguration", Qt::CaseInsensitive))
-      {
-        // Add the name attribute to the first node named DeviceSet to the combo box
-        QDomNodeList list(doc.elementsByTagName("DeviceSet"));
-        if (list.count() > 0)
-        {
-          // If it has a DeviceSet children then use the first one
-          QDomElement elem = list.at(0).toElement();
-          name = elem.attribute("Name");
-          description = elem.attribute("Description");
-        }
-      }
+      name = QString::fromStdString(configFile.DeviceSetName);
+      description = QString::fromStdString(configFile.DeviceSetDescription);
     }
 
     int row = ui.serverTable->rowCount();
@@ -474,6 +723,90 @@ void PlusServerLauncherMainWindow::UpdateRemoteServerTable()
     ui.serverTable->setCellWidget(row, ServerTableColumns::Button, stopServerButton);
     connect(stopServerButton, SIGNAL(clicked()), this, SLOT(StopRemoteServerButtonClicked()));
   }
+
+  UpdateRemoteServerTableResourceUsage();
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::UpdateRemoteServerTableResourceUsage()
+{
+  double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  for (int row = 0; row < ui.serverTable->rowCount(); ++row)
+  {
+    QTableWidgetItem* idItem = ui.serverTable->item(row, ServerTableColumns::ID);
+    if (!idItem)
+    {
+      continue;
+    }
+    ServerInfo info = GetServerInfoFromID(idItem->data(Qt::UserRole).toString().toStdString());
+    if (!info.Process)
+    {
+      continue;
+    }
+
+    QStringList values;
+    if (info.ResourceUsage.Valid)
+    {
+      values << QString("%1%").arg(info.ResourceUsage.CpuPercent, 0, 'f', 1)
+             << QString("%1 MB").arg(info.ResourceUsage.ResidentMemoryBytes / (1024.0 * 1024.0), 0, 'f', 1)
+             << QString::number(info.ResourceUsage.NumberOfThreads)
+             << QString::number(info.ResourceUsage.NumberOfOpenSockets);
+    }
+    else
+    {
+      values << "-" << "-" << "-" << "-";
+    }
+    values << FormatUptime(currentTime - info.StartTime);
+
+    const int columns[] = { ServerTableColumns::Cpu, ServerTableColumns::Memory, ServerTableColumns::Threads, ServerTableColumns::Sockets, ServerTableColumns::Uptime };
+    for (int i = 0; i < values.size(); ++i)
+    {
+      QTableWidgetItem* item = ui.serverTable->item(row, columns[i]);
+      if (!item)
+      {
+        item = new QTableWidgetItem();
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        ui.serverTable->setItem(row, columns[i], item);
+      }
+      item->setText(values[i]);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnServerResourceMonitorTimerTimeout()
+{
+  if (m_ServerInstances.empty())
+  {
+    m_ServerResourceMonitorTimer->stop();
+    return;
+  }
+
+  for (std::deque<ServerInfo>::iterator serverIt = m_ServerInstances.begin(); serverIt != m_ServerInstances.end(); ++serverIt)
+  {
+    if (!serverIt->Process)
+    {
+      continue;
+    }
+    ServerResourceUsage& usage = serverIt->ResourceUsage;
+    double cpuTimeSec = 0.0;
+    double sampleTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    if (!ReadProcessResourceUsage(serverIt->Process->processId(), cpuTimeSec, usage.ResidentMemoryBytes, usage.NumberOfThreads, usage.NumberOfOpenSockets))
+    {
+      usage.Valid = false;
+      continue;
+    }
+    if (usage.CpuTimeSec >= 0 && sampleTime > usage.SampleTime)
+    {
+      usage.CpuPercent = 100.0 * (cpuTimeSec - usage.CpuTimeSec) / (sampleTime - usage.SampleTime);
+    }
+    usage.CpuTimeSec = cpuTimeSec;
+    usage.SampleTime = sampleTime;
+    usage.Valid = true;
+  }
+
+  UpdateRemoteServerTableResourceUsage();
 }
 
 //----------------------------------------------------------------------------
@@ -491,7 +824,17 @@ void PlusServerLauncherMainWindow::StopRemoteServerButtonClicked()
 //-----------------------------------------------------------------------------
 bool PlusServerLauncherMainWindow::StopServer(const QString& configFilePath)
 {
-  ServerInfo info = GetServerInfoFromFilename(vtksys::SystemTools::GetFilenameName(configFilePath.toStdString()));
+  std::string configFileName = vtksys::SystemTools::GetFilenameName(configFilePath.toStdString());
+
+  // Server is stopped on request, it must not be restarted (even if a restart is already scheduled)
+  std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(configFileName);
+  if (supervisionIt != m_ServerSupervisionStates.end())
+  {
+    StopServerLivenessProbe(supervisionIt->second);
+    m_ServerSupervisionStates.erase(supervisionIt);
+  }
+
+  ServerInfo info = GetServerInfoFromFilename(configFileName);
   QProcess* process = info.Process;
   if (!process)
   {
@@ -535,6 +878,7 @@ bool PlusServerLauncherMainWindow::StopServer(const QString& configFilePath)
 
   delete process;
   RemoveServerProcess(process);
+  UpdatePendingBatchCommands(configFileName, "Failed", "Server was stopped");
 
   if (m_RemoteControlServerConnector)
   {
@@ -570,6 +914,10 @@ void PlusServerLauncherMainWindow::ParseContent(const std::string& message)
   if (process)
   {
     ServerInfo info = GetServerInfoFromProcess(process);
+    if (!info.Ready && message.find("Server status: Server(s) are running.") != std::string::npos)
+    {
+      SetServerReady(process);
+    }
     if (info.Filename != vtksys::SystemTools::GetFilenameName(m_LocalConfigFile))
     {
       return;
@@ -595,6 +943,26 @@ void PlusServerLauncherMainWindow::ParseContent(const std::string& message)
   }
 }
 
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::SetServerReady(QProcess* process)
+{
+  for (std::deque<ServerInfo>::iterator serverIt = m_ServerInstances.begin(); serverIt != m_ServerInstances.end(); ++serverIt)
+  {
+    if (serverIt->Process == process)
+    {
+      if (serverIt->Ready)
+      {
+        return;
+      }
+      serverIt->Ready = true;
+      LOG_DEBUG("Server " << serverIt->ID << " is ready after " << vtkIGSIOAccurateTimer::GetSystemTime() - serverIt->StartTime << " sec");
+      std::string filename = serverIt->Filename;
+      UpdatePendingBatchCommands(filename, "Running", "");
+      return;
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 PlusStatus PlusServerLauncherMainWindow::SendCommand(igtlioCommandPointer command)
 {
@@ -798,6 +1166,12 @@ void PlusServerLauncherMainWindow::StdOutMsgReceived()
     return;
   }
   QByteArray strData = process->readAllStandardOutput();
+  std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(GetServerInfoFromProcess(process).Filename);
+  if (supervisionIt != m_ServerSupervisionStates.end())
+  {
+    // Any output means that the server is alive
+    supervisionIt->second.LastHeartbeatTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  }
   SendServerOutputToLogger(strData);
 }
 
@@ -810,6 +1184,11 @@ void PlusServerLauncherMainWindow::StdErrMsgReceived()
     return;
   }
   QByteArray strData = process->readAllStandardError();
+  std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(GetServerInfoFromProcess(process).Filename);
+  if (supervisionIt != m_ServerSupervisionStates.end())
+  {
+    supervisionIt->second.LastHeartbeatTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  }
   SendServerOutputToLogger(strData);
 }
 
@@ -848,15 +1227,20 @@ void PlusServerLauncherMainWindow::ErrorReceived(QProcess::ProcessError errorCod
     {
       m_DeviceSetSelectorWidget->SetConnectionSuccessful(false);
     }
+    if (errorCode == QProcess::FailedToStart && info.Process)
+    {
+      // The finished signal is not emitted for processes that could not be started
+      RemoveServerProcess(process);
+      process->deleteLater();
+      UpdatePendingBatchCommands(info.Filename, "Failed", "Failed to start server process");
+    }
   }
-
-
 }
 
 //-----------------------------------------------------------------------------
 void PlusServerLauncherMainWindow::ServerExecutableFinished(int returnCode, QProcess::ExitStatus status)
 {
-  if (returnCode == 0)
+  if (returnCode == 0 && status == QProcess::NormalExit)
   {
     LOG_INFO("Server process terminated.");
   }
@@ -871,77 +1255,390 @@ void PlusServerLauncherMainWindow::ServerExecutableFinished(int returnCode, QPro
   if (finishedProcess)
   {
     RemoveServerProcess(finishedProcess);
+    finishedProcess->deleteLater();
   }
 
-  if (strcmp(vtksys::SystemTools::GetFilenameName(m_LocalConfigFile).c_str(), configFileName.c_str()) == 0)
+  std::string restartReason;
+  std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(configFileName);
+  if (supervisionIt != m_ServerSupervisionStates.end())
   {
-    ConnectToDevicesByConfigFile("");
-    ui.comboBox_LogLevel->setEnabled(true);
-    m_DeviceSetSelectorWidget->SetConnectionSuccessful(false);
+    StopServerLivenessProbe(supervisionIt->second);
+    if (!supervisionIt->second.PendingRestartReason.empty())
+    {
+      // Stopped by the watchdog
+      restartReason = supervisionIt->second.PendingRestartReason;
+      supervisionIt->second.PendingRestartReason.clear();
+    }
+    else if (status == QProcess::CrashExit)
+    {
+      restartReason = "Crashed";
+    }
+    else if (returnCode != 0)
+    {
+      restartReason = "Failed";
+    }
+    else
+    {
+      // Server exited normally, nothing to supervise anymore
+      m_ServerSupervisionStates.erase(supervisionIt);
+    }
   }
 
   SendServerStoppedCommand(info);
-  UpdateRemoteServerTable();
-}
-
-//----------------------------------------------------------------------------
-void PlusServerLauncherMainWindow::LogLevelChanged()
-{
-  vtkPlusLogger::Instance()->SetLogLevel(ui.comboBox_LogLevel->currentData().toInt());
-}
-
-//---------------------------------------------------------------------------
-void PlusServerLauncherMainWindow::OnRemoteControlServerEventReceived(vtkObject* caller, unsigned long eventId, void* clientData, void* callData)
-{
-  PlusServerLauncherMainWindow* self = reinterpret_cast<PlusServerLauncherMainWindow*>(clientData);
-
-  igtlioLogicPointer logic = igtlioLogic::SafeDownCast(caller);
+  UpdatePendingBatchCommands(configFileName, "Failed", std::string("Server stopped before it was ready. Return code: ") + igsioCommon::ToString<int>(returnCode));
 
-  switch (eventId)
-  {
-  case igtlioConnector::ClientConnectedEvent:
-  {
-    self->LocalLog(vtkPlusLogger::LOG_LEVEL_INFO, "Client connected.");
-    break;
-  }
-  case igtlioConnector::ClientDisconnectedEvent:
+  if (!restartReason.empty())
   {
-    self->LocalLog(vtkPlusLogger::LOG_LEVEL_INFO, "Client disconnected.");
-    self->OnClientDisconnectedEvent();
-    break;
+    HandleUnexpectedServerExit(configFileName, restartReason, returnCode);
   }
-  case igtlioCommand::CommandReceivedEvent:
+
+  bool restartPending = m_ServerSupervisionStates.find(configFileName) != m_ServerSupervisionStates.end()
+                        && m_ServerSupervisionStates[configFileName].RestartPending;
+  if (strcmp(vtksys::SystemTools::GetFilenameName(m_LocalConfigFile).c_str(), configFileName.c_str()) == 0)
   {
-    if (logic == nullptr)
+    if (restartPending)
     {
-      return;
+      m_DeviceSetSelectorWidget->SetConnectionSuccessful(false);
+      m_DeviceSetSelectorWidget->SetConnectButtonText(QString("Restarting..."));
     }
-    igtlioCommandPointer command = reinterpret_cast<igtlioCommand*>(callData);
-    self->OnCommandReceivedEvent(command);
-    break;
-  }
-  case igtlioCommand::CommandResponseEvent:
-  {
-    if (logic == nullptr)
+    else
     {
-      return;
+      ConnectToDevicesByConfigFile("");
+      ui.comboBox_LogLevel->setEnabled(true);
+      m_DeviceSetSelectorWidget->SetConnectionSuccessful(false);
     }
-
-    break;
-  }
   }
+
+  UpdateRemoteServerTable();
 }
 
-//---------------------------------------------------------------------------
-void PlusServerLauncherMainWindow::OnClientDisconnectedEvent()
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::HandleUnexpectedServerExit(const std::string& filename, const std::string& reason, int returnCode)
 {
-  std::queue<int> unsubscribedClients;
+  std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(filename);
+  if (supervisionIt == m_ServerSupervisionStates.end() || supervisionIt->second.RestartPending)
+  {
+    return;
+  }
+  ServerSupervisionState& state = supervisionIt->second;
+  if (!state.Policy.RestartOnCrash)
+  {
+    m_ServerSupervisionStates.erase(supervisionIt);
+    return;
+  }
 
-  std::vector<int> connectedClientIds = m_RemoteControlServerConnector->GetClientIds();
-  for (std::set<int>::iterator subscribedClientIt = m_RemoteControlLogSubscribedClients.begin(); subscribedClientIt != m_RemoteControlLogSubscribedClients.end(); ++subscribedClientIt)
+  // Only the restarts within the window count towards the limit
+  double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  while (!state.RestartTimes.empty() && currentTime - state.RestartTimes.front() > state.Policy.RestartWindowSec)
   {
-    int clientId = *subscribedClientIt;
-    std::vector<int>::iterator connectedClientIt = (std::find_if(
+    state.RestartTimes.pop_front();
+  }
+
+  int restartCount = static_cast<int>(state.RestartTimes.size());
+  if (restartCount >= state.Policy.MaxRestarts)
+  {
+    LOG_ERROR("Server " << filename << " stopped (" << reason << ", return code: " << returnCode << ") and was already restarted "
+              << restartCount << " times in the last " << state.Policy.RestartWindowSec << " seconds. It will not be restarted again.");
+    SendServerRestartCommand(filename, "GaveUp", reason, restartCount, 0.0);
+    m_ServerSupervisionStates.erase(supervisionIt);
+    return;
+  }
+
+  // Exponential backoff
+  double restartDelaySec = std::min(state.Policy.InitialRestartDelaySec * std::pow(2.0, restartCount), state.Policy.MaxRestartDelaySec);
+  state.RestartTimes.push_back(currentTime);
+  state.RestartPending = true;
+
+  LOG_WARNING("Server " << filename << " stopped (" << reason << ", return code: " << returnCode << "). Restarting in " << restartDelaySec << " seconds.");
+  SendServerRestartCommand(filename, "Scheduled", reason, restartCount + 1, restartDelaySec);
+
+  std::string filenameToRestart = filename;
+  QTimer::singleShot(static_cast<int>(restartDelaySec * 1000), this, [this, filenameToRestart]()
+  {
+    RestartServer(filenameToRestart);
+  });
+}
+
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::RestartServer(const std::string& filename)
+{
+  std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(filename);
+  if (supervisionIt == m_ServerSupervisionStates.end() || !supervisionIt->second.RestartPending)
+  {
+    // Stopped on request while the restart was pending
+    return;
+  }
+  supervisionIt->second.RestartPending = false;
+  int restartCount = static_cast<int>(supervisionIt->second.RestartTimes.size());
+
+  if (!StartServer(QString::fromStdString(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(filename)), supervisionIt->second.LogLevel))
+  {
+    SendServerRestartCommand(filename, "Failed", "", restartCount, 0.0);
+    HandleUnexpectedServerExit(filename, "RestartFailed", 0);
+    return;
+  }
+
+  LOG_INFO("Server " << filename << " restarted");
+  SendServerRestartCommand(filename, "Restarted", "", restartCount, 0.0);
+  SendServerStartedCommand(GetServerInfoFromFilename(filename));
+}
+
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnServerWatchdogTimerTimeout()
+{
+  bool watchdogNeeded = false;
+  double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  for (std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.begin(); supervisionIt != m_ServerSupervisionStates.end(); ++supervisionIt)
+  {
+    ServerSupervisionState& state = supervisionIt->second;
+    if (state.Policy.HeartbeatTimeoutSec <= 0)
+    {
+      continue;
+    }
+    watchdogNeeded = true;
+
+    ServerInfo info = GetServerInfoFromFilename(supervisionIt->first);
+    if (!info.Process || state.RestartPending || !state.PendingRestartReason.empty())
+    {
+      continue;
+    }
+
+    if (currentTime - state.LastHeartbeatTime < state.Policy.HeartbeatTimeoutSec)
+    {
+      // Logged or answered recently, no need to probe. The probe connection is kept for the next probe.
+      state.ProbePending = false;
+      continue;
+    }
+
+    if (!state.ProbePending)
+    {
+      StartServerLivenessProbe(supervisionIt->first, state);
+      continue;
+    }
+
+    if (state.Probe && state.Probe->state() == QAbstractSocket::UnconnectedState)
+    {
+      // The connection was refused or closed, retry until the probe times out
+      ConnectServerLivenessProbe(supervisionIt->first, state);
+    }
+
+    if (currentTime - state.ProbeStartTime > state.Policy.HeartbeatTimeoutSec)
+    {
+      LOG_ERROR("Server " << supervisionIt->first << " has not responded for " << currentTime - state.LastHeartbeatTime << " seconds. Stopping it.");
+      StopServerLivenessProbe(state);
+      // ServerExecutableFinished takes care of the restart
+      state.PendingRestartReason = "Hung";
+      info.Process->kill();
+    }
+  }
+
+  if (!watchdogNeeded)
+  {
+    m_ServerWatchdogTimer->stop();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::StartServerLivenessProbe(const std::string& filename, ServerSupervisionState& state)
+{
+  state.ProbePending = true;
+  state.ProbeStartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  ++state.ProbeCommandId;
+
+  if (!ConnectServerLivenessProbe(filename, state))
+  {
+    // Nothing to probe, only log output can be used as heartbeat
+    state.ProbePending = false;
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool PlusServerLauncherMainWindow::ConnectServerLivenessProbe(const std::string& filename, ServerSupervisionState& state)
+{
+  // Use the port of the first OpenIGTLink server of the device set
+  std::vector<std::string> servers = igsioCommon::SplitStringIntoTokens(GetServersFromConfigFile(filename), ';', false);
+  int port = -1;
+  if (servers.empty() || igsioCommon::StringToInt<int>(servers[0].substr(servers[0].find_last_of(':') + 1).c_str(), port) != PLUS_SUCCESS)
+  {
+    return false;
+  }
+
+  if (!state.Probe)
+  {
+    // The connection is kept open for the following probes
+    state.Probe = new QTcpSocket(this);
+    std::string filenameToProbe = filename;
+    connect(state.Probe, &QTcpSocket::connected, this, [this, filenameToProbe]()
+    {
+      std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(filenameToProbe);
+      if (supervisionIt != m_ServerSupervisionStates.end() && supervisionIt->second.ProbePending)
+      {
+        SendServerLivenessProbeCommand(supervisionIt->second);
+      }
+    });
+    connect(state.Probe, &QTcpSocket::readyRead, this, [this, filenameToProbe]()
+    {
+      std::map<std::string, ServerSupervisionState>::iterator supervisionIt = m_ServerSupervisionStates.find(filenameToProbe);
+      if (supervisionIt != m_ServerSupervisionStates.end() && ReadServerLivenessProbeReplies(supervisionIt->second))
+      {
+        supervisionIt->second.LastHeartbeatTime = vtkIGSIOAccurateTimer::GetSystemTime();
+        supervisionIt->second.ProbePending = false;
+      }
+    });
+  }
+
+  if (state.Probe->state() == QAbstractSocket::ConnectedState)
+  {
+    SendServerLivenessProbeCommand(state);
+  }
+  else if (state.Probe->state() == QAbstractSocket::UnconnectedState)
+  {
+    // The command is sent when connected. The data of a previous connection is not valid any more.
+    state.ProbeBuffer.clear();
+    state.Probe->connectToHost(QHostAddress::LocalHost, port);
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::SendServerLivenessProbeCommand(ServerSupervisionState& state)
+{
+  // Connections are accepted by the operating system even if the server is hung, so a command is sent and only its reply counts as heartbeat
+  igtl::CommandMessage::Pointer commandMessage = igtl::CommandMessage::New();
+  commandMessage->SetHeaderVersion(IGTL_HEADER_VERSION_2);
+  commandMessage->SetDeviceName("PlusServerLauncher");
+  commandMessage->SetCommandId(state.ProbeCommandId);
+  commandMessage->SetCommandName("RequestChannelIds");
+  commandMessage->SetCommandContent("<Command Name=\"RequestChannelIds\" />");
+  commandMessage->Pack();
+  state.Probe->write(static_cast<const char*>(commandMessage->GetPackPointer()), commandMessage->GetPackSize());
+}
+
+//-----------------------------------------------------------------------------
+bool PlusServerLauncherMainWindow::ReadServerLivenessProbeReplies(ServerSupervisionState& state)
+{
+  state.ProbeBuffer.append(state.Probe->readAll());
+
+  // The server may also send the messages of its default client info on the connection, they are skipped
+  bool replyReceived = false;
+  while (state.ProbeBuffer.size() >= IGTL_HEADER_SIZE)
+  {
+    igtl::MessageHeader::Pointer header = igtl::MessageHeader::New();
+    header->InitPack();
+    memcpy(header->GetPackPointer(), state.ProbeBuffer.constData(), IGTL_HEADER_SIZE);
+    if (!(header->Unpack() & igtl::MessageHeader::UNPACK_HEADER))
+    {
+      LOG_WARNING("Invalid OpenIGTLink message received from the server, reconnecting the liveness probe");
+      state.ProbeBuffer.clear();
+      state.Probe->abort();
+      return false;
+    }
+
+    int messageSize = IGTL_HEADER_SIZE + static_cast<int>(header->GetBodySizeToRead());
+    if (state.ProbeBuffer.size() < messageSize)
+    {
+      // Wait for the rest of the message
+      break;
+    }
+
+    if (state.ProbePending && strcmp(header->GetDeviceType(), "RTS_COMMAND") == 0)
+    {
+      igtl::RTSCommandMessage::Pointer reply = igtl::RTSCommandMessage::New();
+      reply->SetMessageHeader(header);
+      reply->AllocatePack();
+      memcpy(reply->GetPackBodyPointer(), state.ProbeBuffer.constData() + IGTL_HEADER_SIZE, reply->GetPackBodySize());
+      if ((reply->Unpack(1) & igtl::MessageHeader::UNPACK_BODY) && reply->GetCommandId() == state.ProbeCommandId)
+      {
+        vtkSmartPointer<vtkXMLDataElement> replyElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(reply->GetCommandContent().c_str()));
+        replyReceived = replyReceived || (replyElement != nullptr);
+      }
+    }
+    state.ProbeBuffer.remove(0, messageSize);
+  }
+
+  return replyReceived;
+}
+
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::StopServerLivenessProbe(ServerSupervisionState& state)
+{
+  state.ProbePending = false;
+  state.ProbeBuffer.clear();
+  if (!state.Probe)
+  {
+    return;
+  }
+  state.Probe->abort();
+  state.Probe->deleteLater();
+  state.Probe = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::LogLevelChanged()
+{
+  vtkPlusLogger::Instance()->SetLogLevel(ui.comboBox_LogLevel->currentData().toInt());
+}
+
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnRemoteControlServerEventReceived(vtkObject* caller, unsigned long eventId, void* clientData, void* callData)
+{
+  PlusServerLauncherMainWindow* self = reinterpret_cast<PlusServerLauncherMainWindow*>(clientData);
+
+  igtlioLogicPointer logic = igtlioLogic::SafeDownCast(caller);
+
+  if ((eventId == igtlioConnector::ClientConnectedEvent || eventId == igtlioConnector::ClientDisconnectedEvent || eventId == igtlioCommand::CommandReceivedEvent)
+      && self->m_RemoteControlServerPendingEvents > 0)
+  {
+    --self->m_RemoteControlServerPendingEvents;
+  }
+
+  switch (eventId)
+  {
+  case igtlioConnector::ClientConnectedEvent:
+  {
+    self->LocalLog(vtkPlusLogger::LOG_LEVEL_INFO, "Client connected.");
+    break;
+  }
+  case igtlioConnector::ClientDisconnectedEvent:
+  {
+    self->LocalLog(vtkPlusLogger::LOG_LEVEL_INFO, "Client disconnected.");
+    self->OnClientDisconnectedEvent();
+    break;
+  }
+  case igtlioCommand::CommandReceivedEvent:
+  {
+    if (logic == nullptr)
+    {
+      return;
+    }
+    igtlioCommandPointer command = reinterpret_cast<igtlioCommand*>(callData);
+    self->OnCommandReceivedEvent(command);
+    break;
+  }
+  case igtlioCommand::CommandResponseEvent:
+  {
+    if (logic == nullptr)
+    {
+      return;
+    }
+
+    break;
+  }
+  }
+}
+
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnClientDisconnectedEvent()
+{
+  std::queue<int> unsubscribedClients;
+
+  std::vector<int> connectedClientIds = m_RemoteControlServerConnector->GetClientIds();
+
+  QMutexLocker lock(&m_RemoteControlLogMutex);
+  for (std::map<int, RemoteLogSubscription>::iterator subscribedClientIt = m_RemoteControlLogSubscribedClients.begin(); subscribedClientIt != m_RemoteControlLogSubscribedClients.end(); ++subscribedClientIt)
+  {
+    int clientId = subscribedClientIt->first;
+    std::vector<int>::iterator connectedClientIt = (std::find_if(
       connectedClientIds.begin(),
       connectedClientIds.end(),
       [this, clientId](const int& entry)
@@ -959,6 +1656,11 @@ void PlusServerLauncherMainWindow::OnClientDisconnectedEvent()
     m_RemoteControlLogSubscribedClients.erase(unsubscribedClients.front());
     unsubscribedClients.pop();
   }
+
+  if (m_RemoteControlLogSubscribedClients.empty())
+  {
+    m_RemoteControlLogFlushTimer->stop();
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -994,14 +1696,24 @@ void PlusServerLauncherMainWindow::OnCommandReceivedEvent(igtlioCommandPointer c
     RemoteStopServer(command);
     return;
   }
+  else if (igsioCommon::IsEqualInsensitive(name, "StartServers"))
+  {
+    RemoteStartServers(command);
+    return;
+  }
+  else if (igsioCommon::IsEqualInsensitive(name, "StopServers"))
+  {
+    RemoteStopServers(command);
+    return;
+  }
   else if (igsioCommon::IsEqualInsensitive(name, "LogSubscribe"))
   {
-    m_RemoteControlLogSubscribedClients.insert(command->GetClientId());
+    RemoteLogSubscribe(command);
     return;
   }
   else if (igsioCommon::IsEqualInsensitive(name, "LogUnsubscribe"))
   {
-    m_RemoteControlLogSubscribedClients.erase(command->GetClientId());
+    RemoteLogUnsubscribe(command);
     return;
   }
   else if (igsioCommon::IsEqualInsensitive(name, "GetRunningServers"))
@@ -1014,6 +1726,52 @@ void PlusServerLauncherMainWindow::OnCommandReceivedEvent(igtlioCommandPointer c
     GetConfigFileContents(command);
     return;
   }
+  else if (igsioCommon::IsEqualInsensitive(name, "GetServerResourceUsage"))
+  {
+    GetServerResourceUsage(command);
+    return;
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::RemoteLogSubscribe(igtlioCommandPointer command)
+{
+  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+
+  RemoteLogSubscription subscription;
+
+  std::string logLevelString;
+  if (command->GetCommandMetaDataElement("LogLevel", logLevelString, encodingType))
+  {
+    int logLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+    if (igsioCommon::StringToInt<int>(logLevelString.c_str(), logLevel) == PLUS_SUCCESS && logLevel > vtkPlusLogger::LOG_LEVEL_UNDEFINED)
+    {
+      subscription.LogLevel = logLevel;
+    }
+  }
+
+  std::string batchedString;
+  if (command->GetCommandMetaDataElement("Batched", batchedString, encodingType))
+  {
+    subscription.Batched = igsioCommon::IsEqualInsensitive(batchedString, "TRUE");
+  }
+
+  {
+    QMutexLocker lock(&m_RemoteControlLogMutex);
+    m_RemoteControlLogSubscribedClients[command->GetClientId()] = subscription;
+  }
+  m_RemoteControlLogFlushTimer->start();
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::RemoteLogUnsubscribe(igtlioCommandPointer command)
+{
+  QMutexLocker lock(&m_RemoteControlLogMutex);
+  m_RemoteControlLogSubscribedClients.erase(command->GetClientId());
+  if (m_RemoteControlLogSubscribedClients.empty())
+  {
+    m_RemoteControlLogFlushTimer->stop();
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -1096,8 +1854,11 @@ void PlusServerLauncherMainWindow::RemoteStartServer(igtlioCommandPointer comman
     logLevel = vtkPlusLogger::LOG_LEVEL_INFO;
   }
 
+  m_ServerSupervisionStates[vtksys::SystemTools::GetFilenameName(filename)] = GetSupervisionStateFromCommand(command, logLevel);
+
   if (!StartServer(QString::fromStdString(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(filename))), logLevel))
   {
+    m_ServerSupervisionStates.erase(vtksys::SystemTools::GetFilenameName(filename));
     command->SetSuccessful(false);
     command->SetErrorMessage("Failed to start server process.");
     if (SendCommandResponse(command) != PLUS_SUCCESS)
@@ -1129,34 +1890,342 @@ void PlusServerLauncherMainWindow::RemoteStartServer(igtlioCommandPointer comman
 }
 
 //----------------------------------------------------------------------------
-void PlusServerLauncherMainWindow::GetConfigFiles(igtlioCommandPointer command)
+PlusServerLauncherMainWindow::ServerSupervisionState PlusServerLauncherMainWindow::GetSupervisionStateFromCommand(igtlioCommandPointer command, int logLevel)
+{
+  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+
+  // Supervision policy, defaults to the launcher settings
+  ServerSupervisionState supervisionState;
+  supervisionState.LogLevel = logLevel;
+  supervisionState.Policy.RestartOnCrash = ui.checkBox_restartOnCrash->isChecked();
+  std::string policyString;
+  if (command->GetCommandMetaDataElement("RestartOnCrash", policyString, encodingType))
+  {
+    supervisionState.Policy.RestartOnCrash = igsioCommon::IsEqualInsensitive(policyString, "TRUE");
+  }
+  if (command->GetCommandMetaDataElement("MaxRestarts", policyString, encodingType))
+  {
+    igsioCommon::StringToInt<int>(policyString.c_str(), supervisionState.Policy.MaxRestarts);
+  }
+  if (command->GetCommandMetaDataElement("RestartWindowSec", policyString, encodingType))
+  {
+    igsioCommon::StringToDouble<double>(policyString.c_str(), supervisionState.Policy.RestartWindowSec);
+  }
+  if (command->GetCommandMetaDataElement("HeartbeatTimeoutSec", policyString, encodingType))
+  {
+    igsioCommon::StringToDouble<double>(policyString.c_str(), supervisionState.Policy.HeartbeatTimeoutSec);
+  }
+  return supervisionState;
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::RemoteStartServers(igtlioCommandPointer command)
+{
+  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+  std::string filenamesString;
+  if (!command->GetCommandMetaDataElement("ConfigFileNames", filenamesString, encodingType) || filenamesString.empty())
+  {
+    command->SetSuccessful(false);
+    command->SetErrorMessage("Config files not specified.");
+    if (SendCommandResponse(command) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+    return;
+  }
+  std::string separator = ";";
+  command->GetCommandMetaDataElement("Separator", separator, encodingType);
+  if (separator.empty())
+  {
+    separator = ";";
+  }
+
+  int logLevel = -1;
+  std::string logLevelString = "";
+  command->GetCommandMetaDataElement("LogLevel", logLevelString, encodingType);
+  if (igsioCommon::StringToInt<int>(logLevelString.c_str(), logLevel) == PLUS_FAIL)
+  {
+    logLevel = vtkPlusLogger::LOG_LEVEL_INFO;
+  }
+
+  double timeoutSec = BATCH_START_DEFAULT_TIMEOUT_SEC;
+  std::string timeoutString;
+  if (command->GetCommandMetaDataElement("TimeoutSec", timeoutString, encodingType))
+  {
+    igsioCommon::StringToDouble<double>(timeoutString.c_str(), timeoutSec);
+  }
+
+  PendingBatchCommand batchCommand;
+  batchCommand.Id = m_NextBatchCommandId++;
+  batchCommand.Command = command;
+  batchCommand.StartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+
+  // Launch all servers without waiting for each other, readiness is collected from the server outputs
+  std::vector<std::string> filenames = igsioCommon::SplitStringIntoTokens(filenamesString, separator.c_str()[0], false);
+  for (std::vector<std::string>::iterator filenameIt = filenames.begin(); filenameIt != filenames.end(); ++filenameIt)
+  {
+    std::string filename = vtksys::SystemTools::GetFilenameName(*filenameIt);
+    BatchServerResult result;
+    result.Status = "Starting";
+
+    ServerInfo info = GetServerInfoFromFilename(filename);
+    if (info.Process)
+    {
+      // Already started, possibly by a previous command that is still waiting for the server
+      result.Status = info.Ready ? "Running" : "Starting";
+    }
+    else
+    {
+      m_ServerSupervisionStates[filename] = GetSupervisionStateFromCommand(command, logLevel);
+      if (LaunchServerProcess(QString::fromStdString(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(filename)), logLevel) == nullptr)
+      {
+        m_ServerSupervisionStates.erase(filename);
+        result.Status = "Failed";
+        result.ErrorMessage = "Failed to start server process";
+      }
+    }
+    if (result.Status != "Starting")
+    {
+      result.ElapsedSec = vtkIGSIOAccurateTimer::GetSystemTime() - batchCommand.StartTime;
+    }
+    batchCommand.Results.push_back(std::make_pair(filename, result));
+  }
+
+  m_PendingBatchCommands.push_back(batchCommand);
+  int batchCommandId = batchCommand.Id;
+  QTimer::singleShot(static_cast<int>(timeoutSec * 1000), this, [this, batchCommandId]() { OnPendingBatchCommandTimeout(batchCommandId); });
+
+  // Respond right away if there is nothing to wait for
+  UpdatePendingBatchCommands("", "", "");
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::RemoteStopServers(igtlioCommandPointer command)
 {
-  vtkSmartPointer<vtkDirectory> dir = vtkSmartPointer<vtkDirectory>::New();
-  if (dir->Open(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationDirectory().c_str()) == 0)
+  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+  std::string filenamesString;
+  if (!command->GetCommandMetaDataElement("ConfigFileNames", filenamesString, encodingType) || filenamesString.empty())
   {
     command->SetSuccessful(false);
-    command->SetErrorMessage("Unable to open device set directory.");
+    command->SetErrorMessage("Config files not specified.");
     if (SendCommandResponse(command) != PLUS_SUCCESS)
     {
       LOG_ERROR("Command received but response could not be sent.");
     }
     return;
   }
+  std::string separator = ";";
+  command->GetCommandMetaDataElement("Separator", separator, encodingType);
+  if (separator.empty())
+  {
+    separator = ";";
+  }
 
-  std::stringstream ss;
-  for (vtkIdType i = 0; i < dir->GetNumberOfFiles(); ++i)
+  double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  std::vector<std::string> filenames = igsioCommon::SplitStringIntoTokens(filenamesString, separator.c_str()[0], false);
+  for (std::vector<std::string>::iterator filenameIt = filenames.begin(); filenameIt != filenames.end(); ++filenameIt)
+  {
+    *filenameIt = vtksys::SystemTools::GetFilenameName(*filenameIt);
+  }
+
+  // Request all servers to stop first, so that they shut down in parallel and StopServer only has to wait for them
+  for (std::vector<std::string>::iterator filenameIt = filenames.begin(); filenameIt != filenames.end(); ++filenameIt)
+  {
+    m_ServerSupervisionStates.erase(*filenameIt);
+    QProcess* process = GetServerInfoFromFilename(*filenameIt).Process;
+    if (process && process->state() == QProcess::Running)
+    {
+      process->terminate();
+    }
+  }
+
+  std::vector<std::pair<std::string, BatchServerResult> > results;
+  for (std::vector<std::string>::iterator filenameIt = filenames.begin(); filenameIt != filenames.end(); ++filenameIt)
+  {
+    BatchServerResult result;
+    if (GetServerInfoFromFilename(*filenameIt).Process == nullptr)
+    {
+      result.Status = "NotRunning";
+    }
+    else
+    {
+      bool stopped = StopServer(QString::fromStdString(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(*filenameIt)));
+      result.Status = stopped ? "Stopped" : "ForcedStop";
+    }
+    result.ElapsedSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+    results.push_back(std::make_pair(*filenameIt, result));
+  }
+
+  // Forced stop or not, the servers are down
+  SendBatchCommandResponse(command, results);
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::UpdatePendingBatchCommands(const std::string& filename, const std::string& status, const std::string& errorMessage)
+{
+  double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  std::list<PendingBatchCommand>::iterator batchIt = m_PendingBatchCommands.begin();
+  while (batchIt != m_PendingBatchCommands.end())
+  {
+    bool complete = true;
+    for (std::vector<std::pair<std::string, BatchServerResult> >::iterator resultIt = batchIt->Results.begin(); resultIt != batchIt->Results.end(); ++resultIt)
+    {
+      if (resultIt->second.Status != "Starting")
+      {
+        continue;
+      }
+      if (!filename.empty() && resultIt->first == filename)
+      {
+        resultIt->second.Status = status;
+        resultIt->second.ErrorMessage = errorMessage;
+        resultIt->second.ElapsedSec = currentTime - batchIt->StartTime;
+      }
+      else
+      {
+        complete = false;
+      }
+    }
+    if (!complete)
+    {
+      ++batchIt;
+      continue;
+    }
+    // Remove the command before responding, as sending the response may process further events
+    PendingBatchCommand batchCommand = *batchIt;
+    batchIt = m_PendingBatchCommands.erase(batchIt);
+    SendBatchCommandResponse(batchCommand.Command, batchCommand.Results);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnPendingBatchCommandTimeout(int batchCommandId)
+{
+  for (std::list<PendingBatchCommand>::iterator batchIt = m_PendingBatchCommands.begin(); batchIt != m_PendingBatchCommands.end(); ++batchIt)
   {
-    std::string file = dir->GetFile(i);
-    std::string ext = vtksys::SystemTools::GetFilenameLastExtension(file);
-    if (igsioCommon::IsEqualInsensitive(ext, ".xml"))
+    if (batchIt->Id != batchCommandId)
+    {
+      continue;
+    }
+    double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (std::vector<std::pair<std::string, BatchServerResult> >::iterator resultIt = batchIt->Results.begin(); resultIt != batchIt->Results.end(); ++resultIt)
+    {
+      if (resultIt->second.Status == "Starting")
+      {
+        // The server is left running, the client may stop it or check it later
+        resultIt->second.Status = "Timeout";
+        resultIt->second.ErrorMessage = "Server did not become ready in time";
+        resultIt->second.ElapsedSec = currentTime - batchIt->StartTime;
+      }
+    }
+    PendingBatchCommand batchCommand = *batchIt;
+    m_PendingBatchCommands.erase(batchIt);
+    SendBatchCommandResponse(batchCommand.Command, batchCommand.Results);
+    return;
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::SendBatchCommandResponse(igtlioCommandPointer command, const std::vector<std::pair<std::string, BatchServerResult> >& results)
+{
+  bool successful = true;
+  std::stringstream errorMessage;
+  vtkSmartPointer<vtkXMLDataElement> responseXML = vtkSmartPointer<vtkXMLDataElement>::New();
+  responseXML->SetName("Command");
+  for (std::vector<std::pair<std::string, BatchServerResult> >::const_iterator resultIt = results.begin(); resultIt != results.end(); ++resultIt)
+  {
+    const BatchServerResult& result = resultIt->second;
+    vtkSmartPointer<vtkXMLDataElement> resultXML = vtkSmartPointer<vtkXMLDataElement>::New();
+    resultXML->SetName("Result");
+    resultXML->SetAttribute("ConfigFileName", resultIt->first.c_str());
+    resultXML->SetAttribute("ServerID", vtksys::SystemTools::GetFilenameWithoutExtension(resultIt->first).c_str());
+    resultXML->SetAttribute("Status", result.Status.c_str());
+    resultXML->SetDoubleAttribute("ElapsedSec", result.ElapsedSec);
+    if (result.Status == "Running")
+    {
+      resultXML->SetAttribute("Servers", GetServersFromConfigFile(resultIt->first).c_str());
+    }
+    if (!result.ErrorMessage.empty())
+    {
+      resultXML->SetAttribute("ErrorMessage", result.ErrorMessage.c_str());
+    }
+    responseXML->AddNestedElement(resultXML);
+    if (result.Status == "Failed" || result.Status == "Timeout")
     {
-      ss << file << ";";
+      // List the servers that failed, so that the client does not have to parse the results to tell which ones
+      errorMessage << (successful ? "Failed servers: " : ", ") << vtksys::SystemTools::GetFilenameWithoutExtension(resultIt->first) << " (" << result.Status;
+      if (!result.ErrorMessage.empty())
+      {
+        errorMessage << ": " << result.ErrorMessage;
+      }
+      errorMessage << ")";
+      successful = false;
     }
   }
+  std::stringstream responseSS;
+  vtkXMLUtilities::FlattenElement(responseXML, responseSS);
+
+  command->SetSuccessful(successful);
+  if (!successful)
+  {
+    command->SetErrorMessage(errorMessage.str());
+  }
+  command->SetResponseContent(responseSS.str());
+  if (SendCommandResponse(command) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Command received but response could not be sent.");
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::GetConfigFiles(igtlioCommandPointer command)
+{
+  UpdateConfigFileCacheDirectory();
+  if (!m_ConfigFileListCacheValid)
+  {
+    vtkSmartPointer<vtkDirectory> dir = vtkSmartPointer<vtkDirectory>::New();
+    if (dir->Open(m_ConfigFileCacheDirectory.c_str()) == 0)
+    {
+      command->SetSuccessful(false);
+      command->SetErrorMessage("Unable to open device set directory.");
+      if (SendCommandResponse(command) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Command received but response could not be sent.");
+      }
+      return;
+    }
+
+    std::stringstream ss;
+    for (vtkIdType i = 0; i < dir->GetNumberOfFiles(); ++i)
+    {
+      std::string file = dir->GetFile(i);
+      std::string ext = vtksys::SystemTools::GetFilenameLastExtension(file);
+      if (igsioCommon::IsEqualInsensitive(ext, ".xml"))
+      {
+        ss << file << ";";
+      }
+    }
+    m_ConfigFileListCache = ss.str();
+    m_ConfigFileListCacheValid = true;
+  }
 
   command->SetSuccessful(true);
-  command->SetResponseMetaDataElement("ConfigFiles", ss.str());
+  command->SetResponseMetaDataElement("ConfigFiles", m_ConfigFileListCache);
   command->SetResponseMetaDataElement("Separator", ";");
+
+  // Hashes allow clients to find out which files have to be synchronized without downloading them
+  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+  std::string includeHashes;
+  if (command->GetCommandMetaDataElement("IncludeHashes", includeHashes, encodingType) && igsioCommon::IsEqualInsensitive(includeHashes, "TRUE"))
+  {
+    std::string configFileList = m_ConfigFileListCache;
+    std::stringstream hashes;
+    std::vector<std::string> configFiles = igsioCommon::SplitStringIntoTokens(configFileList, ';', false);
+    for (std::vector<std::string>::iterator configFileIt = configFiles.begin(); configFileIt != configFiles.end(); ++configFileIt)
+    {
+      hashes << GetConfigFileCacheEntry(*configFileIt).FileHash << ";";
+    }
+    command->SetResponseMetaDataElement("ConfigFileHashes", hashes.str());
+  }
   if (SendCommandResponse(command) != PLUS_SUCCESS)
   {
     LOG_ERROR("Command received but response could not be sent.");
@@ -1184,7 +2253,7 @@ void PlusServerLauncherMainWindow::GetRunningServers(igtlioCommandPointer comman
 }
 
 //----------------------------------------------------------------------------
-void PlusServerLauncherMainWindow::GetConfigFileContents(igtlioCommandPointer command)
+void PlusServerLauncherMainWindow::GetServerResourceUsage(igtlioCommandPointer command)
 {
   IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
   std::string serverIdsString;
@@ -1192,15 +2261,24 @@ void PlusServerLauncherMainWindow::GetConfigFileContents(igtlioCommandPointer co
   std::string separator;
   command->GetCommandMetaDataElement("Separator", separator, encodingType);
 
+  // If no servers are specified then report all running servers
   std::vector<std::string> serverIds;
   if (!separator.empty() && !serverIdsString.empty())
   {
     serverIds = igsioCommon::SplitStringIntoTokens(serverIdsString, separator.c_str()[0], false);
   }
+  else
+  {
+    for (std::deque<ServerInfo>::iterator serverIt = m_ServerInstances.begin(); serverIt != m_ServerInstances.end(); ++serverIt)
+    {
+      serverIds.push_back(serverIt->ID);
+    }
+  }
 
   vtkSmartPointer<vtkXMLDataElement> rootElement = vtkSmartPointer<vtkXMLDataElement>::New();
   rootElement->SetName("Command");
 
+  double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
   for (std::string serverId : serverIds)
   {
     ServerInfo info = GetServerInfoFromID(serverId);
@@ -1209,18 +2287,90 @@ void PlusServerLauncherMainWindow::GetConfigFileContents(igtlioCommandPointer co
       continue;
     }
 
-    vtkSmartPointer<vtkXMLDataElement> configFileElement = vtkSmartPointer<vtkXMLDataElement>::New();
-    configFileElement->SetName(serverId.c_str());
+    vtkSmartPointer<vtkXMLDataElement> serverElement = vtkSmartPointer<vtkXMLDataElement>::New();
+    serverElement->SetName("Server");
+    serverElement->SetAttribute("ServerID", info.ID.c_str());
+    serverElement->SetAttribute("ConfigFileName", info.Filename.c_str());
+    serverElement->SetDoubleAttribute("UptimeSec", currentTime - info.StartTime);
+    if (info.ResourceUsage.Valid)
+    {
+      serverElement->SetDoubleAttribute("CpuPercent", info.ResourceUsage.CpuPercent);
+      serverElement->SetAttribute("ResidentMemoryBytes", igsioCommon::ToString<unsigned long long>(info.ResourceUsage.ResidentMemoryBytes).c_str());
+      serverElement->SetIntAttribute("NumberOfThreads", info.ResourceUsage.NumberOfThreads);
+      serverElement->SetIntAttribute("NumberOfOpenSockets", info.ResourceUsage.NumberOfOpenSockets);
+    }
+    rootElement->AddNestedElement(serverElement);
+  }
+
+  std::stringstream ss;
+  vtkXMLUtilities::FlattenElement(rootElement, ss);
+  command->SetResponseContent(ss.str());
+  command->SetSuccessful(true);
+  if (SendCommandResponse(command) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Command received but response could not be sent.");
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::GetConfigFileContents(igtlioCommandPointer command)
+{
+  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+  std::string serverIdsString;
+  command->GetCommandMetaDataElement("ServerIDs", serverIdsString, encodingType);
+  std::string separator;
+  command->GetCommandMetaDataElement("Separator", separator, encodingType);
 
-    std::string filePath = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(info.Filename));
-    vtkSmartPointer<vtkXMLDataElement> contentElement = vtkXMLUtilities::ReadElementFromFile(filePath.c_str());
+  std::string knownHashesString;
+  command->GetCommandMetaDataElement("KnownHashes", knownHashesString, encodingType);
+  std::string compressionString;
+  command->GetCommandMetaDataElement("Compression", compressionString, encodingType);
+  bool compression = igsioCommon::IsEqualInsensitive(compressionString, "TRUE");
 
-    configFileElement->AddNestedElement(contentElement);
-    rootElement->AddNestedElement(configFileElement);
+  std::vector<std::string> serverIds;
+  std::vector<std::string> knownHashes;
+  if (!separator.empty() && !serverIdsString.empty())
+  {
+    serverIds = igsioCommon::SplitStringIntoTokens(serverIdsString, separator.c_str()[0], false);
+    knownHashes = igsioCommon::SplitStringIntoTokens(knownHashesString, separator.c_str()[0], true);
   }
 
+  // The cached content is already flattened, so the response is assembled without building an XML tree
   std::stringstream ss;
-  vtkXMLUtilities::FlattenElement(rootElement, ss);
+  ss << "<Command>" << std::endl;
+  for (size_t serverIndex = 0; serverIndex < serverIds.size(); ++serverIndex)
+  {
+    const std::string& serverId = serverIds[serverIndex];
+    ServerInfo info = GetServerInfoFromID(serverId);
+    if (!info.Process)
+    {
+      continue;
+    }
+
+    ConfigFileCacheEntry& configFile = GetConfigFileCacheEntry(vtksys::SystemTools::GetFilenameName(info.Filename));
+    if (!configFile.Valid)
+    {
+      ss << "<" << serverId << "/>" << std::endl;
+      continue;
+    }
+    if (serverIndex < knownHashes.size() && knownHashes[serverIndex] == configFile.ContentHash)
+    {
+      // The client already has this version of the file
+      ss << "<" << serverId << " Hash=\"" << configFile.ContentHash << "\" Unchanged=\"TRUE\"/>" << std::endl;
+      continue;
+    }
+    if (compression)
+    {
+      if (configFile.CompressedContent.empty())
+      {
+        configFile.CompressedContent = CompressContent(configFile.Content);
+      }
+      ss << "<" << serverId << " Hash=\"" << configFile.ContentHash << "\" Encoding=\"Compressed\">" << configFile.CompressedContent << "</" << serverId << ">" << std::endl;
+      continue;
+    }
+    ss << "<" << serverId << " Hash=\"" << configFile.ContentHash << "\">" << std::endl << configFile.Content << "</" << serverId << ">" << std::endl;
+  }
+  ss << "</Command>" << std::endl;
   command->SetResponseContent(ss.str());
   command->SetSuccessful(true);
   if (SendCommandResponse(command) != PLUS_SUCCESS)
@@ -1245,6 +2395,10 @@ void PlusServerLauncherMainWindow::AddOrUpdateConfigFile(igtlioCommandPointer co
   bool hasFilename = command->GetCommandMetaDataElement("ConfigFileName", configFile, encodingType);
   std::string configFileContent;
   bool hasFileContent = command->GetCommandMetaDataElement("ConfigFileContent", configFileContent, encodingType);
+  std::string configFileContentHash;
+  bool hasFileContentHash = command->GetCommandMetaDataElement("ConfigFileContentHash", configFileContentHash, encodingType);
+  std::string configFileContentEncoding;
+  command->GetCommandMetaDataElement("ConfigFileContentEncoding", configFileContentEncoding, encodingType);
 
   // Check write permissions
   if (!ui.checkBox_writePermission->isChecked())
@@ -1252,28 +2406,85 @@ void PlusServerLauncherMainWindow::AddOrUpdateConfigFile(igtlioCommandPointer co
     LOG_INFO("Request from client to add config file, but write permissions not enabled. File: " << (hasFilename ? configFile : "unknown"));
 
     command->SetSuccessful(false);
-    command->SetErrorMessage("Write permission denied.");
+    command->SetErrorMessage("Write permission denied.");
+    if (SendCommandResponse(command) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+
+    return;
+  }
+
+  if (!hasFilename || (!hasFileContent && !hasFileContentHash))
+  {
+    command->SetSuccessful(false);
+    command->SetErrorMessage("Required metadata \'ConfigFileName\' and/or \'ConfigFileContent\' missing.");
+    if (SendCommandResponse(command) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+    return;
+  }
+
+  // Strip any path sent over
+  configFile = vtksys::SystemTools::GetFilenameName(configFile);
+
+  // If the file is already up to date then there is nothing to write
+  if (hasFileContentHash && vtksys::SystemTools::FileExists(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile), true)
+      && igsioCommon::IsEqualInsensitive(GetConfigFileCacheEntry(configFile).FileHash, configFileContentHash))
+  {
+    LOG_DEBUG("Config file " << configFile << " is unchanged, not written.");
+    command->SetSuccessful(true);
+    command->SetResponseMetaDataElement("ConfigFileName", configFile);
+    command->SetResponseMetaDataElement("ConfigFileContentHash", GetConfigFileCacheEntry(configFile).FileHash);
+    command->SetResponseMetaDataElement("Unchanged", "TRUE");
+    if (SendCommandResponse(command) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+    return;
+  }
+
+  if (!hasFileContent)
+  {
+    // Only the hash was sent to check if the file has to be transferred
+    command->SetSuccessful(false);
+    command->SetErrorMessage("Config file content required.");
+    command->SetResponseMetaDataElement("ConfigFileName", configFile);
+    command->SetResponseMetaDataElement("ContentRequired", "TRUE");
     if (SendCommandResponse(command) != PLUS_SUCCESS)
     {
       LOG_ERROR("Command received but response could not be sent.");
     }
-
     return;
   }
 
-  if (!hasFilename || !hasFileContent)
+  if (igsioCommon::IsEqualInsensitive(configFileContentEncoding, "Compressed"))
+  {
+    std::string compressedContent = configFileContent;
+    if (DecompressContent(compressedContent, configFileContent) != PLUS_SUCCESS)
+    {
+      command->SetSuccessful(false);
+      command->SetErrorMessage("Unable to decompress config file content.");
+      if (SendCommandResponse(command) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Command received but response could not be sent.");
+      }
+      return;
+    }
+  }
+
+  std::string contentHash = ComputeContentHash(configFileContent);
+  if (hasFileContentHash && !igsioCommon::IsEqualInsensitive(contentHash, configFileContentHash))
   {
     command->SetSuccessful(false);
-    command->SetErrorMessage("Required metadata \'ConfigFileName\' and/or \'ConfigFileContent\' missing.");
+    command->SetErrorMessage("Config file content does not match \'ConfigFileContentHash\'.");
     if (SendCommandResponse(command) != PLUS_SUCCESS)
     {
       LOG_ERROR("Command received but response could not be sent.");
     }
     return;
   }
-
-  // Strip any path sent over
-  configFile = vtksys::SystemTools::GetFilenameName(configFile);
   // If filename already exists, check overwrite permissions
   if (vtksys::SystemTools::FileExists(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile)))
   {
@@ -1297,7 +2508,7 @@ void PlusServerLauncherMainWindow::AddOrUpdateConfigFile(igtlioCommandPointer co
     }
   }
 
-  std::fstream file(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile), std::fstream::out);
+  std::fstream file(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile), std::fstream::out | std::fstream::binary);
   if (!file.is_open())
   {
     if (vtksys::SystemTools::FileExists(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile) + ".bak"))
@@ -1323,8 +2534,12 @@ void PlusServerLauncherMainWindow::AddOrUpdateConfigFile(igtlioCommandPointer co
   file << configFileContent;
   file.close();
 
+  // The file watcher would notice the change as well, but the next request may arrive before that
+  InvalidateConfigFileCacheEntry(configFile);
+
   command->SetSuccessful(true);
   command->SetResponseMetaDataElement("ConfigFileName", configFile);
+  command->SetResponseMetaDataElement("ConfigFileContentHash", contentHash);
   if (SendCommandResponse(command) != PLUS_SUCCESS)
   {
     LOG_ERROR("Command received but response could not be sent.");
@@ -1345,9 +2560,195 @@ void PlusServerLauncherMainWindow::OnWritePermissionClicked()
 //----------------------------------------------------------------------------
 void PlusServerLauncherMainWindow::OnTimerTimeout()
 {
-  if (m_RemoteControlServerConnector != nullptr)
+  if (m_RemoteControlServerConnector == nullptr)
+  {
+    return;
+  }
+
+  m_RemoteControlServerConnector->PeriodicProcess();
+
+  if (m_RemoteControlServerPendingEvents <= 0)
+  {
+    return;
+  }
+  if (vtkIGSIOAccurateTimer::GetSystemTime() - m_RemoteControlServerPendingEventsTime > REMOTE_CONTROL_SERVER_PENDING_EVENT_TIMEOUT_MSEC / 1000.0)
+  {
+    LOG_WARNING("Remote control connector did not report " << m_RemoteControlServerPendingEvents << " expected event(s), stop waiting for them");
+    m_RemoteControlServerPendingEvents = 0;
+    return;
+  }
+  m_RemoteControlServerConnectorProcessTimer->start();
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::ExpectRemoteControlServerEvents(int numberOfEvents)
+{
+  // The connector receives on its own thread, the events are reported by PeriodicProcess shortly after the data is forwarded
+  m_RemoteControlServerPendingEvents += numberOfEvents;
+  m_RemoteControlServerPendingEventsTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  if (!m_RemoteControlServerConnectorProcessTimer->isActive())
+  {
+    m_RemoteControlServerConnectorProcessTimer->start();
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnRemoteControlClientConnected()
+{
+  while (m_RemoteControlServer->hasPendingConnections())
+  {
+    QTcpSocket* client = m_RemoteControlServer->nextPendingConnection();
+    if (m_RemoteControlServerConnectorPort == 0)
+    {
+      client->abort();
+      client->deleteLater();
+      continue;
+    }
+
+    RemoteControlConnection& connection = m_RemoteControlConnections[client];
+    connection.Client = client;
+    connection.Connector = new QTcpSocket(this);
+    connection.Connector->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    // The sockets delete themselves once they are disconnected
+    connect(client, &QAbstractSocket::disconnected, client, &QObject::deleteLater);
+    connect(connection.Connector, &QAbstractSocket::disconnected, connection.Connector, &QObject::deleteLater);
+
+    connect(connection.Connector, &QAbstractSocket::connected, this, [this, client]()
+    {
+      // The connector reports the new client, data that the client sent meanwhile is forwarded now
+      m_RemoteControlConnections[client].ConnectorConnected = true;
+      ExpectRemoteControlServerEvents(1);
+      ForwardRemoteControlClientData(client);
+    });
+    connect(client, &QIODevice::readyRead, this, [this, client]()
+    {
+      ForwardRemoteControlClientData(client);
+    });
+    connect(connection.Connector, &QIODevice::readyRead, this, [this, client]()
+    {
+      std::map<QTcpSocket*, RemoteControlConnection>::iterator connectionIt = m_RemoteControlConnections.find(client);
+      if (connectionIt != m_RemoteControlConnections.end())
+      {
+        client->write(connectionIt->second.Connector->readAll());
+      }
+    });
+    // Also closes the connection if the connector cannot be connected
+    connect(client, &QAbstractSocket::stateChanged, this, [this, client](QAbstractSocket::SocketState socketState)
+    {
+      if (socketState == QAbstractSocket::UnconnectedState)
+      {
+        CloseRemoteControlConnection(client);
+      }
+    });
+    connect(connection.Connector, &QAbstractSocket::stateChanged, this, [this, client](QAbstractSocket::SocketState socketState)
+    {
+      if (socketState == QAbstractSocket::UnconnectedState)
+      {
+        CloseRemoteControlConnection(client);
+      }
+    });
+
+    connection.Connector->connectToHost(QHostAddress::LocalHost, m_RemoteControlServerConnectorPort);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::ForwardRemoteControlClientData(QTcpSocket* client)
+{
+  std::map<QTcpSocket*, RemoteControlConnection>::iterator connectionIt = m_RemoteControlConnections.find(client);
+  if (connectionIt == m_RemoteControlConnections.end())
+  {
+    return;
+  }
+  RemoteControlConnection& connection = connectionIt->second;
+  if (connection.Connector->state() != QAbstractSocket::ConnectedState)
+  {
+    // The data is kept in the client socket until the connector connection is established
+    return;
+  }
+
+  QByteArray data = client->readAll();
+  if (data.isEmpty())
+  {
+    return;
+  }
+  connection.Connector->write(data);
+  connection.ClientBuffer.append(data);
+
+  int numberOfCommands = ReadRemoteControlCommandMessages(connection.ClientBuffer);
+  if (numberOfCommands > 0)
+  {
+    ExpectRemoteControlServerEvents(numberOfCommands);
+  }
+}
+
+//----------------------------------------------------------------------------
+int PlusServerLauncherMainWindow::ReadRemoteControlCommandMessages(QByteArray& buffer)
+{
+  int numberOfCommands = 0;
+  while (buffer.size() >= IGTL_HEADER_SIZE)
+  {
+    igtl::MessageHeader::Pointer header = igtl::MessageHeader::New();
+    header->InitPack();
+    memcpy(header->GetPackPointer(), buffer.constData(), IGTL_HEADER_SIZE);
+    if (!(header->Unpack() & igtl::MessageHeader::UNPACK_HEADER))
+    {
+      // The connector drops the client, nothing more is expected from it
+      LOG_WARNING("Invalid OpenIGTLink message received from a remote control client");
+      buffer.clear();
+      break;
+    }
+
+    int messageSize = IGTL_HEADER_SIZE + static_cast<int>(header->GetBodySizeToRead());
+    if (buffer.size() < messageSize)
+    {
+      // Wait for the rest of the message
+      break;
+    }
+
+    if (strcmp(header->GetDeviceType(), "COMMAND") == 0)
+    {
+      ++numberOfCommands;
+    }
+    buffer.remove(0, messageSize);
+  }
+  return numberOfCommands;
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::CloseRemoteControlConnection(QTcpSocket* client)
+{
+  std::map<QTcpSocket*, RemoteControlConnection>::iterator connectionIt = m_RemoteControlConnections.find(client);
+  if (connectionIt == m_RemoteControlConnections.end())
+  {
+    return;
+  }
+  RemoteControlConnection connection = connectionIt->second;
+  m_RemoteControlConnections.erase(connectionIt);
+
+  connection.Client->disconnect(this);
+  connection.Connector->disconnect(this);
+  if (connection.ConnectorConnected)
+  {
+    // The connector reports the disconnection of the client
+    ExpectRemoteControlServerEvents(1);
+  }
+
+  // Pending data is still sent, the sockets are deleted when disconnected
+  QTcpSocket* sockets[] = { connection.Client, connection.Connector };
+  for (QTcpSocket* socket : sockets)
   {
-    m_RemoteControlServerConnector->PeriodicProcess();
+    if (socket->state() == QAbstractSocket::ConnectedState)
+    {
+      socket->disconnectFromHost();
+    }
+    else
+    {
+      socket->abort();
+      socket->deleteLater();
+    }
   }
 }
 
@@ -1381,6 +2782,49 @@ void PlusServerLauncherMainWindow::SendServerStartedCommand(ServerInfo serverInf
   SendCommand(serverStartedCommand);
 }
 
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::SendServerRestartCommand(const std::string& filename, const std::string& status, const std::string& reason, int restartCount, double restartDelaySec)
+{
+  if (!m_RemoteControlServerConnector)
+  {
+    return;
+  }
+
+  LOG_TRACE("Sending server restart command");
+
+  std::string serverId = vtksys::SystemTools::GetFilenameWithoutExtension(filename);
+  std::string restartCountString = igsioCommon::ToString<int>(restartCount);
+  std::string restartDelayString = igsioCommon::ToString<double>(restartDelaySec);
+
+  vtkSmartPointer<vtkXMLDataElement> commandElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  commandElement->SetName("Command");
+  vtkSmartPointer<vtkXMLDataElement> serverRestartElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  serverRestartElement->SetName("ServerRestart");
+  serverRestartElement->SetAttribute("ConfigFileName", filename.c_str());
+  serverRestartElement->SetAttribute("ServerID", serverId.c_str());
+  serverRestartElement->SetAttribute("Status", status.c_str());
+  serverRestartElement->SetAttribute("Reason", reason.c_str());
+  serverRestartElement->SetAttribute("RestartCount", restartCountString.c_str());
+  serverRestartElement->SetAttribute("RestartDelaySec", restartDelayString.c_str());
+  commandElement->AddNestedElement(serverRestartElement);
+
+  std::stringstream commandStream;
+  vtkXMLUtilities::FlattenElement(commandElement, commandStream);
+
+  igtlioCommandPointer serverRestartCommand = igtlioCommandPointer::New();
+  serverRestartCommand->BlockingOff();
+  serverRestartCommand->SetName("ServerRestart");
+  serverRestartCommand->SetCommandContent(commandStream.str());
+  serverRestartCommand->SetCommandMetaDataElement("ConfigFileName", filename);
+  serverRestartCommand->SetCommandMetaDataElement("ServerID", serverId);
+  serverRestartCommand->SetCommandMetaDataElement("Status", status);
+  serverRestartCommand->SetCommandMetaDataElement("Reason", reason);
+  serverRestartCommand->SetCommandMetaDataElement("RestartCount", restartCountString);
+  serverRestartCommand->SetCommandMetaDataElement("RestartDelaySec", restartDelayString);
+
+  SendCommand(serverRestartCommand);
+}
+
 //---------------------------------------------------------------------------
 void PlusServerLauncherMainWindow::SendServerStoppedCommand(ServerInfo info)
 {
@@ -1416,15 +2860,18 @@ void PlusServerLauncherMainWindow::OnLogEvent(vtkObject* caller, unsigned long e
     return;
   }
 
+  // We don't want to end up in an infinite loop of logging if something goes wrong while forwarding, so messages that are
+  // logged by the forwarding itself are not forwarded (only counted as dropped). Messages of other threads are queued as usual.
+  bool loggedByFlush = self->m_RemoteControlLogFlushInProgress && QThread::currentThread() == self->thread();
+
+  QMutexLocker lock(&self->m_RemoteControlLogMutex);
+
   // Return if the client has not subscribed to log messages
   if (self->m_RemoteControlLogSubscribedClients.empty())
   {
     return;
   }
 
-  // We don't want to end up in an infinite loop of logging if something goes wrong, so remove the log observer
-  vtkPlusLogger::Instance()->RemoveObserver(self->m_RemoteControlLogMessageCallbackCommand);
-
   QString logMessage = QString();
   if (event == vtkPlusLogger::MessageLogged)
   {
@@ -1437,99 +2884,346 @@ void PlusServerLauncherMainWindow::OnLogEvent(vtkObject* caller, unsigned long e
     logMessage = logMessage.fromWCharArray(logMessageWChar);
   }
 
-  if (!logMessage.isEmpty())
+  if (logMessage.isEmpty())
+  {
+    return;
+  }
+
+  QStringList tokens = logMessage.split('|', QString::SkipEmptyParts);
+  if (tokens.size() == 0)
+  {
+    return;
+  }
+
+  RemoteLogEntry entry;
+  entry.LogLevelString = tokens[0].toStdString();
+  entry.LogLevel = vtkPlusLogger::GetLogLevelType(entry.LogLevelString);
+  if (tokens.size() > 2 && logMessage.contains("SERVER>"))
+  {
+    entry.Origin = "SERVER";
+  }
+  else
+  {
+    entry.Origin = "LAUNCHER";
+  }
+
+  std::stringstream message;
+  for (int i = 1; i < tokens.size(); ++i)
+  {
+    message << "|" << tokens[i].toStdString();
+  }
+  entry.Message = message.str();
+
+  // Filter by the level requested by each client and queue the entry, sending is done in FlushRemoteControlLogQueue
+  bool batchFull = false;
+  for (std::map<int, RemoteLogSubscription>::iterator subscribedClientIt = self->m_RemoteControlLogSubscribedClients.begin(); subscribedClientIt != self->m_RemoteControlLogSubscribedClients.end(); ++subscribedClientIt)
+  {
+    RemoteLogSubscription& subscription = subscribedClientIt->second;
+    if (entry.LogLevel != vtkPlusLogger::LOG_LEVEL_UNDEFINED && entry.LogLevel > subscription.LogLevel)
+    {
+      continue;
+    }
+    if (loggedByFlush)
+    {
+      subscription.DroppedCount++;
+      continue;
+    }
+    subscription.PendingEntries.push_back(entry);
+    if (subscription.PendingEntries.size() > static_cast<size_t>(REMOTE_CONTROL_LOG_MAX_QUEUE_SIZE))
+    {
+      // Client is not keeping up, drop the oldest message
+      subscription.PendingEntries.pop_front();
+      subscription.DroppedCount++;
+    }
+    if (subscription.PendingEntries.size() >= static_cast<size_t>(REMOTE_CONTROL_LOG_BATCH_SIZE))
+    {
+      batchFull = true;
+    }
+  }
+
+  if (batchFull && !self->m_RemoteControlLogFlushRequested)
   {
+    // Do not wait for the flush timer, but do not send from within the logger callback either
+    self->m_RemoteControlLogFlushRequested = true;
+    QMetaObject::invokeMethod(self, "FlushRemoteControlLogQueue", Qt::QueuedConnection);
+  }
+}
+
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::FlushRemoteControlLogQueue()
+{
+  if (!m_RemoteControlServerConnector || !m_RemoteControlServerConnector->IsConnected())
+  {
+    return;
+  }
 
-    QStringList tokens = logMessage.split('|', QString::SkipEmptyParts);
-    if (tokens.size() > 0)
+  // Take the pending messages of each client so that logging is not blocked while sending
+  std::map<int, RemoteLogSubscription> outgoing;
+  {
+    QMutexLocker lock(&m_RemoteControlLogMutex);
+    m_RemoteControlLogFlushRequested = false;
+    for (std::map<int, RemoteLogSubscription>::iterator subscribedClientIt = m_RemoteControlLogSubscribedClients.begin(); subscribedClientIt != m_RemoteControlLogSubscribedClients.end(); ++subscribedClientIt)
     {
-      std::string logLevel = tokens[0].toStdString();
-      std::string messageOrigin;
-      if (tokens.size() > 2 && logMessage.toStdString().find("SERVER>") != std::string::npos)
+      RemoteLogSubscription& subscription = subscribedClientIt->second;
+      if (subscription.PendingEntries.empty() && subscription.DroppedCount == 0)
       {
-        messageOrigin = "SERVER";
+        continue;
       }
-      else
+      RemoteLogSubscription& clientOutgoing = outgoing[subscribedClientIt->first];
+      clientOutgoing.Batched = subscription.Batched;
+      clientOutgoing.DroppedCount = subscription.DroppedCount;
+      subscription.DroppedCount = 0;
+
+      // Only send one batch per flush, the rest is sent on the next flush
+      size_t numberOfEntries = std::min<size_t>(subscription.PendingEntries.size(), static_cast<size_t>(REMOTE_CONTROL_LOG_BATCH_SIZE));
+      clientOutgoing.PendingEntries.assign(subscription.PendingEntries.begin(), subscription.PendingEntries.begin() + numberOfEntries);
+      subscription.PendingEntries.erase(subscription.PendingEntries.begin(), subscription.PendingEntries.begin() + numberOfEntries);
+      if (!subscription.PendingEntries.empty())
       {
-        messageOrigin = "LAUNCHER";
+        m_RemoteControlLogFlushRequested = true;
       }
+    }
+  }
 
-      std::stringstream message;
-      for (int i = 1; i < tokens.size(); ++i)
-      {
-        message << "|" << tokens[i].toStdString();
-      }
-      std::string logMessageString = message.str();
+  m_RemoteControlLogFlushInProgress = true;
+
+  for (std::map<int, RemoteLogSubscription>::iterator clientIt = outgoing.begin(); clientIt != outgoing.end(); ++clientIt)
+  {
+    int clientId = clientIt->first;
+    const RemoteLogSubscription& clientOutgoing = clientIt->second;
+    unsigned int failedCount = 0;
 
+    if (clientOutgoing.Batched)
+    {
       vtkSmartPointer<vtkXMLDataElement> commandElement = vtkSmartPointer<vtkXMLDataElement>::New();
       commandElement->SetName("Command");
-      vtkSmartPointer<vtkXMLDataElement> messageElement = vtkSmartPointer<vtkXMLDataElement>::New();
-      messageElement->SetName("LogMessage");
-      messageElement->SetAttribute("Message", logMessageString.c_str());
-      messageElement->SetAttribute("LogLevel", logLevel.c_str());
-      messageElement->SetAttribute("Origin", messageOrigin.c_str());
-      commandElement->AddNestedElement(messageElement);
+      for (std::deque<RemoteLogEntry>::const_iterator entryIt = clientOutgoing.PendingEntries.begin(); entryIt != clientOutgoing.PendingEntries.end(); ++entryIt)
+      {
+        vtkSmartPointer<vtkXMLDataElement> messageElement = vtkSmartPointer<vtkXMLDataElement>::New();
+        messageElement->SetName("LogMessage");
+        messageElement->SetAttribute("Message", entryIt->Message.c_str());
+        messageElement->SetAttribute("LogLevel", entryIt->LogLevelString.c_str());
+        messageElement->SetAttribute("Origin", entryIt->Origin.c_str());
+        commandElement->AddNestedElement(messageElement);
+      }
 
       std::stringstream messageCommand;
       vtkXMLUtilities::FlattenElement(commandElement, messageCommand);
 
-      for (std::set<int>::iterator subscribedClientsIt = self->m_RemoteControlLogSubscribedClients.begin(); subscribedClientsIt != self->m_RemoteControlLogSubscribedClients.end(); ++subscribedClientsIt)
+      igtlioCommandPointer logMessagesCommand = igtlioCommandPointer::New();
+      logMessagesCommand->SetClientId(clientId);
+      logMessagesCommand->BlockingOff();
+      logMessagesCommand->SetName("LogMessages");
+      logMessagesCommand->SetCommandContent(messageCommand.str());
+      logMessagesCommand->SetCommandMetaDataElement("MessageCount", igsioCommon::ToString<size_t>(clientOutgoing.PendingEntries.size()));
+      logMessagesCommand->SetCommandMetaDataElement("DroppedMessageCount", igsioCommon::ToString<unsigned int>(clientOutgoing.DroppedCount));
+      if (SendCommand(logMessagesCommand) != PLUS_SUCCESS)
+      {
+        failedCount = clientOutgoing.PendingEntries.size() + clientOutgoing.DroppedCount;
+      }
+    }
+    else
+    {
+      // Clients that did not request batching receive one LogMessage command per entry
+      for (std::deque<RemoteLogEntry>::const_iterator entryIt = clientOutgoing.PendingEntries.begin(); entryIt != clientOutgoing.PendingEntries.end(); ++entryIt)
       {
+        vtkSmartPointer<vtkXMLDataElement> commandElement = vtkSmartPointer<vtkXMLDataElement>::New();
+        commandElement->SetName("Command");
+        vtkSmartPointer<vtkXMLDataElement> messageElement = vtkSmartPointer<vtkXMLDataElement>::New();
+        messageElement->SetName("LogMessage");
+        messageElement->SetAttribute("Message", entryIt->Message.c_str());
+        messageElement->SetAttribute("LogLevel", entryIt->LogLevelString.c_str());
+        messageElement->SetAttribute("Origin", entryIt->Origin.c_str());
+        commandElement->AddNestedElement(messageElement);
+
+        std::stringstream messageCommand;
+        vtkXMLUtilities::FlattenElement(commandElement, messageCommand);
+
         igtlioCommandPointer logMessageCommand = igtlioCommandPointer::New();
-        logMessageCommand->SetClientId(*subscribedClientsIt);
+        logMessageCommand->SetClientId(clientId);
         logMessageCommand->BlockingOff();
         logMessageCommand->SetName("LogMessage");
         logMessageCommand->SetCommandContent(messageCommand.str());
-        logMessageCommand->SetCommandMetaDataElement("Message", logMessageString);
-        logMessageCommand->SetCommandMetaDataElement("LogLevel", logLevel);
-        logMessageCommand->SetCommandMetaDataElement("Origin", messageOrigin);
-        self->SendCommand(logMessageCommand);
+        logMessageCommand->SetCommandMetaDataElement("Message", entryIt->Message);
+        logMessageCommand->SetCommandMetaDataElement("LogLevel", entryIt->LogLevelString);
+        logMessageCommand->SetCommandMetaDataElement("Origin", entryIt->Origin);
+        if (SendCommand(logMessageCommand) != PLUS_SUCCESS)
+        {
+          failedCount++;
+        }
+      }
+    }
+
+    if (failedCount > 0)
+    {
+      // Messages that could not be sent are reported as dropped in the next batch
+      QMutexLocker lock(&m_RemoteControlLogMutex);
+      std::map<int, RemoteLogSubscription>::iterator subscribedClientIt = m_RemoteControlLogSubscribedClients.find(clientId);
+      if (subscribedClientIt != m_RemoteControlLogSubscribedClients.end())
+      {
+        subscribedClientIt->second.DroppedCount += failedCount;
       }
     }
   }
 
-  // Re-apply the log observers
-  vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::MessageLogged, self->m_RemoteControlLogMessageCallbackCommand);
-  vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::WideMessageLogged, self->m_RemoteControlLogMessageCallbackCommand);
+  m_RemoteControlLogFlushInProgress = false;
+
+  if (m_RemoteControlLogFlushRequested)
+  {
+    // More messages are waiting than fit in one batch
+    QMetaObject::invokeMethod(this, "FlushRemoteControlLogQueue", Qt::QueuedConnection);
+  }
 }
 
 //---------------------------------------------------------------------------
 std::string PlusServerLauncherMainWindow::GetServersFromConfigFile(std::string filename)
 {
+  return GetConfigFileCacheEntry(vtksys::SystemTools::GetFilenameName(filename)).Servers;
+}
+
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::UpdateConfigFileCacheDirectory()
+{
+  std::string directory = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationDirectory();
+  if (directory == m_ConfigFileCacheDirectory)
+  {
+    return;
+  }
 
-  std::string ports = "";
+  // Directory changed (or first use): nothing in the cache is valid anymore
+  if (!m_ConfigFileWatcher->files().isEmpty())
+  {
+    m_ConfigFileWatcher->removePaths(m_ConfigFileWatcher->files());
+  }
+  if (!m_ConfigFileWatcher->directories().isEmpty())
+  {
+    m_ConfigFileWatcher->removePaths(m_ConfigFileWatcher->directories());
+  }
+  m_ConfigFileCache.clear();
+  m_ConfigFileListCache.clear();
+  m_ConfigFileListCacheValid = false;
 
-  std::string filenameAndPath = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(filename);
+  m_ConfigFileCacheDirectory = directory;
+  if (vtksys::SystemTools::FileIsDirectory(m_ConfigFileCacheDirectory))
+  {
+    m_ConfigFileWatcher->addPath(QString::fromStdString(m_ConfigFileCacheDirectory));
+  }
+}
+
+//---------------------------------------------------------------------------
+PlusServerLauncherMainWindow::ConfigFileCacheEntry& PlusServerLauncherMainWindow::GetConfigFileCacheEntry(const std::string& filename)
+{
+  UpdateConfigFileCacheDirectory();
+
+  std::map<std::string, ConfigFileCacheEntry>::iterator cacheIt = m_ConfigFileCache.find(filename);
+  if (cacheIt != m_ConfigFileCache.end())
+  {
+    return cacheIt->second;
+  }
+
+  ConfigFileCacheEntry& entry = m_ConfigFileCache[filename];
+  entry.Valid = false;
 
-  vtkSmartPointer<vtkXMLDataElement> configFileElement = NULL;
-  configFileElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromFile(filenameAndPath.c_str()));
+  std::string filenameAndPath = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(filename);
+  std::ifstream file(filenameAndPath.c_str(), std::ios::binary);
+  if (file)
+  {
+    std::stringstream fileContent;
+    fileContent << file.rdbuf();
+    entry.FileHash = ComputeContentHash(fileContent.str());
+  }
+  vtkSmartPointer<vtkXMLDataElement> configFileElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromFile(filenameAndPath.c_str()));
+  if (!configFileElement)
+  {
+    // Cache the failure too, the file is watched so it is read again when it is fixed
+    if (vtksys::SystemTools::FileExists(filenameAndPath, true))
+    {
+      m_ConfigFileWatcher->addPath(QString::fromStdString(filenameAndPath));
+    }
+    return entry;
+  }
+  entry.Valid = true;
 
-  if (configFileElement)
+  for (int i = 0; i < configFileElement->GetNumberOfNestedElements(); ++i)
   {
-    for (int i = 0; i < configFileElement->GetNumberOfNestedElements(); ++i)
+    vtkXMLDataElement* nestedElement = configFileElement->GetNestedElement(i);
+    if (strcmp(nestedElement->GetName(), "PlusOpenIGTLinkServer") == 0)
     {
-      vtkXMLDataElement* nestedElement = configFileElement->GetNestedElement(i);
-      if (strcmp(nestedElement->GetName(), "PlusOpenIGTLinkServer") == 0)
+      std::stringstream serverNamePrefix;
+      const char* outputChannelId = nestedElement->GetAttribute("OutputChannelId");
+      if (outputChannelId)
       {
-        std::stringstream serverNamePrefix;
-        const char* outputChannelId = nestedElement->GetAttribute("OutputChannelId");
-        if (outputChannelId)
-        {
-          serverNamePrefix << outputChannelId;
-        }
-        else
-        {
-          serverNamePrefix << "PlusOpenIGTLinkServer";
-        }
-        serverNamePrefix << ":";
-        const char* port = nestedElement->GetAttribute("ListeningPort");
-        if (port)
-        {
-          ports += serverNamePrefix.str() + std::string(port) + ";";
-        }
+        serverNamePrefix << outputChannelId;
+      }
+      else
+      {
+        serverNamePrefix << "PlusOpenIGTLinkServer";
+      }
+      serverNamePrefix << ":";
+      const char* port = nestedElement->GetAttribute("ListeningPort");
+      if (port)
+      {
+        entry.Servers += serverNamePrefix.str() + std::string(port) + ";";
       }
     }
+  }
+
+  // Name and description of the first DeviceSet element, if the root element is PlusConfiguration
+  if (igsioCommon::IsEqualInsensitive(configFileElement->GetName(), "PlusConfiguration"))
+  {
+    vtkXMLDataElement* deviceSetElement = configFileElement->FindNestedElementWithName("DeviceSet");
+    if (deviceSetElement)
+    {
+      entry.DeviceSetName = deviceSetElement->GetAttribute("Name") ? deviceSetElement->GetAttribute("Name") : "";
+      entry.DeviceSetDescription = deviceSetElement->GetAttribute("Description") ? deviceSetElement->GetAttribute("Description") : "";
+    }
+  }
+
+  // The content is sent reserialized, so it is hashed separately from the file
+  std::stringstream contentStream;
+  vtkXMLUtilities::FlattenElement(configFileElement, contentStream);
+  entry.Content = contentStream.str();
+  entry.ContentHash = ComputeContentHash(entry.Content);
+
+  m_ConfigFileWatcher->addPath(QString::fromStdString(filenameAndPath));
+  return entry;
+}
+
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::InvalidateConfigFileCacheEntry(const std::string& filename)
+{
+  m_ConfigFileCache.erase(filename);
+  m_ConfigFileListCacheValid = false;
+}
+
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnConfigFileChanged(const QString& path)
+{
+  LOG_DEBUG("Config file changed: " << path.toStdString());
+  InvalidateConfigFileCacheEntry(vtksys::SystemTools::GetFilenameName(path.toStdString()));
+
+  // Editors often replace the file instead of modifying it, which removes it from the watcher
+  if (QFileInfo::exists(path) && !m_ConfigFileWatcher->files().contains(path))
+  {
+    m_ConfigFileWatcher->addPath(path);
+  }
+}
 
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnConfigFileDirectoryChanged(const QString& path)
+{
+  // A file was added, removed or renamed. Failed lookups are dropped as well: a file that was missing or could not be
+  // parsed may have just been created or replaced, and missing files are not watched individually.
+  m_ConfigFileListCacheValid = false;
+  for (std::map<std::string, ConfigFileCacheEntry>::iterator cacheIt = m_ConfigFileCache.begin(); cacheIt != m_ConfigFileCache.end();)
+  {
+    if (!cacheIt->second.Valid || !vtksys::SystemTools::FileExists(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(cacheIt->first), true))
+    {
+      cacheIt = m_ConfigFileCache.erase(cacheIt);
+    }
+    else
+    {
+      ++cacheIt;
+    }
   }
-  return ports;
 }
@@ -10,17 +10,26 @@
 #include "PlusConfigure.h"
 #include "ui_PlusServerLauncherMainWindow.h"
 
+#include <vtkIGSIOAccurateTimer.h>
+
 #include <QMainWindow>
+#include <QMutex>
 #include <QProcess>
 
+// STL includes
+#include <atomic>
+
 // OpenIGTLinkIO includes
 #include <igtlioCommand.h>
 #include <igtlioConnector.h>
 #include <igtlioLogic.h>
 
 class QComboBox;
+class QFileSystemWatcher;
 class QPlusDeviceSetSelectorWidget;
 class QProcess;
+class QTcpServer;
+class QTcpSocket;
 class QTimer;
 class QWidget;
 class vtkPlusDataCollector;
@@ -45,6 +54,22 @@ public:
     RemoteControlServerPortUseDefault = 0
   };
   static const int DEFAULT_REMOTE_CONTROL_SERVER_PORT = 18904;
+  /*! Remote control connector processing interval while the events of forwarded client data have not been reported yet */
+  static const int REMOTE_CONTROL_SERVER_PENDING_PROCESS_INTERVAL_MSEC = 1;
+  /*! Expected remote control connector events that are not reported within this time are not waited for any more */
+  static const int REMOTE_CONTROL_SERVER_PENDING_EVENT_TIMEOUT_MSEC = 1000;
+  /*! Resource usage of the running servers is sampled this often */
+  static const int SERVER_RESOURCE_MONITOR_INTERVAL_MSEC = 1000;
+  /*! Liveness of supervised servers is checked this often */
+  static const int SERVER_WATCHDOG_INTERVAL_MSEC = 1000;
+  /*! Default time to wait for all servers of a StartServers command to become ready */
+  static const int BATCH_START_DEFAULT_TIMEOUT_SEC = 60;
+  /*! Log messages are forwarded to remote clients in batches, at most this often */
+  static const int REMOTE_CONTROL_LOG_FLUSH_INTERVAL_MSEC = 50;
+  /*! Maximum number of log entries sent to a client in one flush, a flush is triggered immediately when reached */
+  static const int REMOTE_CONTROL_LOG_BATCH_SIZE = 100;
+  /*! Maximum number of log entries queued for a client, older entries are dropped when the client falls behind */
+  static const int REMOTE_CONTROL_LOG_MAX_QUEUE_SIZE = 2000;
   static const char* PLUS_SERVER_LAUNCHER_REMOTE_DEVICE_ID;
 
   /*!
@@ -81,14 +106,129 @@ protected slots:
   void OnCommandReceivedEvent(igtlioCommandPointer command);
   static void OnLogEvent(vtkObject* caller, unsigned long eventId, void* clientData, void* callData);
 
+  /*! Send the queued log messages to the subscribed clients */
+  void FlushRemoteControlLogQueue();
+
   void OnWritePermissionClicked();
 
   void OnTimerTimeout();
 
+  /*! Accept remote control clients and connect each of them to the remote control connector */
+  void OnRemoteControlClientConnected();
+
   void StopRemoteServerButtonClicked();
 
+  /*! Sample the resource usage of the running servers and show it in the server table */
+  void OnServerResourceMonitorTimerTimeout();
+
+  /*! Check that the supervised servers are still responsive, restart the ones that are not */
+  void OnServerWatchdogTimerTimeout();
+
+  /*! Invalidate the cached information of config files that changed on disk */
+  void OnConfigFileChanged(const QString& path);
+  void OnConfigFileDirectoryChanged(const QString& path);
+
 protected:
 
+  /*! Resource usage of a PlusServer process, sampled periodically (CPU, memory, threads and sockets are only available on Linux) */
+  struct ServerResourceUsage
+  {
+    ServerResourceUsage()
+      : Valid(false)
+      , CpuPercent(0.0)
+      , ResidentMemoryBytes(0)
+      , NumberOfThreads(0)
+      , NumberOfOpenSockets(0)
+      , CpuTimeSec(-1.0)
+      , SampleTime(0.0)
+    {
+    }
+    bool                Valid;
+    double              CpuPercent;
+    unsigned long long  ResidentMemoryBytes;
+    int                 NumberOfThreads;
+    int                 NumberOfOpenSockets;
+    /*! Total CPU time used by the process at the time of the last sample, used for computing CpuPercent */
+    double              CpuTimeSec;
+    double              SampleTime;
+  };
+
+  /*! Defines how a server is supervised: whether it is restarted when it stops unexpectedly and when it is considered hung */
+  struct ServerSupervisionPolicy
+  {
+    ServerSupervisionPolicy()
+      : RestartOnCrash(false)
+      , MaxRestarts(5)
+      , RestartWindowSec(600.0)
+      , InitialRestartDelaySec(1.0)
+      , MaxRestartDelaySec(60.0)
+      , HeartbeatTimeoutSec(0.0)
+    {
+    }
+    bool    RestartOnCrash;
+    /*! Maximum number of restarts within RestartWindowSec, no more restarts are attempted after that */
+    int     MaxRestarts;
+    double  RestartWindowSec;
+    /*! Delay before the first restart, doubled for each further restart within the window up to MaxRestartDelaySec */
+    double  InitialRestartDelaySec;
+    double  MaxRestartDelaySec;
+    /*! If the server has not logged anything and does not answer on its OpenIGTLink port for this long it is restarted. 0 disables the watchdog. */
+    double  HeartbeatTimeoutSec;
+  };
+
+  struct ServerSupervisionState
+  {
+    ServerSupervisionState()
+      : LogLevel(vtkPlusLogger::LOG_LEVEL_UNDEFINED)
+      , LastHeartbeatTime(0.0)
+      , Probe(nullptr)
+      , ProbePending(false)
+      , ProbeCommandId(0)
+      , ProbeStartTime(0.0)
+      , RestartPending(false)
+    {
+    }
+    ServerSupervisionPolicy Policy;
+    int                     LogLevel;
+    /*! Times of the restarts within the restart window */
+    std::deque<double>      RestartTimes;
+    /*! Last time the server was known to be alive (logged a message or answered a probe) */
+    double                  LastHeartbeatTime;
+    /*! Connection to the OpenIGTLink port of the server, kept open between the probes */
+    QTcpSocket*             Probe;
+    /*! Received data of the probe connection that is not a complete message yet */
+    QByteArray              ProbeBuffer;
+    /*! True if a reply to the probe command with ProbeCommandId is awaited since ProbeStartTime */
+    bool                    ProbePending;
+    unsigned int            ProbeCommandId;
+    double                  ProbeStartTime;
+    bool                    RestartPending;
+    /*! Reason of the next restart if the server was stopped by the watchdog */
+    std::string             PendingRestartReason;
+  };
+
+  /*! Information parsed from a device set configuration file, kept until the file changes on disk */
+  struct ConfigFileCacheEntry
+  {
+    ConfigFileCacheEntry()
+      : Valid(false)
+    {
+    }
+    /*! OpenIGTLink servers defined in the file, in "OutputChannelId:port;" format */
+    std::string Servers;
+    std::string DeviceSetName;
+    std::string DeviceSetDescription;
+    /*! Flattened XML content of the file */
+    std::string Content;
+    /*! Compressed and base64 encoded Content, computed when it is first requested */
+    std::string CompressedContent;
+    /*! SHA-256 hash of the file as stored on disk, in hexadecimal format */
+    std::string FileHash;
+    /*! SHA-256 hash of Content, in hexadecimal format */
+    std::string ContentHash;
+    bool        Valid;
+  };
+
   struct ServerInfo
   {
     ServerInfo()
@@ -96,16 +236,89 @@ protected:
       this->ID = "";
       this->Filename = "";
       this->Process = nullptr;
+      this->StartTime = 0.0;
+      this->Ready = false;
     }
     ServerInfo(std::string filename, QProcess* process)
     {
       this->ID = vtksys::SystemTools::GetFilenameWithoutExtension(filename);
       this->Filename = filename;
       this->Process = process;
+      this->StartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+      this->Ready = false;
     }
     std::string ID;
     std::string Filename;
     QProcess*   Process;
+    double      StartTime;
+    /*! True once the server reported that its OpenIGTLink servers are running */
+    bool        Ready;
+    ServerResourceUsage ResourceUsage;
+  };
+
+  struct RemoteLogEntry
+  {
+    vtkPlusLogger::LogLevelType LogLevel;
+    std::string LogLevelString;
+    std::string Message;
+    std::string Origin;
+  };
+
+  struct RemoteLogSubscription
+  {
+    RemoteLogSubscription()
+      : LogLevel(vtkPlusLogger::LOG_LEVEL_TRACE)
+      , Batched(false)
+      , DroppedCount(0)
+    {
+    }
+    /*! Only messages at this level or more severe are forwarded to the client */
+    int                         LogLevel;
+    /*! If true then pending messages are sent in a single LogMessages command, otherwise one LogMessage command per entry */
+    bool                        Batched;
+    /*! Number of messages dropped since the last batch was sent because the client fell behind */
+    unsigned int                DroppedCount;
+    std::deque<RemoteLogEntry>  PendingEntries;
+  };
+
+  /*! Result of starting or stopping one server of a StartServers/StopServers command */
+  struct BatchServerResult
+  {
+    BatchServerResult()
+      : ElapsedSec(0.0)
+    {
+    }
+    /*! Starting, Running, Failed, Timeout, Stopped, ForcedStop or NotRunning */
+    std::string Status;
+    double      ElapsedSec;
+    std::string ErrorMessage;
+  };
+
+  /*! StartServers command that is waiting for its servers to become ready */
+  struct PendingBatchCommand
+  {
+    int                                       Id;
+    igtlioCommandPointer                      Command;
+    double                                    StartTime;
+    /*! Results by config file name, in the order of the request */
+    std::vector<std::pair<std::string, BatchServerResult> > Results;
+  };
+
+  /*! Remote control client and the local connection that forwards its data to the remote control connector */
+  struct RemoteControlConnection
+  {
+    RemoteControlConnection()
+      : Client(nullptr)
+      , Connector(nullptr)
+      , ConnectorConnected(false)
+    {
+    }
+    QTcpSocket* Client;
+    QTcpSocket* Connector;
+    /*! Set when the connection to the connector is established, the connector reports a disconnection only after that */
+    bool        ConnectorConnected;
+    /*! Data received from the client that does not contain a complete OpenIGTLink message yet */
+    QByteArray  ClientBuffer;
   };
 
 protected:
@@ -121,6 +334,11 @@ protected:
 
   /*! Start server process, connect outputs to logger. Returns with true on success. */
   bool StartServer(const QString& configFilePath, int logLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED);
+  /*! Start server process without waiting for it. Returns the process, or nullptr if it could not be started. */
+  QProcess* LaunchServerProcess(const QString& configFilePath, int logLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED);
+
+  /*! Called when a server reported that its OpenIGTLink servers are running */
+  void SetServerReady(QProcess* process);
   /*! Start server process from GUI */
   bool LocalStartServer();
 
@@ -142,13 +360,30 @@ protected:
   void GetConfigFiles(igtlioCommandPointer command);
   void RemoteStartServer(igtlioCommandPointer command);
   void RemoteStopServer(igtlioCommandPointer command);
+  void RemoteStartServers(igtlioCommandPointer command);
+  void RemoteStopServers(igtlioCommandPointer command);
+
+  /*! Read the supervision policy from the metadata of a start command */
+  ServerSupervisionState GetSupervisionStateFromCommand(igtlioCommandPointer command, int logLevel);
+
+  /*! Update the result of the server in the pending StartServers commands and respond to the ones that are complete */
+  void UpdatePendingBatchCommands(const std::string& filename, const std::string& status, const std::string& errorMessage);
+  void OnPendingBatchCommandTimeout(int batchCommandId);
+  void SendBatchCommandResponse(igtlioCommandPointer command, const std::vector<std::pair<std::string, BatchServerResult> >& results);
   void GetRunningServers(igtlioCommandPointer command);
   void GetConfigFileContents(igtlioCommandPointer command);
+  void GetServerResourceUsage(igtlioCommandPointer command);
 
   void LocalLog(vtkPlusLogger::LogLevelType level, const std::string& message);
 
   std::string GetServersFromConfigFile(std::string filename);
 
+  /*! Get the parsed information of a config file in the device set configuration directory, reading it only if it is not cached yet */
+  ConfigFileCacheEntry& GetConfigFileCacheEntry(const std::string& filename);
+  /*! Remove everything from the config file cache if the device set configuration directory has changed */
+  void UpdateConfigFileCacheDirectory();
+  void InvalidateConfigFileCacheEntry(const std::string& filename);
+
   void SendServerStartedCommand(ServerInfo info);
   void SendServerStoppedCommand(ServerInfo info);
 
@@ -163,6 +398,38 @@ protected:
   /*! Update the contents of the remote control table to reflect the current status */
   void UpdateRemoteServerTable();
 
+  /*! Restart the server if allowed by its supervision policy, after the backoff delay */
+  void HandleUnexpectedServerExit(const std::string& filename, const std::string& reason, int returnCode);
+  void RestartServer(const std::string& filename);
+
+  /*! Send a structured event about a server restart to the remote clients */
+  void SendServerRestartCommand(const std::string& filename, const std::string& status, const std::string& reason, int restartCount, double restartDelaySec);
+
+  /*! Check that the server answers a command on its OpenIGTLink port */
+  void StartServerLivenessProbe(const std::string& filename, ServerSupervisionState& state);
+  void StopServerLivenessProbe(ServerSupervisionState& state);
+  /*! Connect the probe connection if it is not connected, the command is sent when connected. Returns false if the server has no port to probe. */
+  bool ConnectServerLivenessProbe(const std::string& filename, ServerSupervisionState& state);
+  void SendServerLivenessProbeCommand(ServerSupervisionState& state);
+  /*! Read the received data of the probe connection. Returns true if a well-formed reply to the pending probe command has been received. */
+  bool ReadServerLivenessProbeReplies(ServerSupervisionState& state);
+
+  /*! Update the resource usage columns of the server table without rebuilding it */
+  void UpdateRemoteServerTableResourceUsage();
+
+  /*! Forward the received data of a remote control client to the connector */
+  void ForwardRemoteControlClientData(QTcpSocket* client);
+  /*! Close both sides of a forwarded remote control connection */
+  void CloseRemoteControlConnection(QTcpSocket* client);
+  /*! Return the number of complete COMMAND messages in the buffer and remove the complete messages from it */
+  int ReadRemoteControlCommandMessages(QByteArray& buffer);
+  /*! Process the remote control connector until the given number of further events are reported */
+  void ExpectRemoteControlServerEvents(int numberOfEvents);
+
+  /*! Add or remove a client from the list of clients that receive log messages */
+  void RemoteLogSubscribe(igtlioCommandPointer command);
+  void RemoteLogUnsubscribe(igtlioCommandPointer command);
+
 protected:
   /*! Device set selector widget */
   QPlusDeviceSetSelectorWidget*         m_DeviceSetSelectorWidget;
@@ -183,9 +450,44 @@ protected:
   igtlioConnectorPointer                m_RemoteControlServerConnector;
   vtkSmartPointer<vtkCallbackCommand>   m_RemoteControlLogMessageCallbackCommand;
 
+  /*!
+    The connector only reports received messages when it is processed and cannot be woken up by socket activity,
+    therefore it listens on a local port and clients connect to m_RemoteControlServer, which forwards their data.
+    The connector is only processed while the events of the forwarded data are expected.
+  */
+  QTcpServer*                           m_RemoteControlServer;
+  int                                   m_RemoteControlServerConnectorPort;
+  /*! Forwarded connections by client socket */
+  std::map<QTcpSocket*, RemoteControlConnection> m_RemoteControlConnections;
   QTimer*                               m_RemoteControlServerConnectorProcessTimer;
-
-  std::set<int>                         m_RemoteControlLogSubscribedClients;
+  /*! Number of connector events (connection, disconnection, command) expected for the forwarded data */
+  int                                   m_RemoteControlServerPendingEvents;
+  double                                m_RemoteControlServerPendingEventsTime;
+
+  /*! Clients subscribed to log messages and the messages waiting to be sent to them */
+  std::map<int, RemoteLogSubscription>  m_RemoteControlLogSubscribedClients;
+  QMutex                                m_RemoteControlLogMutex;
+  QTimer*                               m_RemoteControlLogFlushTimer;
+  bool                                  m_RemoteControlLogFlushRequested;
+  /*! Set while log messages are sent, to avoid forwarding messages that are logged by the forwarding itself. Read by the logger callback on any thread. */
+  std::atomic<bool>                     m_RemoteControlLogFlushInProgress;
+
+  QTimer*                               m_ServerResourceMonitorTimer;
+
+  /*! Supervision of the servers, by config file name. Kept while the server is restarted, removed when it is stopped on request. */
+  std::map<std::string, ServerSupervisionState> m_ServerSupervisionStates;
+  QTimer*                               m_ServerWatchdogTimer;
+
+  /*! Parsed config files by file name and the list of config files in the device set configuration directory */
+  std::map<std::string, ConfigFileCacheEntry> m_ConfigFileCache;
+  std::string                           m_ConfigFileListCache;
+  bool                                  m_ConfigFileListCacheValid;
+  std::string                           m_ConfigFileCacheDirectory;
+  QFileSystemWatcher*                   m_ConfigFileWatcher;
+
+  /*! StartServers commands waiting for their servers to become ready */
+  std::list<PendingBatchCommand>        m_PendingBatchCommands;
+  int                                   m_NextBatchCommandId;
 
   /*! Incomplete string received from PlusServer */
   std::string                           m_LogIncompleteLine;
@@ -0,0 +1,774 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file PlusServerLauncherSoakTest.cxx
+\brief Load and soak test for the PlusServerLauncher remote control protocol
+
+Starts PlusServerLauncher (headless) with PlusServerStub as server executable, connects many remote control
+clients and keeps sending commands to it for the requested duration:
+- query clients repeatedly send GetConfigFiles, GetRunningServers, GetServerResourceUsage and GetConfigFileContents
+  (for the servers that were running according to the preceding GetRunningServers response)
+- every other query client also subscribes to log messages (alternating batched and not batched)
+- one control client repeatedly starts and stops all servers, alternating StartServers/StopServers and StartServer/StopServer
+
+Command latency percentiles, error rate and memory usage of the launcher are reported periodically
+and at the end. The test fails if the error rate or the memory growth of the launcher exceeds the limits,
+or if no config file contents were received.
+Memory usage is only measured on Linux.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkIGSIOAccurateTimer.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+
+// OpenIGTLinkIO includes
+#include <igtlioCommand.h>
+#include <igtlioConnector.h>
+#include <igtlioLogic.h>
+
+// Qt includes
+#include <QCoreApplication>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QStringList>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+
+// STL includes
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /*!
+    Latency histogram with logarithmic buckets (1% resolution between 10us and 10 minutes),
+    so that memory usage does not grow during long soak runs.
+  */
+  class LatencyHistogram
+  {
+  public:
+    LatencyHistogram()
+      : Buckets(NUMBER_OF_BUCKETS, 0)
+      , Count(0)
+      , MaxSec(0.0)
+    {
+    }
+
+    void Add(double latencySec)
+    {
+      int bucket = 0;
+      if (latencySec > MIN_LATENCY_SEC)
+      {
+        bucket = std::min<int>(NUMBER_OF_BUCKETS - 1, static_cast<int>(std::log(latencySec / MIN_LATENCY_SEC) / std::log(BUCKET_GROWTH)) + 1);
+      }
+      this->Buckets[bucket]++;
+      this->Count++;
+      this->MaxSec = std::max(this->MaxSec, latencySec);
+    }
+
+    /*! Upper bound of the bucket that contains the requested percentile (0-100) */
+    double GetPercentileSec(double percentile) const
+    {
+      if (this->Count == 0)
+      {
+        return 0.0;
+      }
+      unsigned long rank = static_cast<unsigned long>(std::ceil(percentile / 100.0 * this->Count));
+      unsigned long cumulativeCount = 0;
+      for (int bucket = 0; bucket < NUMBER_OF_BUCKETS; ++bucket)
+      {
+        cumulativeCount += this->Buckets[bucket];
+        if (cumulativeCount >= rank)
+        {
+          return std::min(this->MaxSec, MIN_LATENCY_SEC * std::pow(BUCKET_GROWTH, bucket));
+        }
+      }
+      return this->MaxSec;
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+      for (int bucket = 0; bucket < NUMBER_OF_BUCKETS; ++bucket)
+      {
+        this->Buckets[bucket] += other.Buckets[bucket];
+      }
+      this->Count += other.Count;
+      this->MaxSec = std::max(this->MaxSec, other.MaxSec);
+    }
+
+    void Reset()
+    {
+      std::fill(this->Buckets.begin(), this->Buckets.end(), 0);
+      this->Count = 0;
+      this->MaxSec = 0.0;
+    }
+
+    unsigned long GetCount() const { return this->Count; }
+    double GetMaxSec() const { return this->MaxSec; }
+
+  protected:
+    static const int NUMBER_OF_BUCKETS = 1800;
+    static const double MIN_LATENCY_SEC;
+    static const double BUCKET_GROWTH;
+
+    std::vector<unsigned long> Buckets;
+    unsigned long Count;
+    double MaxSec;
+  };
+  const double LatencyHistogram::MIN_LATENCY_SEC = 1e-5;
+  const double LatencyHistogram::BUCKET_GROWTH = 1.01;
+
+  //----------------------------------------------------------------------------
+  struct CommandStatistics
+  {
+    CommandStatistics()
+      : ErrorCount(0)
+      , TimeoutCount(0)
+      , IntervalErrorCount(0)
+    {
+    }
+    LatencyHistogram  Latency;
+    LatencyHistogram  IntervalLatency;
+    unsigned long     ErrorCount;
+    unsigned long     TimeoutCount;
+    unsigned long     IntervalErrorCount;
+  };
+
+  //----------------------------------------------------------------------------
+  struct CommandRequest
+  {
+    CommandRequest()
+      : DelayAfterSec(0.0)
+    {
+    }
+    std::string                         Name;
+    std::map<std::string, std::string>  MetaData;
+    /*! Time to wait after the response before sending the next command of the client */
+    double                              DelayAfterSec;
+  };
+
+  //----------------------------------------------------------------------------
+  enum ClientRole
+  {
+    CLIENT_ROLE_QUERY,
+    CLIENT_ROLE_LOG_SUBSCRIBER,
+    CLIENT_ROLE_BATCHED_LOG_SUBSCRIBER,
+    CLIENT_ROLE_SERVER_CONTROL
+  };
+
+  //----------------------------------------------------------------------------
+  struct SoakTestClient
+  {
+    SoakTestClient()
+      : Role(CLIENT_ROLE_QUERY)
+      , PendingCommandSendTime(0.0)
+      , NextCommandTime(0.0)
+      , CycleCount(0)
+    {
+    }
+    igtlioConnectorPointer      Connector;
+    ClientRole                  Role;
+    igtlioCommandPointer        PendingCommand;
+    std::string                 PendingCommandName;
+    double                      PendingCommandSendTime;
+    double                      NextCommandTime;
+    std::deque<CommandRequest>  Requests;
+    unsigned long               CycleCount;
+    /*! Running servers in the last GetRunningServers response, separated by ';' */
+    std::string                 RunningServerIds;
+  };
+
+  //----------------------------------------------------------------------------
+  struct SoakTestSettings
+  {
+    int                       NumberOfClients;
+    std::vector<std::string>  ConfigFileNames;
+    double                    CommandTimeoutSec;
+    double                    RequestIntervalSec;
+    double                    ServerRunSec;
+  };
+
+  unsigned long ReceivedLogCommandCount = 0;
+  unsigned long ReceivedConfigFileContentCount = 0;
+
+  //----------------------------------------------------------------------------
+  void OnCommandReceived(vtkObject* caller, unsigned long eventId, void* clientData, void* callData)
+  {
+    igtlioCommand* command = reinterpret_cast<igtlioCommand*>(callData);
+    if (command == nullptr)
+    {
+      return;
+    }
+    // Log messages are sent by the launcher without expecting a response, only count them
+    if (igsioCommon::IsEqualInsensitive(command->GetName(), "LogMessage") || igsioCommon::IsEqualInsensitive(command->GetName(), "LogMessages"))
+    {
+      ReceivedLogCommandCount++;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Resident memory of a process in bytes, 0 if not available */
+  double GetProcessResidentMemoryBytes(qint64 processId)
+  {
+#if defined(__linux__)
+    std::ifstream statusFile(("/proc/" + igsioCommon::ToString<qint64>(processId) + "/status").c_str());
+    std::string line;
+    while (std::getline(statusFile, line))
+    {
+      if (line.compare(0, 6, "VmRSS:") == 0)
+      {
+        double residentMemoryKb = 0.0;
+        std::stringstream lineStream(line.substr(6));
+        lineStream >> residentMemoryKb;
+        return residentMemoryKb * 1024.0;
+      }
+    }
+#endif
+    return 0.0;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus WriteConfigFiles(const std::string& directory, int numberOfServers, int firstServerPort, std::vector<std::string>& configFileNames)
+  {
+    vtksys::SystemTools::MakeDirectory(directory);
+    for (int i = 0; i < numberOfServers; ++i)
+    {
+      std::string configFileName = "PlusDeviceSet_Server_SoakTest" + igsioCommon::ToString<int>(i + 1) + ".xml";
+      std::ofstream configFile(vtksys::SystemTools::CollapseFullPath(configFileName, directory).c_str());
+      if (!configFile)
+      {
+        LOG_ERROR("Failed to write config file " << configFileName << " to " << directory);
+        return PLUS_FAIL;
+      }
+      configFile << "<PlusConfiguration version=\"2.1\">" << std::endl
+                 << "  <DataCollection StartupDelaySec=\"1.0\">" << std::endl
+                 << "    <DeviceSet Name=\"PlusServer: Soak test " << i + 1 << "\" Description=\"Device set for PlusServerLauncherSoakTest, used with PlusServerStub\" />" << std::endl
+                 << "  </DataCollection>" << std::endl
+                 << "  <PlusOpenIGTLinkServer MaxNumberOfIgtlMessagesToSend=\"1\" MaxTimeSpentWithProcessingMs=\"50\" ListeningPort=\"" << firstServerPort + i << "\" OutputChannelId=\"StubStream\" />" << std::endl
+                 << "</PlusConfiguration>" << std::endl;
+      configFileNames.push_back(configFileName);
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Check the response of a GetConfigFileContents command: it must be a Command element with one element per running
+    server, which contains the content of its config file. Servers that were stopped since the GetRunningServers
+    response are missing from the response, that is not an error.
+  */
+  PlusStatus CheckConfigFileContentsResponse(igtlioCommand* command)
+  {
+    vtkSmartPointer<vtkXMLDataElement> responseElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(command->GetResponseContent().c_str()));
+    if (responseElement == nullptr || !igsioCommon::IsEqualInsensitive(responseElement->GetName(), "Command"))
+    {
+      LOG_WARNING("Invalid GetConfigFileContents response: " << command->GetResponseContent());
+      return PLUS_FAIL;
+    }
+    for (int i = 0; i < responseElement->GetNumberOfNestedElements(); ++i)
+    {
+      vtkXMLDataElement* serverElement = responseElement->GetNestedElement(i);
+      if (serverElement->GetAttribute("Hash") == nullptr || serverElement->GetNumberOfNestedElements() == 0)
+      {
+        LOG_WARNING("GetConfigFileContents response has no config file content or hash for server " << serverElement->GetName());
+        return PLUS_FAIL;
+      }
+      ReceivedConfigFileContentCount++;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  void QueueNextRequests(SoakTestClient& client, const SoakTestSettings& settings)
+  {
+    std::string configFileNames;
+    for (std::vector<std::string>::const_iterator it = settings.ConfigFileNames.begin(); it != settings.ConfigFileNames.end(); ++it)
+    {
+      configFileNames += (it == settings.ConfigFileNames.begin() ? "" : ";") + *it;
+    }
+
+    CommandRequest request;
+    if (client.Role == CLIENT_ROLE_SERVER_CONTROL)
+    {
+      // Alternate between starting all servers at once and starting them one by one
+      if (client.CycleCount % 2 == 0)
+      {
+        request.Name = "StartServers";
+        request.MetaData["ConfigFileNames"] = configFileNames;
+        request.MetaData["TimeoutSec"] = igsioCommon::ToString<double>(settings.CommandTimeoutSec / 2.0);
+        request.DelayAfterSec = settings.ServerRunSec;
+        client.Requests.push_back(request);
+        request = CommandRequest();
+        request.Name = "StopServers";
+        request.MetaData["ConfigFileNames"] = configFileNames;
+        request.DelayAfterSec = settings.RequestIntervalSec;
+        client.Requests.push_back(request);
+      }
+      else
+      {
+        for (std::vector<std::string>::const_iterator it = settings.ConfigFileNames.begin(); it != settings.ConfigFileNames.end(); ++it)
+        {
+          request = CommandRequest();
+          request.Name = "StartServer";
+          request.MetaData["ConfigFileName"] = *it;
+          request.DelayAfterSec = settings.RequestIntervalSec;
+          client.Requests.push_back(request);
+        }
+        client.Requests.back().DelayAfterSec = settings.ServerRunSec;
+        for (std::vector<std::string>::const_iterator it = settings.ConfigFileNames.begin(); it != settings.ConfigFileNames.end(); ++it)
+        {
+          request = CommandRequest();
+          request.Name = "StopServer";
+          request.MetaData["ConfigFileName"] = *it;
+          request.DelayAfterSec = settings.RequestIntervalSec;
+          client.Requests.push_back(request);
+        }
+      }
+    }
+    else
+    {
+      if (client.CycleCount == 0 && client.Role != CLIENT_ROLE_QUERY)
+      {
+        request.Name = "LogSubscribe";
+        request.MetaData["LogLevel"] = igsioCommon::ToString<int>(vtkPlusLogger::LOG_LEVEL_INFO);
+        request.MetaData["Batched"] = (client.Role == CLIENT_ROLE_BATCHED_LOG_SUBSCRIBER ? "TRUE" : "FALSE");
+        request.DelayAfterSec = settings.RequestIntervalSec;
+        client.Requests.push_back(request);
+      }
+      const char* queryCommandNames[] = { "GetConfigFiles", "GetRunningServers", "GetServerResourceUsage", "GetConfigFileContents" };
+      for (unsigned int i = 0; i < sizeof(queryCommandNames) / sizeof(queryCommandNames[0]); ++i)
+      {
+        request = CommandRequest();
+        request.Name = queryCommandNames[i];
+        request.DelayAfterSec = settings.RequestIntervalSec;
+        client.Requests.push_back(request);
+      }
+    }
+    client.CycleCount++;
+  }
+
+  //----------------------------------------------------------------------------
+  void ProcessClient(SoakTestClient& client, const SoakTestSettings& settings, std::map<std::string, CommandStatistics>& statistics)
+  {
+    double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    if (client.PendingCommand)
+    {
+      double latencySec = currentTime - client.PendingCommandSendTime;
+      CommandStatistics& commandStatistics = statistics[client.PendingCommandName];
+      if (client.PendingCommand->IsInProgress())
+      {
+        if (latencySec < settings.CommandTimeoutSec)
+        {
+          return;
+        }
+        LOG_WARNING("Command " << client.PendingCommandName << " timed out after " << latencySec << " sec");
+        commandStatistics.TimeoutCount++;
+        commandStatistics.ErrorCount++;
+        commandStatistics.IntervalErrorCount++;
+      }
+      else
+      {
+        commandStatistics.Latency.Add(latencySec);
+        commandStatistics.IntervalLatency.Add(latencySec);
+        if (!client.PendingCommand->GetSuccessful())
+        {
+          LOG_WARNING("Command " << client.PendingCommandName << " failed: " << client.PendingCommand->GetErrorMessage());
+          commandStatistics.ErrorCount++;
+          commandStatistics.IntervalErrorCount++;
+        }
+        else if (client.PendingCommandName == "GetRunningServers")
+        {
+          IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+          client.RunningServerIds.clear();
+          client.PendingCommand->GetResponseMetaDataElement("RunningServers", client.RunningServerIds, encodingType);
+        }
+        else if (client.PendingCommandName == "GetConfigFileContents" && CheckConfigFileContentsResponse(client.PendingCommand) != PLUS_SUCCESS)
+        {
+          commandStatistics.ErrorCount++;
+          commandStatistics.IntervalErrorCount++;
+        }
+      }
+      client.PendingCommand = nullptr;
+    }
+
+    if (currentTime < client.NextCommandTime)
+    {
+      return;
+    }
+    if (client.Requests.empty())
+    {
+      QueueNextRequests(client, settings);
+    }
+
+    CommandRequest request = client.Requests.front();
+    client.Requests.pop_front();
+    if (request.Name == "GetConfigFileContents")
+    {
+      // The launcher returns the config files of running servers only
+      request.MetaData["ServerIDs"] = client.RunningServerIds;
+      request.MetaData["Separator"] = ";";
+    }
+
+    igtlioCommandPointer command = igtlioCommandPointer::New();
+    command->BlockingOff();
+    command->SetName(request.Name);
+    command->SetCommandContent("<Command/>");
+    for (std::map<std::string, std::string>::iterator metaDataIt = request.MetaData.begin(); metaDataIt != request.MetaData.end(); ++metaDataIt)
+    {
+      command->SetCommandMetaDataElement(metaDataIt->first, metaDataIt->second);
+    }
+
+    client.PendingCommandName = request.Name;
+    client.PendingCommandSendTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    client.NextCommandTime = client.PendingCommandSendTime + request.DelayAfterSec;
+    if (client.Connector->SendCommand(command) != 1)
+    {
+      CommandStatistics& commandStatistics = statistics[request.Name];
+      commandStatistics.ErrorCount++;
+      commandStatistics.IntervalErrorCount++;
+      LOG_WARNING("Command " << request.Name << " could not be sent");
+      return;
+    }
+    client.PendingCommand = command;
+  }
+
+  //----------------------------------------------------------------------------
+  void PrintStatistics(std::map<std::string, CommandStatistics>& statistics, bool interval, std::ostream& output)
+  {
+    output << std::setw(24) << std::left << "Command" << std::right
+           << std::setw(10) << "Count" << std::setw(10) << "Errors"
+           << std::setw(12) << "p50 [ms]" << std::setw(12) << "p90 [ms]" << std::setw(12) << "p99 [ms]" << std::setw(12) << "max [ms]" << std::endl;
+    for (std::map<std::string, CommandStatistics>::iterator it = statistics.begin(); it != statistics.end(); ++it)
+    {
+      const LatencyHistogram& latency = interval ? it->second.IntervalLatency : it->second.Latency;
+      output << std::setw(24) << std::left << it->first << std::right
+             << std::setw(10) << latency.GetCount() << std::setw(10) << (interval ? it->second.IntervalErrorCount : it->second.ErrorCount)
+             << std::fixed << std::setprecision(2)
+             << std::setw(12) << latency.GetPercentileSec(50) * 1000.0 << std::setw(12) << latency.GetPercentileSec(90) * 1000.0
+             << std::setw(12) << latency.GetPercentileSec(99) * 1000.0 << std::setw(12) << latency.GetMaxSec() * 1000.0 << std::endl;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  // Needed for monitoring the launcher process
+  QCoreApplication app(argc, argv);
+
+  bool printHelp(false);
+  std::string launcherHost = "127.0.0.1";
+  int launcherPort = 18905;
+  bool startLauncher = true;
+  std::string launcherExecutable;
+  std::string stubServerExecutable;
+  int numberOfClients = 8;
+  int numberOfServers = 4;
+  int firstServerPort = 18950;
+  double durationSec = 60.0;
+  double requestIntervalSec = 0.0;
+  double serverRunSec = 2.0;
+  double commandTimeoutSec = 30.0;
+  double reportIntervalSec = 10.0;
+  double warmUpSec = 10.0;
+  double maxErrorRatePercent = 1.0;
+  double maxMemoryGrowthMb = 0.0;
+  std::string outputCsvFileName;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--host", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &launcherHost, "Host name of the PlusServerLauncher (default: 127.0.0.1)");
+  args.AddArgument("--port", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &launcherPort, "Remote control port of the PlusServerLauncher (default: 18905)");
+  args.AddBooleanArgument("--start-launcher", &startLauncher, "Start the PlusServerLauncher. If disabled then an already running launcher is tested and its memory usage is not measured (default: TRUE)");
+  args.AddArgument("--launcher-executable", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &launcherExecutable, "Path of the PlusServerLauncher executable (default: in the Plus executable directory)");
+  args.AddArgument("--stub-server-executable", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &stubServerExecutable, "Path of the PlusServerStub executable that the launcher starts instead of PlusServer (default: in the Plus executable directory)");
+  args.AddArgument("--clients", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfClients, "Number of concurrent remote control clients (default: 8)");
+  args.AddArgument("--servers", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfServers, "Number of servers that are started and stopped (default: 4)");
+  args.AddArgument("--first-server-port", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &firstServerPort, "Listening port of the first server in the generated config files (default: 18950)");
+  args.AddArgument("--duration-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &durationSec, "Duration of the test (default: 60)");
+  args.AddArgument("--request-interval-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &requestIntervalSec, "Time between a response and the next command of a client (default: 0)");
+  args.AddArgument("--server-run-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &serverRunSec, "Time the servers are kept running before they are stopped (default: 2)");
+  args.AddArgument("--command-timeout-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &commandTimeoutSec, "Commands without response in this time are counted as errors (default: 30)");
+  args.AddArgument("--report-interval-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &reportIntervalSec, "Time between statistics reports (default: 10)");
+  args.AddArgument("--warm-up-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &warmUpSec, "Memory growth is measured from the end of the warm-up period (default: 10)");
+  args.AddArgument("--max-error-rate-percent", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &maxErrorRatePercent, "The test fails if more commands fail (default: 1)");
+  args.AddArgument("--max-memory-growth-mb", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &maxMemoryGrowthMb, "The test fails if the resident memory of the launcher grows more after the warm-up period. 0 = not checked (default: 0)");
+  args.AddArgument("--output-csv-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputCsvFileName, "Write the statistics of each report interval to this file (optional)");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  SoakTestSettings settings;
+  settings.NumberOfClients = std::max(1, numberOfClients);
+  settings.CommandTimeoutSec = commandTimeoutSec;
+  settings.RequestIntervalSec = requestIntervalSec;
+  settings.ServerRunSec = serverRunSec;
+
+  // Start the launcher with generated config files and the stub server
+  QProcess launcherProcess;
+  if (startLauncher)
+  {
+    std::string configFileDirectory = vtkPlusConfig::GetInstance()->GetOutputPath("PlusServerLauncherSoakTestConfigFiles");
+    if (WriteConfigFiles(configFileDirectory, numberOfServers, firstServerPort, settings.ConfigFileNames) != PLUS_SUCCESS)
+    {
+      exit(EXIT_FAILURE);
+    }
+
+    if (launcherExecutable.empty())
+    {
+      launcherExecutable = vtkPlusConfig::GetInstance()->GetPlusExecutablePath("PlusServerLauncher");
+    }
+    if (stubServerExecutable.empty())
+    {
+      stubServerExecutable = vtkPlusConfig::GetInstance()->GetPlusExecutablePath("PlusServerStub");
+    }
+    if (!vtksys::SystemTools::FileExists(launcherExecutable, true) || !vtksys::SystemTools::FileExists(stubServerExecutable, true))
+    {
+      LOG_ERROR("Unable to find executables: " << launcherExecutable << ", " << stubServerExecutable);
+      exit(EXIT_FAILURE);
+    }
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("PLUS_SERVER_LAUNCHER_SERVER_EXECUTABLE", QString::fromStdString(stubServerExecutable));
+    if (!environment.contains("QT_QPA_PLATFORM"))
+    {
+      // Run without display
+      environment.insert("QT_QPA_PLATFORM", "offscreen");
+    }
+    launcherProcess.setProcessEnvironment(environment);
+    launcherProcess.setStandardOutputFile(QString::fromStdString(vtkPlusConfig::GetInstance()->GetOutputPath("PlusServerLauncherSoakTestLauncherOutput.txt")));
+    launcherProcess.setStandardErrorFile(QString::fromStdString(vtkPlusConfig::GetInstance()->GetOutputPath("PlusServerLauncherSoakTestLauncherOutput.txt")), QIODevice::Append);
+
+    QStringList launcherArguments;
+    launcherArguments << QString("--device-set-configuration-dir=%1").arg(QString::fromStdString(configFileDirectory));
+    launcherArguments << QString("--port=%1").arg(launcherPort);
+    launcherProcess.start(QString::fromStdString(launcherExecutable), launcherArguments);
+    if (!launcherProcess.waitForStarted(10000))
+    {
+      LOG_ERROR("Failed to start PlusServerLauncher: " << launcherExecutable);
+      exit(EXIT_FAILURE);
+    }
+    LOG_INFO("PlusServerLauncher started");
+  }
+  else
+  {
+    for (int i = 0; i < numberOfServers; ++i)
+    {
+      settings.ConfigFileNames.push_back("PlusDeviceSet_Server_SoakTest" + igsioCommon::ToString<int>(i + 1) + ".xml");
+    }
+  }
+
+  // Connect the clients
+  igtlioLogicPointer logic = igtlioLogicPointer::New();
+  vtkSmartPointer<vtkCallbackCommand> commandReceivedCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+  commandReceivedCallback->SetCallback(OnCommandReceived);
+  logic->AddObserver(igtlioCommand::CommandReceivedEvent, commandReceivedCallback);
+
+  std::vector<SoakTestClient> clients(settings.NumberOfClients);
+  for (int i = 0; i < settings.NumberOfClients; ++i)
+  {
+    SoakTestClient& client = clients[i];
+    client.Connector = logic->CreateConnector();
+    client.Connector->SetTypeClient(launcherHost, launcherPort);
+    client.Connector->Start();
+    if (i == 0)
+    {
+      client.Role = CLIENT_ROLE_SERVER_CONTROL;
+    }
+    else if (i % 2 == 0)
+    {
+      client.Role = (i % 4 == 0 ? CLIENT_ROLE_BATCHED_LOG_SUBSCRIBER : CLIENT_ROLE_LOG_SUBSCRIBER);
+    }
+  }
+
+  const double connectTimeoutSec = 30.0;
+  double connectStartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  bool allConnected = false;
+  while (!allConnected && vtkIGSIOAccurateTimer::GetSystemTime() - connectStartTime < connectTimeoutSec)
+  {
+    logic->PeriodicProcess();
+    vtkIGSIOAccurateTimer::Delay(0.01);
+    allConnected = true;
+    for (std::vector<SoakTestClient>::iterator clientIt = clients.begin(); clientIt != clients.end(); ++clientIt)
+    {
+      if (!clientIt->Connector->IsConnected())
+      {
+        allConnected = false;
+      }
+    }
+  }
+  if (!allConnected)
+  {
+    LOG_ERROR("Failed to connect all clients to PlusServerLauncher at " << launcherHost << ":" << launcherPort);
+    launcherProcess.kill();
+    launcherProcess.waitForFinished();
+    exit(EXIT_FAILURE);
+  }
+  LOG_INFO(settings.NumberOfClients << " clients connected to PlusServerLauncher at " << launcherHost << ":" << launcherPort);
+
+  std::ofstream outputCsv;
+  if (!outputCsvFileName.empty())
+  {
+    outputCsv.open(outputCsvFileName.c_str());
+    outputCsv << "TimeSec,CommandCount,ErrorCount,P50LatencyMs,P99LatencyMs,MaxLatencyMs,LauncherResidentMemoryMb,ReceivedLogCommandCount" << std::endl;
+  }
+
+  // Run the test
+  std::map<std::string, CommandStatistics> statistics;
+  double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  double nextReportTime = startTime + reportIntervalSec;
+  double warmUpMemoryBytes = 0.0;
+  double lastMemoryBytes = 0.0;
+  bool launcherExitedEarly = false;
+  while (vtkIGSIOAccurateTimer::GetSystemTime() - startTime < durationSec)
+  {
+    QCoreApplication::processEvents();
+    logic->PeriodicProcess();
+    for (std::vector<SoakTestClient>::iterator clientIt = clients.begin(); clientIt != clients.end(); ++clientIt)
+    {
+      ProcessClient(*clientIt, settings, statistics);
+    }
+
+    double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    if (startLauncher && launcherProcess.state() != QProcess::Running)
+    {
+      LOG_ERROR("PlusServerLauncher stopped unexpectedly after " << currentTime - startTime << " sec");
+      launcherExitedEarly = true;
+      break;
+    }
+    if (startLauncher)
+    {
+      if (warmUpMemoryBytes == 0.0 && currentTime - startTime >= warmUpSec)
+      {
+        warmUpMemoryBytes = GetProcessResidentMemoryBytes(launcherProcess.processId());
+      }
+    }
+
+    if (currentTime >= nextReportTime)
+    {
+      nextReportTime += reportIntervalSec;
+      lastMemoryBytes = startLauncher ? GetProcessResidentMemoryBytes(launcherProcess.processId()) : 0.0;
+
+      LatencyHistogram intervalLatency;
+      unsigned long intervalErrorCount = 0;
+      for (std::map<std::string, CommandStatistics>::iterator it = statistics.begin(); it != statistics.end(); ++it)
+      {
+        intervalLatency.Merge(it->second.IntervalLatency);
+        intervalErrorCount += it->second.IntervalErrorCount;
+      }
+
+      std::ostringstream report;
+      report << "Statistics at " << std::fixed << std::setprecision(1) << currentTime - startTime << " sec, launcher memory: "
+             << lastMemoryBytes / 1024.0 / 1024.0 << " MB, received log commands: " << ReceivedLogCommandCount << std::endl;
+      PrintStatistics(statistics, true, report);
+      LOG_INFO(report.str());
+
+      if (outputCsv.is_open())
+      {
+        outputCsv << currentTime - startTime << "," << intervalLatency.GetCount() << "," << intervalErrorCount << ","
+                  << intervalLatency.GetPercentileSec(50) * 1000.0 << "," << intervalLatency.GetPercentileSec(99) * 1000.0 << ","
+                  << intervalLatency.GetMaxSec() * 1000.0 << "," << lastMemoryBytes / 1024.0 / 1024.0 << "," << ReceivedLogCommandCount << std::endl;
+      }
+
+      for (std::map<std::string, CommandStatistics>::iterator it = statistics.begin(); it != statistics.end(); ++it)
+      {
+        it->second.IntervalLatency.Reset();
+        it->second.IntervalErrorCount = 0;
+      }
+    }
+
+    vtkIGSIOAccurateTimer::Delay(0.001);
+  }
+  if (startLauncher && !launcherExitedEarly)
+  {
+    lastMemoryBytes = GetProcessResidentMemoryBytes(launcherProcess.processId());
+  }
+
+  // Final report
+  unsigned long commandCount = 0;
+  unsigned long errorCount = 0;
+  for (std::map<std::string, CommandStatistics>::iterator it = statistics.begin(); it != statistics.end(); ++it)
+  {
+    commandCount += it->second.Latency.GetCount() + it->second.TimeoutCount;
+    errorCount += it->second.ErrorCount;
+  }
+  double errorRatePercent = commandCount > 0 ? 100.0 * errorCount / commandCount : 0.0;
+  double memoryGrowthMb = (warmUpMemoryBytes > 0.0 && lastMemoryBytes > 0.0) ? (lastMemoryBytes - warmUpMemoryBytes) / 1024.0 / 1024.0 : 0.0;
+
+  std::ostringstream report;
+  report << "Final statistics after " << std::fixed << std::setprecision(1) << vtkIGSIOAccurateTimer::GetSystemTime() - startTime << " sec with " << settings.NumberOfClients << " clients:" << std::endl;
+  PrintStatistics(statistics, false, report);
+  report << "Commands: " << commandCount << ", errors: " << errorCount << " (" << std::setprecision(2) << errorRatePercent << "%)"
+         << ", received log commands: " << ReceivedLogCommandCount << ", received config file contents: " << ReceivedConfigFileContentCount << std::endl;
+  if (startLauncher)
+  {
+    report << "Launcher memory: " << lastMemoryBytes / 1024.0 / 1024.0 << " MB, growth after warm-up: " << memoryGrowthMb << " MB" << std::endl;
+  }
+  LOG_INFO(report.str());
+
+  // Shut down
+  for (std::vector<SoakTestClient>::iterator clientIt = clients.begin(); clientIt != clients.end(); ++clientIt)
+  {
+    clientIt->Connector->Stop();
+  }
+  if (startLauncher && launcherProcess.state() == QProcess::Running)
+  {
+    // The launcher stops its servers when it is closed
+    launcherProcess.terminate();
+    if (!launcherProcess.waitForFinished(15000))
+    {
+      launcherProcess.kill();
+      launcherProcess.waitForFinished();
+    }
+  }
+
+  int exitCode = EXIT_SUCCESS;
+  if (launcherExitedEarly)
+  {
+    exitCode = EXIT_FAILURE;
+  }
+  if (commandCount == 0 || errorRatePercent > maxErrorRatePercent)
+  {
+    LOG_ERROR("Error rate " << errorRatePercent << "% exceeds the limit of " << maxErrorRatePercent << "% (" << commandCount << " commands)");
+    exitCode = EXIT_FAILURE;
+  }
+  if (ReceivedConfigFileContentCount == 0)
+  {
+    LOG_ERROR("No config file contents were received from the launcher");
+    exitCode = EXIT_FAILURE;
+  }
+  if (maxMemoryGrowthMb > 0.0 && memoryGrowthMb > maxMemoryGrowthMb)
+  {
+    LOG_ERROR("Launcher memory grew by " << memoryGrowthMb << " MB, which exceeds the limit of " << maxMemoryGrowthMb << " MB");
+    exitCode = EXIT_FAILURE;
+  }
+  return exitCode;
+}
@@ -0,0 +1,129 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file PlusServerStub.cxx
+\brief Stand-in for PlusServer that does not connect to any devices
+
+Writes the same log output as PlusServer, so that PlusServerLauncher can be tested
+on machines without hardware. PlusServerLauncher uses this executable instead of PlusServer if
+the PLUS_SERVER_LAUNCHER_SERVER_EXECUTABLE environment variable is set to its path.
+
+The behavior can be changed using environment variables:
+- PLUS_SERVER_STUB_STARTUP_DELAY_MSEC: time until the server reports that it is running (default: 500)
+- PLUS_SERVER_STUB_LOG_INTERVAL_MSEC: a log message is written at this interval (default: 100)
+*/
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+  std::atomic<bool> StopRequested(false);
+
+  //----------------------------------------------------------------------------
+  void SignalHandler(int)
+  {
+    StopRequested = true;
+  }
+
+  //----------------------------------------------------------------------------
+  int GetEnvInt(const char* name, int defaultValue)
+  {
+    const char* value = getenv(name);
+    if (value == NULL || value[0] == 0)
+    {
+      return defaultValue;
+    }
+    return atoi(value);
+  }
+
+  //----------------------------------------------------------------------------
+  // Report the port of the first PlusOpenIGTLinkServer element, as PlusServer would
+  int GetListeningPortFromConfigFile(const std::string& configFileName, int defaultPort)
+  {
+    std::ifstream configFile(configFileName.c_str());
+    std::stringstream content;
+    content << configFile.rdbuf();
+    const std::string attributeName = "ListeningPort=\"";
+    std::string::size_type position = content.str().find(attributeName);
+    if (position == std::string::npos)
+    {
+      return defaultPort;
+    }
+    return atoi(content.str().c_str() + position + attributeName.size());
+  }
+
+  //----------------------------------------------------------------------------
+  // Same format as the PlusServer log output: |LEVEL|timestamp| message| in file(line)
+  void Log(const char* level, double timeSec, const std::string& message, int line)
+  {
+    fprintf(stdout, "|%s|%.6f| %s| in %s(%d)\n", level, timeSec, message.c_str(), __FILE__, line);
+    fflush(stdout);
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  std::string configFileName;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strncmp(argv[i], "--config-file=", 14) == 0)
+    {
+      configFileName = argv[i] + 14;
+    }
+  }
+  const int listeningPort = GetListeningPortFromConfigFile(configFileName, 18944);
+
+  signal(SIGINT, SignalHandler);
+  signal(SIGTERM, SignalHandler);
+
+  const int startupDelayMsec = GetEnvInt("PLUS_SERVER_STUB_STARTUP_DELAY_MSEC", 500);
+  const int logIntervalMsec = GetEnvInt("PLUS_SERVER_STUB_LOG_INTERVAL_MSEC", 100);
+  const int pollIntervalMsec = 10;
+
+  const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  Log("INFO", 0.0, std::string("Starting stub server with config file: ") + configFileName, __LINE__);
+
+  bool running = false;
+  double lastLogTimeSec = 0.0;
+  unsigned long messageCount = 0;
+  while (!StopRequested)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(pollIntervalMsec));
+    const double timeSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (!running && timeSec * 1000.0 >= startupDelayMsec)
+    {
+      running = true;
+      Log("INFO", timeSec, std::string("Plus OpenIGTLink server listening on IPs: 127.0.0.1 -- port ") + std::to_string(listeningPort), __LINE__);
+      Log("INFO", timeSec, "Server status: Server(s) are running.", __LINE__);
+    }
+    if (!running)
+    {
+      continue;
+    }
+
+    if (logIntervalMsec > 0 && (timeSec - lastLogTimeSec) * 1000.0 >= logIntervalMsec)
+    {
+      lastLogTimeSec = timeSec;
+      Log("INFO", timeSec, std::string("Stub server message ") + std::to_string(++messageCount), __LINE__);
+    }
+  }
+
+  const double timeSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  Log("INFO", timeSec, "Shutdown signal received", __LINE__);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,224 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "QPlusFrameProfiler.h"
+
+// PlusLib includes
+#include <vtkIGSIOAccurateTimer.h>
+
+// Qt includes
+#include <QMutexLocker>
+#include <QThread>
+
+// STL includes
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Write a string as a JSON string literal
+  void WriteJsonString(std::ostream& aStream, const char* aString)
+  {
+    aStream << '"';
+    for (const char* c = aString; *c != '\0'; ++c)
+    {
+      if (*c == '"' || *c == '\\')
+      {
+        aStream << '\\';
+      }
+      aStream << *c;
+    }
+    aStream << '"';
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+const unsigned int QPlusFrameProfiler::MAX_NUMBER_OF_TRACE_EVENTS = 200000;
+
+//-----------------------------------------------------------------------------
+QPlusFrameProfiler::Scope::Scope(const char* aName)
+  : m_Name(aName)
+  , m_StartTimeSec(-1.0)
+{
+  if (QPlusFrameProfiler::GetInstance()->IsEnabled())
+  {
+    m_StartTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  }
+}
+
+//-----------------------------------------------------------------------------
+QPlusFrameProfiler::Scope::~Scope()
+{
+  if (m_StartTimeSec >= 0.0)
+  {
+    QPlusFrameProfiler::GetInstance()->RecordScope(m_Name, m_StartTimeSec, vtkIGSIOAccurateTimer::GetSystemTime());
+  }
+}
+
+//-----------------------------------------------------------------------------
+QPlusFrameProfiler* QPlusFrameProfiler::GetInstance()
+{
+  static QPlusFrameProfiler instance;
+  return &instance;
+}
+
+//-----------------------------------------------------------------------------
+QPlusFrameProfiler::QPlusFrameProfiler()
+  : m_Enabled(false)
+  , m_TraceStartTimeSec(0.0)
+{
+}
+
+//-----------------------------------------------------------------------------
+QPlusFrameProfiler::~QPlusFrameProfiler()
+{
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameProfiler::SetEnabled(bool aEnabled)
+{
+  QMutexLocker locker(&m_Mutex);
+  if (aEnabled && !m_Enabled)
+  {
+    m_TraceStartTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    m_TraceEvents.clear();
+    m_Statistics.clear();
+  }
+  m_Enabled = aEnabled;
+}
+
+//-----------------------------------------------------------------------------
+bool QPlusFrameProfiler::IsEnabled() const
+{
+  return m_Enabled;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameProfiler::RecordScope(const char* aName, double aStartTimeSec, double aEndTimeSec)
+{
+  QMutexLocker locker(&m_Mutex);
+  if (!m_Enabled)
+  {
+    return;
+  }
+
+  double durationSec = aEndTimeSec - aStartTimeSec;
+
+  ScopeStatistics& statistics = m_Statistics[aName];
+  statistics.Count++;
+  statistics.TotalSec += durationSec;
+  statistics.MaxSec = std::max(statistics.MaxSec, durationSec);
+
+  if (m_TraceEvents.size() >= MAX_NUMBER_OF_TRACE_EVENTS)
+  {
+    m_TraceEvents.pop_front();
+  }
+  TraceEvent traceEvent;
+  traceEvent.Name = aName;
+  traceEvent.StartTimeSec = aStartTimeSec;
+  traceEvent.DurationSec = durationSec;
+  traceEvent.ThreadIndex = GetCurrentThreadIndex();
+  m_TraceEvents.push_back(traceEvent);
+}
+
+//-----------------------------------------------------------------------------
+int QPlusFrameProfiler::GetCurrentThreadIndex()
+{
+  Qt::HANDLE threadId = QThread::currentThreadId();
+  std::map<Qt::HANDLE, int>::iterator threadIt = m_ThreadIndices.find(threadId);
+  if (threadIt != m_ThreadIndices.end())
+  {
+    return threadIt->second;
+  }
+  int threadIndex = static_cast<int>(m_ThreadIndices.size());
+  m_ThreadIndices[threadId] = threadIndex;
+  return threadIndex;
+}
+
+//-----------------------------------------------------------------------------
+std::string QPlusFrameProfiler::GetStatisticsText(int aMaxNumberOfLines, bool aReset)
+{
+  std::vector<std::pair<std::string, ScopeStatistics> > scopes;
+  {
+    QMutexLocker locker(&m_Mutex);
+    scopes.assign(m_Statistics.begin(), m_Statistics.end());
+    if (aReset)
+    {
+      m_Statistics.clear();
+    }
+  }
+
+  std::sort(scopes.begin(), scopes.end(), CompareTotalTimeDescending);
+
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(1);
+  for (int i = 0; i < static_cast<int>(scopes.size()) && i < aMaxNumberOfLines; ++i)
+  {
+    const ScopeStatistics& statistics = scopes[i].second;
+    if (i > 0)
+    {
+      text << std::endl;
+    }
+    text << scopes[i].first << ": " << statistics.TotalSec / statistics.Count * 1000.0 << " ms"
+         << " (max " << statistics.MaxSec * 1000.0 << " ms, " << statistics.Count << "x)";
+  }
+  return text.str();
+}
+
+//-----------------------------------------------------------------------------
+bool QPlusFrameProfiler::CompareTotalTimeDescending(const std::pair<std::string, ScopeStatistics>& a, const std::pair<std::string, ScopeStatistics>& b)
+{
+  return a.second.TotalSec > b.second.TotalSec;
+}
+
+//-----------------------------------------------------------------------------
+int QPlusFrameProfiler::GetNumberOfTraceEvents() const
+{
+  QMutexLocker locker(&m_Mutex);
+  return static_cast<int>(m_TraceEvents.size());
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QPlusFrameProfiler::WriteTrace(const std::string& aFilename) const
+{
+  LOG_TRACE("QPlusFrameProfiler::WriteTrace(" << aFilename << ")");
+
+  std::ofstream traceFile(aFilename.c_str(), std::ios::out | std::ios::trunc);
+  if (!traceFile.is_open())
+  {
+    LOG_ERROR("Unable to open file for writing the frame profile: " << aFilename);
+    return PLUS_FAIL;
+  }
+
+  QMutexLocker locker(&m_Mutex);
+
+  // Complete events ("X") with timestamps and durations in microseconds, relative to the start of the trace
+  traceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+  traceFile << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"fCal\"}}";
+  traceFile << std::fixed << std::setprecision(3);
+  for (std::deque<TraceEvent>::const_iterator eventIt = m_TraceEvents.begin(); eventIt != m_TraceEvents.end(); ++eventIt)
+  {
+    traceFile << "," << std::endl << "{\"name\":";
+    WriteJsonString(traceFile, eventIt->Name);
+    traceFile << ",\"cat\":\"fCal\",\"ph\":\"X\",\"pid\":0,\"tid\":" << eventIt->ThreadIndex
+              << ",\"ts\":" << (eventIt->StartTimeSec - m_TraceStartTimeSec) * 1000000.0
+              << ",\"dur\":" << eventIt->DurationSec * 1000000.0 << "}";
+  }
+  traceFile << std::endl << "]}" << std::endl;
+
+  if (!traceFile.good())
+  {
+    LOG_ERROR("Failed to write the frame profile into file: " << aFilename);
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
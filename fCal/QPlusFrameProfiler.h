@@ -0,0 +1,126 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __QPlusFrameProfiler_h
+#define __QPlusFrameProfiler_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// Qt includes
+#include <QMutex>
+
+// STL includes
+#include <atomic>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+/*! \class QPlusFrameProfiler
+\brief Measures the time spent in instrumented parts of fCal (GUI update, toolbox refresh, rendering, segmentation, calibration)
+
+Code sections are instrumented by creating a QPlusFrameProfiler::Scope object at their beginning, it records the elapsed
+time when it goes out of scope. While the profiler is disabled a scope only checks a flag, so the instrumentation can stay
+in the code. The recorded durations are accumulated per scope name for the frame statistics overlay, and the individual
+events are kept in a bounded buffer (the oldest events are dropped) that can be written in Chrome trace event format,
+which can be opened in chrome://tracing or Perfetto.
+
+Scopes can be recorded from any thread.
+
+\ingroup PlusAppFCal
+*/
+class QPlusFrameProfiler
+{
+public:
+  /*! Records the time spent between its construction and destruction if the profiler is enabled */
+  class Scope
+  {
+  public:
+    /*! \param aName Name of the scope, must be a string literal (it is stored without copying) */
+    Scope(const char* aName);
+    ~Scope();
+  protected:
+    const char* m_Name;
+    double      m_StartTimeSec;
+  private:
+    Scope(const Scope&);
+    void operator=(const Scope&);
+  };
+
+  /*! Get the profiler of the application */
+  static QPlusFrameProfiler* GetInstance();
+
+  /*! Enable/disable recording. Enabling starts a new trace and clears the statistics. */
+  void SetEnabled(bool aEnabled);
+  bool IsEnabled() const;
+
+  /*! Record a finished scope, normally called by Scope */
+  void RecordScope(const char* aName, double aStartTimeSec, double aEndTimeSec);
+
+  /*!
+  * Get the statistics of the scopes recorded since the previous reset, one line per scope, the slowest first
+  * \param aMaxNumberOfLines Maximum number of scopes to list
+  * \param aReset If true then the statistics are cleared
+  */
+  std::string GetStatisticsText(int aMaxNumberOfLines, bool aReset);
+
+  /*! Get the number of events in the trace buffer */
+  int GetNumberOfTraceEvents() const;
+
+  /*! Write the trace buffer into a JSON file in Chrome trace event format */
+  PlusStatus WriteTrace(const std::string& aFilename) const;
+
+protected:
+  QPlusFrameProfiler();
+  virtual ~QPlusFrameProfiler();
+
+  /*! Get a small thread index for the trace, must be called with the mutex locked */
+  int GetCurrentThreadIndex();
+
+protected:
+  struct TraceEvent
+  {
+    const char* Name;
+    double      StartTimeSec;
+    double      DurationSec;
+    int         ThreadIndex;
+  };
+
+  struct ScopeStatistics
+  {
+    ScopeStatistics()
+      : Count(0)
+      , TotalSec(0.0)
+      , MaxSec(0.0)
+    {
+    }
+    int     Count;
+    double  TotalSec;
+    double  MaxSec;
+  };
+
+  /*! Sort order of the scopes in the statistics text */
+  static bool CompareTotalTimeDescending(const std::pair<std::string, ScopeStatistics>& a, const std::pair<std::string, ScopeStatistics>& b);
+
+  /*! Maximum number of events kept in the trace buffer */
+  static const unsigned int MAX_NUMBER_OF_TRACE_EVENTS;
+
+  std::atomic<bool>                       m_Enabled;
+
+  /*! Protects all the members below */
+  mutable QMutex                          m_Mutex;
+  double                                  m_TraceStartTimeSec;
+  std::deque<TraceEvent>                  m_TraceEvents;
+  std::map<std::string, ScopeStatistics>  m_Statistics;
+  std::map<Qt::HANDLE, int>               m_ThreadIndices;
+
+private:
+  QPlusFrameProfiler(const QPlusFrameProfiler&);
+  void operator=(const QPlusFrameProfiler&);
+};
+
+#endif // __QPlusFrameProfiler_h
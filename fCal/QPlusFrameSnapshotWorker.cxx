@@ -0,0 +1,272 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "QPlusFrameSnapshotWorker.h"
+
+// PlusLib includes
+#include <igsioTrackedFrame.h>
+#include <vtkIGSIOAccurateTimer.h>
+#include <vtkPlusChannel.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+
+// Qt includes
+#include <QMutexLocker>
+#include <QTimer>
+
+//-----------------------------------------------------------------------------
+QPlusFrameSnapshotWorker::QPlusFrameSnapshotWorker(QObject* aParent)
+  : QObject(aParent)
+  , m_Channel(NULL)
+  , m_LatestTimestamp(UNDEFINED_TIMESTAMP)
+  , m_TransformRepositoryVersion(-1)
+  , m_PollTimer(NULL)
+{
+}
+
+//-----------------------------------------------------------------------------
+QPlusFrameSnapshotWorker::~QPlusFrameSnapshotWorker()
+{
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameSnapshotWorker::SetChannel(vtkPlusChannel* aChannel)
+{
+  QMutexLocker channelLocker(&m_ChannelMutex);
+  m_Channel = aChannel;
+  m_LatestTimestamp = UNDEFINED_TIMESTAMP;
+
+  // Do not show the transforms of the previous channel
+  QMutexLocker snapshotLocker(&m_SnapshotMutex);
+  m_LatestSnapshot.reset();
+}
+
+//-----------------------------------------------------------------------------
+QPlusFrameSnapshotWorker::SnapshotConstPtr QPlusFrameSnapshotWorker::GetLatestSnapshot() const
+{
+  QMutexLocker snapshotLocker(&m_SnapshotMutex);
+  return m_LatestSnapshot;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameSnapshotWorker::SetWatchedChannels(const std::vector<vtkPlusChannel*>& aChannels)
+{
+  QMutexLocker channelLocker(&m_ChannelMutex);
+  m_WatchedChannelTimestamps.clear();
+  for (std::vector<vtkPlusChannel*>::const_iterator channelIt = aChannels.begin(); channelIt != aChannels.end(); ++channelIt)
+  {
+    m_WatchedChannelTimestamps[*channelIt] = UNDEFINED_TIMESTAMP;
+  }
+
+  QMutexLocker snapshotLocker(&m_SnapshotMutex);
+  m_LatestWatchedTimestamps = m_WatchedChannelTimestamps;
+}
+
+//-----------------------------------------------------------------------------
+double QPlusFrameSnapshotWorker::GetLatestWatchedTimestamp(vtkPlusChannel* aChannel) const
+{
+  QMutexLocker snapshotLocker(&m_SnapshotMutex);
+  std::map<vtkPlusChannel*, double>::const_iterator timestampIt = m_LatestWatchedTimestamps.find(aChannel);
+  return (timestampIt != m_LatestWatchedTimestamps.end() ? timestampIt->second : UNDEFINED_TIMESTAMP);
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameSnapshotWorker::SetTransformRepository(vtkIGSIOTransformRepository* aRepository, int aVersion)
+{
+  // Copy before locking, so the poll is not held up by the copy
+  vtkSmartPointer<vtkIGSIOTransformRepository> repository;
+  if (aRepository != NULL)
+  {
+    repository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    if (repository->DeepCopy(aRepository) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Unable to copy the transform repository, the transforms are computed by the GUI");
+      repository = NULL;
+    }
+  }
+
+  QMutexLocker channelLocker(&m_ChannelMutex);
+  m_TransformRepository = repository;
+  m_TransformRepositoryVersion = aVersion;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameSnapshotWorker::AddResolvedTransformName(const igsioTransformName& aName)
+{
+  QMutexLocker channelLocker(&m_ChannelMutex);
+  for (std::vector<igsioTransformName>::iterator nameIt = m_ResolvedTransformNames.begin(); nameIt != m_ResolvedTransformNames.end(); ++nameIt)
+  {
+    if (nameIt->From() == aName.From() && nameIt->To() == aName.To())
+    {
+      return;
+    }
+  }
+  m_ResolvedTransformNames.push_back(aName);
+}
+
+//-----------------------------------------------------------------------------
+const QPlusFrameSnapshotWorker::Snapshot::ResolvedTransformEntry* QPlusFrameSnapshotWorker::Snapshot::FindResolvedTransform(const igsioTransformName& aName) const
+{
+  for (std::vector<ResolvedTransformEntry>::const_iterator transformIt = ResolvedTransforms.begin(); transformIt != ResolvedTransforms.end(); ++transformIt)
+  {
+    if (transformIt->Name.From() == aName.From() && transformIt->Name.To() == aName.To())
+    {
+      return &(*transformIt);
+    }
+  }
+  return NULL;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QPlusFrameSnapshotWorker::CreateSnapshot(vtkPlusChannel* aChannel, double aTimestamp, SnapshotConstPtr& aSnapshot)
+{
+  return CreateSnapshot(aChannel, aTimestamp, NULL, -1, std::vector<igsioTransformName>(), aSnapshot);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QPlusFrameSnapshotWorker::CreateSnapshot(vtkPlusChannel* aChannel, double aTimestamp, vtkIGSIOTransformRepository* aRepository, int aRepositoryVersion,
+    const std::vector<igsioTransformName>& aResolvedTransformNames, SnapshotConstPtr& aSnapshot)
+{
+  igsioTrackedFrame trackedFrame;
+  if (aChannel->GetTrackedFrame(aTimestamp, trackedFrame, false) != PLUS_SUCCESS)
+  {
+    LOG_DEBUG("Unable to get tracked frame at timestamp " << std::fixed << aTimestamp << " from the channel");
+    return PLUS_FAIL;
+  }
+
+  std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+  snapshot->Timestamp = aTimestamp;
+
+  std::vector<igsioTransformName> transformNames;
+  trackedFrame.GetFrameTransformNameList(transformNames);
+  snapshot->Transforms.reserve(transformNames.size());
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (std::vector<igsioTransformName>::iterator nameIt = transformNames.begin(); nameIt != transformNames.end(); ++nameIt)
+  {
+    Snapshot::TransformEntry entry;
+    entry.Name = *nameIt;
+    if (trackedFrame.GetFrameTransform(entry.Name, matrix) != IGSIO_SUCCESS)
+    {
+      continue;
+    }
+    vtkMatrix4x4::DeepCopy(entry.Matrix, matrix);
+    trackedFrame.GetFrameTransformStatus(entry.Name, entry.Status);
+    snapshot->Transforms.push_back(entry);
+  }
+
+  if (aRepository != NULL)
+  {
+    for (std::vector<Snapshot::TransformEntry>::iterator transformIt = snapshot->Transforms.begin(); transformIt != snapshot->Transforms.end(); ++transformIt)
+    {
+      matrix->DeepCopy(transformIt->Matrix);
+      if (aRepository->SetTransform(transformIt->Name, matrix, transformIt->Status) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Unable to set transforms from tracked frame!");
+        return PLUS_FAIL;
+      }
+    }
+
+    snapshot->TransformRepositoryVersion = aRepositoryVersion;
+    snapshot->ResolvedTransforms.reserve(aResolvedTransformNames.size());
+    for (std::vector<igsioTransformName>::const_iterator nameIt = aResolvedTransformNames.begin(); nameIt != aResolvedTransformNames.end(); ++nameIt)
+    {
+      Snapshot::ResolvedTransformEntry entry;
+      entry.Name = *nameIt;
+      entry.Exists = (aRepository->IsExistingTransform(entry.Name) == IGSIO_SUCCESS && aRepository->GetTransform(entry.Name, matrix, &entry.Status) == IGSIO_SUCCESS);
+      if (entry.Exists)
+      {
+        vtkMatrix4x4::DeepCopy(entry.Matrix, matrix);
+      }
+      snapshot->ResolvedTransforms.push_back(entry);
+    }
+  }
+  snapshot->CreationTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+
+  aSnapshot = snapshot;
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameSnapshotWorker::Start(int aPollingIntervalMsec)
+{
+  LOG_TRACE("QPlusFrameSnapshotWorker::Start(" << aPollingIntervalMsec << ")");
+
+  if (m_PollTimer == NULL)
+  {
+    m_PollTimer = new QTimer(this);
+    m_PollTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_PollTimer, &QTimer::timeout, this, &QPlusFrameSnapshotWorker::Poll);
+  }
+  m_PollTimer->start(aPollingIntervalMsec);
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameSnapshotWorker::Stop()
+{
+  LOG_TRACE("QPlusFrameSnapshotWorker::Stop");
+
+  if (m_PollTimer != NULL)
+  {
+    m_PollTimer->stop();
+    delete m_PollTimer;
+    m_PollTimer = NULL;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void QPlusFrameSnapshotWorker::Poll()
+{
+  bool published(false);
+  {
+    QMutexLocker channelLocker(&m_ChannelMutex);
+
+    // Checking the timestamp is cheap, the frame is only fetched if it is new
+    bool newFrame(false);
+    double timestamp(UNDEFINED_TIMESTAMP);
+    SnapshotConstPtr snapshot;
+    if (m_Channel != NULL && m_Channel->GetMostRecentTimestamp(timestamp) == PLUS_SUCCESS && timestamp != m_LatestTimestamp
+        && CreateSnapshot(m_Channel, timestamp, m_TransformRepository, m_TransformRepositoryVersion, m_ResolvedTransformNames, snapshot) == PLUS_SUCCESS)
+    {
+      m_LatestTimestamp = timestamp;
+      newFrame = true;
+    }
+
+    // Only the timestamps of the watched channels are needed, the images are fetched by the GUI when it shows them
+    bool newWatchedFrame(false);
+    for (std::map<vtkPlusChannel*, double>::iterator watchedIt = m_WatchedChannelTimestamps.begin(); watchedIt != m_WatchedChannelTimestamps.end(); ++watchedIt)
+    {
+      double watchedTimestamp(UNDEFINED_TIMESTAMP);
+      if (watchedIt->first->GetMostRecentTimestamp(watchedTimestamp) == PLUS_SUCCESS && watchedTimestamp != watchedIt->second)
+      {
+        watchedIt->second = watchedTimestamp;
+        newWatchedFrame = true;
+      }
+    }
+
+    // Publish while the channel is locked, so a snapshot of a previous channel cannot overwrite the reset in SetChannel
+    if (newFrame || newWatchedFrame)
+    {
+      QMutexLocker snapshotLocker(&m_SnapshotMutex);
+      if (newFrame)
+      {
+        m_LatestSnapshot = snapshot;
+      }
+      if (newWatchedFrame)
+      {
+        m_LatestWatchedTimestamps = m_WatchedChannelTimestamps;
+      }
+      published = true;
+    }
+  }
+
+  if (published)
+  {
+    emit SnapshotReady();
+  }
+}
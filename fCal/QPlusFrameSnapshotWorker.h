@@ -0,0 +1,191 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __QPlusFrameSnapshotWorker_h
+#define __QPlusFrameSnapshotWorker_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+#include <igsioTransformName.h>
+#include <vtkIGSIOTransformRepository.h>
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// Qt includes
+#include <QMutex>
+#include <QObject>
+
+// STL includes
+#include <map>
+#include <memory>
+#include <vector>
+
+class vtkPlusChannel;
+
+class QTimer;
+
+/*! \class QPlusFrameSnapshotWorker
+\brief Polls the selected channel on a worker thread and publishes the transforms of each new tracked frame
+
+The worker is moved to its own thread by its owner. It checks the most recent timestamp of the channel at every polling
+interval and, if a new frame has arrived, fetches the transforms of that frame (without the image data) into an immutable
+snapshot. The GUI thread is notified by the SnapshotReady signal and reads the snapshot by GetLatestSnapshot().
+If the GUI is slower than the data, intermediate snapshots are simply replaced, so the notifications never pile up.
+
+The transforms requested by AddResolvedTransformName() are computed into the snapshot as well, from the frame transforms
+and a copy of the transform repository of the GUI (SetTransformRepository()), so the GUI does not have to search the
+transform graph for them.
+
+Additional channels (e.g., the channels shown in the tiles of the tiled view) can be watched as well. For these only the
+timestamp of the most recent frame is published, so the GUI can tell which of them have a new frame to show.
+
+\ingroup PlusAppFCal
+*/
+class QPlusFrameSnapshotWorker : public QObject
+{
+  Q_OBJECT
+
+public:
+  /*! Transforms of one tracked frame. Not modified after it is published, so it can be read from any thread. */
+  class Snapshot
+  {
+  public:
+    struct TransformEntry
+    {
+      TransformEntry()
+        : Status(TOOL_INVALID)
+      {
+      }
+      igsioTransformName  Name;
+      double              Matrix[16];
+      ToolStatus          Status;
+    };
+
+    struct ResolvedTransformEntry : public TransformEntry
+    {
+      ResolvedTransformEntry()
+        : Exists(false)
+      {
+      }
+      /*! False if the transform cannot be computed from the transforms of the repository */
+      bool                Exists;
+    };
+
+    Snapshot()
+      : Timestamp(0.0)
+      , CreationTimeSec(0.0)
+      , TransformRepositoryVersion(-1)
+    {
+    }
+
+    /*! Get a transform computed by the worker. Returns NULL if it has not been requested when the snapshot was created. */
+    const ResolvedTransformEntry* FindResolvedTransform(const igsioTransformName& aName) const;
+
+    /*! Timestamp of the tracked frame */
+    double                      Timestamp;
+    /*! System time when the snapshot was created, used for measuring the display latency */
+    double                      CreationTimeSec;
+    /*! All the transforms that were stored in the tracked frame */
+    std::vector<TransformEntry> Transforms;
+    /*! Version of the transform repository that the resolved transforms are computed with, -1 if none */
+    int                         TransformRepositoryVersion;
+    /*! Transforms requested by AddResolvedTransformName() */
+    std::vector<ResolvedTransformEntry> ResolvedTransforms;
+  };
+  typedef std::shared_ptr<const Snapshot> SnapshotConstPtr;
+
+  QPlusFrameSnapshotWorker(QObject* aParent = NULL);
+  virtual ~QPlusFrameSnapshotWorker();
+
+  /*!
+  * Set the channel to poll. Can be called from any thread. When the function returns the previous channel is no longer accessed.
+  * \param aChannel Channel to poll, NULL stops producing snapshots
+  */
+  void SetChannel(vtkPlusChannel* aChannel);
+
+  /*! Get the most recent snapshot. Can be called from any thread. Returns an empty pointer if no frame has been received yet. */
+  SnapshotConstPtr GetLatestSnapshot() const;
+
+  /*!
+  * Set the additional channels whose most recent frame timestamps are polled. Can be called from any thread.
+  * When the function returns the previously watched channels are no longer accessed.
+  * \param aChannels Channels to watch, empty to stop watching
+  */
+  void SetWatchedChannels(const std::vector<vtkPlusChannel*>& aChannels);
+
+  /*!
+  * Get the timestamp of the most recent frame of a watched channel. Can be called from any thread.
+  * Returns UNDEFINED_TIMESTAMP if the channel is not watched or no frame has been received yet.
+  */
+  double GetLatestWatchedTimestamp(vtkPlusChannel* aChannel) const;
+
+  /*!
+  * Set the transform repository that the resolved transforms are computed with. Can be called from any thread.
+  * The repository is copied, so later changes of it have to be set again with a new version.
+  * \param aRepository Repository to copy, NULL stops resolving the transforms
+  * \param aVersion Version of the repository, stored in the snapshots so the owner can tell whether they are up to date
+  */
+  void SetTransformRepository(vtkIGSIOTransformRepository* aRepository, int aVersion);
+
+  /*! Compute a transform into the snapshots of the following frames. Can be called from any thread. */
+  void AddResolvedTransformName(const igsioTransformName& aName);
+
+  /*!
+  * Create a snapshot of the transforms of a frame in a channel, without copying the image data
+  * \param aChannel Channel to get the frame from
+  * \param aTimestamp Timestamp of the frame
+  * \param aSnapshot Output snapshot
+  */
+  static PlusStatus CreateSnapshot(vtkPlusChannel* aChannel, double aTimestamp, SnapshotConstPtr& aSnapshot);
+
+public slots:
+  /*! Start polling at the given interval. Must be called in the thread of the worker. */
+  void Start(int aPollingIntervalMsec);
+
+  /*! Stop polling. Must be called in the thread of the worker. */
+  void Stop();
+
+signals:
+  /*! Emitted when a snapshot with a new frame has been published or a watched channel has a new frame */
+  void SnapshotReady();
+
+protected slots:
+  void Poll();
+
+protected:
+  /*!
+  * Create a snapshot and compute the requested transforms into it
+  * \param aRepository Repository to compute the transforms with, the frame transforms are set in it. NULL if none.
+  * \param aRepositoryVersion Version of the repository
+  * \param aResolvedTransformNames Transforms to compute
+  */
+  static PlusStatus CreateSnapshot(vtkPlusChannel* aChannel, double aTimestamp, vtkIGSIOTransformRepository* aRepository, int aRepositoryVersion,
+                                   const std::vector<igsioTransformName>& aResolvedTransformNames, SnapshotConstPtr& aSnapshot);
+
+protected:
+  /*! Protects the channel and the last polled timestamp, held during the whole poll */
+  QMutex            m_ChannelMutex;
+  vtkPlusChannel*   m_Channel;
+  /*! Timestamp of the frame in the latest snapshot of the current channel */
+  double            m_LatestTimestamp;
+  /*! Additional channels and the timestamps of their most recent frames, protected by the channel mutex while polling */
+  std::map<vtkPlusChannel*, double> m_WatchedChannelTimestamps;
+  /*! Copy of the transform repository of the owner and its version, protected by the channel mutex */
+  vtkSmartPointer<vtkIGSIOTransformRepository> m_TransformRepository;
+  int               m_TransformRepositoryVersion;
+  /*! Transforms computed into the snapshots, protected by the channel mutex */
+  std::vector<igsioTransformName> m_ResolvedTransformNames;
+
+  /*! Protects the latest snapshot pointer and the published watched channel timestamps */
+  mutable QMutex    m_SnapshotMutex;
+  SnapshotConstPtr  m_LatestSnapshot;
+  std::map<vtkPlusChannel*, double> m_LatestWatchedTimestamps;
+
+  QTimer*           m_PollTimer;
+};
+
+#endif // __QPlusFrameSnapshotWorker_h
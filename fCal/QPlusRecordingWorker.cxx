@@ -0,0 +1,179 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "QPlusFrameProfiler.h"
+#include "QPlusRecordingWorker.h"
+
+// PlusLib includes
+#include <igsioTrackedFrame.h>
+#include <vtkIGSIOAccurateTimer.h>
+#include <vtkIGSIOTrackedFrameList.h>
+#include <vtkPlusChannel.h>
+
+// Qt includes
+#include <QTimer>
+
+static const double MAX_ALLOWED_RECORDING_LAG_SEC = 3.0; // if the recording lags more than this then it'll skip frames to catch up
+
+//-----------------------------------------------------------------------------
+QPlusRecordingWorker::QPlusRecordingWorker(QObject* aParent)
+  : QObject(aParent)
+  , m_Channel(NULL)
+  , m_RecordedFrames(NULL)
+  , m_RequestedFrameRate(0.0)
+  , m_SamplingPeriodSec(0.125)
+  , m_RecordingLastAlreadyRecordedFrameTimestamp(UNDEFINED_TIMESTAMP)
+  , m_RecordingNextFrameToBeRecordedTimestamp(0.0)
+  , m_RecordingFirstFrameIndexInThisSegment(0)
+  , m_Recording(false)
+  , m_NumberOfRecordedFrames(0)
+  , m_ActualFrameRate(0.0)
+  , m_SamplingTimer(NULL)
+{
+}
+
+//-----------------------------------------------------------------------------
+QPlusRecordingWorker::~QPlusRecordingWorker()
+{
+}
+
+//-----------------------------------------------------------------------------
+void QPlusRecordingWorker::SetRecordingParameters(vtkPlusChannel* aChannel, vtkIGSIOTrackedFrameList* aRecordedFrames, double aRequestedFrameRate, double aSamplingPeriodSec)
+{
+  if (m_Recording)
+  {
+    LOG_ERROR("Recording parameters cannot be changed while recording");
+    return;
+  }
+
+  m_Channel = aChannel;
+  m_RecordedFrames = aRecordedFrames;
+  m_RequestedFrameRate = aRequestedFrameRate;
+  m_SamplingPeriodSec = aSamplingPeriodSec;
+}
+
+//-----------------------------------------------------------------------------
+bool QPlusRecordingWorker::IsRecording() const
+{
+  return m_Recording;
+}
+
+//-----------------------------------------------------------------------------
+int QPlusRecordingWorker::GetNumberOfRecordedFrames() const
+{
+  return m_NumberOfRecordedFrames;
+}
+
+//-----------------------------------------------------------------------------
+double QPlusRecordingWorker::GetActualFrameRate() const
+{
+  return m_ActualFrameRate;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusRecordingWorker::Start()
+{
+  LOG_TRACE("QPlusRecordingWorker::Start");
+
+  if (m_Channel == NULL || m_RecordedFrames == NULL)
+  {
+    LOG_ERROR("Unable to start recording: no channel or recorded frame list is set");
+    return;
+  }
+
+  m_RecordingFirstFrameIndexInThisSegment = m_RecordedFrames->GetNumberOfTrackedFrames();
+  m_RecordingNextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+  m_RecordingLastAlreadyRecordedFrameTimestamp = UNDEFINED_TIMESTAMP; // none yet
+  m_NumberOfRecordedFrames = m_RecordedFrames->GetNumberOfTrackedFrames();
+  m_ActualFrameRate = 0.0; // display 0.00 until a real estimation is available
+
+  if (m_SamplingTimer == NULL)
+  {
+    m_SamplingTimer = new QTimer(this);
+    m_SamplingTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_SamplingTimer, &QTimer::timeout, this, &QPlusRecordingWorker::Capture);
+  }
+  m_Recording = true;
+  m_SamplingTimer->start(static_cast<int>(m_SamplingPeriodSec * 1000.0));
+}
+
+//-----------------------------------------------------------------------------
+void QPlusRecordingWorker::Stop()
+{
+  LOG_TRACE("QPlusRecordingWorker::Stop");
+
+  if (m_SamplingTimer != NULL)
+  {
+    m_SamplingTimer->stop();
+    delete m_SamplingTimer;
+    m_SamplingTimer = NULL;
+  }
+  m_Recording = false;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusRecordingWorker::Capture()
+{
+  QPlusFrameProfiler::Scope profilerScope("QPlusRecordingWorker::Capture");
+
+  if (!m_Recording)
+  {
+    return;
+  }
+
+  double requestedFramePeriodSec = 0.1;
+  if (m_RequestedFrameRate > 0)
+  {
+    requestedFramePeriodSec = 1.0 / m_RequestedFrameRate;
+  }
+  else
+  {
+    LOG_WARNING("RequestedFrameRate is invalid");
+  }
+
+  // Frames are selected by their timestamps, so limiting the processing time does not affect the sampling: the frames
+  // that did not fit are recorded in the next call. The limit only keeps the worker responsive to Stop().
+  double maxProcessingTimeSec = m_SamplingPeriodSec;
+  if (m_Channel->GetTrackedFrameListSampled(m_RecordingLastAlreadyRecordedFrameTimestamp, m_RecordingNextFrameToBeRecordedTimestamp, m_RecordedFrames, requestedFramePeriodSec, maxProcessingTimeSec) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Error while getting tracked frame list from data collector during capturing. Last recorded timestamp: " << std::fixed << m_RecordingNextFrameToBeRecordedTimestamp);
+  }
+  m_NumberOfRecordedFrames = m_RecordedFrames->GetNumberOfTrackedFrames();
+
+  UpdateActualFrameRate();
+
+  double recordingLagSec = vtkIGSIOAccurateTimer::GetSystemTime() - m_RecordingNextFrameToBeRecordedTimestamp;
+  if (recordingLagSec > MAX_ALLOWED_RECORDING_LAG_SEC)
+  {
+    LOG_ERROR("Recording cannot keep up with the acquisition. Skip " << recordingLagSec << " seconds of the data stream to catch up. Reduce the acquisition rate or sampling rate to resolve the problem.");
+    m_RecordingNextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void QPlusRecordingWorker::UpdateActualFrameRate()
+{
+  int frame1Index = m_RecordedFrames->GetNumberOfTrackedFrames() - 1; // index of the latest frame
+  int frame2Index = frame1Index - m_RequestedFrameRate * 5.0 - 1; // index of an earlier acquired frame (go back by approximately 5 seconds + one frame)
+  if (frame2Index < m_RecordingFirstFrameIndexInThisSegment)
+  {
+    // make sure we stay in the current recording segment
+    frame2Index = m_RecordingFirstFrameIndexInThisSegment;
+  }
+  if (frame1Index <= frame2Index)
+  {
+    return;
+  }
+
+  igsioTrackedFrame* frame1 = m_RecordedFrames->GetTrackedFrame(frame1Index);
+  igsioTrackedFrame* frame2 = m_RecordedFrames->GetTrackedFrame(frame2Index);
+  if (frame1 != NULL && frame2 != NULL)
+  {
+    double frameTimeDiff = frame1->GetTimestamp() - frame2->GetTimestamp();
+    m_ActualFrameRate = (frameTimeDiff > 0 ? (frame1Index - frame2Index) / frameTimeDiff : 0.0);
+  }
+}
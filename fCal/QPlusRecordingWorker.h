@@ -0,0 +1,101 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __QPlusRecordingWorker_h
+#define __QPlusRecordingWorker_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// Qt includes
+#include <QObject>
+
+// STL includes
+#include <atomic>
+
+class vtkIGSIOTrackedFrameList;
+class vtkPlusChannel;
+
+class QTimer;
+
+/*! \class QPlusRecordingWorker
+\brief Records the tracked frames of a channel into a tracked frame list on a worker thread
+
+The worker is moved to its own thread by its owner. While recording, it copies the frames that were acquired since the
+previous sampling period from the channel into the recorded frame list, at the requested frame rate. Frames are selected
+by their timestamps, so the sampling is uniform regardless of how busy the GUI thread is.
+
+The recorded frame list is only accessed by the worker between Start() and Stop(). The GUI thread can follow the
+recording through the statistics getters, which do not lock.
+
+\ingroup PlusAppFCal
+*/
+class QPlusRecordingWorker : public QObject
+{
+  Q_OBJECT
+
+public:
+  QPlusRecordingWorker(QObject* aParent = NULL);
+  virtual ~QPlusRecordingWorker();
+
+  /*!
+  * Set the recording parameters. Must not be called while recording.
+  * \param aChannel Channel to record from
+  * \param aRecordedFrames List to append the recorded frames to
+  * \param aRequestedFrameRate Frame rate of the recorded frames (frames per second)
+  * \param aSamplingPeriodSec Period of copying the frames from the channel into the list
+  */
+  void SetRecordingParameters(vtkPlusChannel* aChannel, vtkIGSIOTrackedFrameList* aRecordedFrames, double aRequestedFrameRate, double aSamplingPeriodSec);
+
+  /*! Returns true between Start() and Stop(). Can be called from any thread. */
+  bool IsRecording() const;
+
+  /*! Get the number of frames in the recorded frame list. Can be called from any thread. */
+  int GetNumberOfRecordedFrames() const;
+
+  /*! Get the frame rate of the recently recorded frames (frames per second). Can be called from any thread. */
+  double GetActualFrameRate() const;
+
+public slots:
+  /*! Start recording. Must be called in the thread of the worker. */
+  void Start();
+
+  /*! Stop recording. Must be called in the thread of the worker, when it returns the recorded frame list is no longer accessed. */
+  void Stop();
+
+protected slots:
+  /*! Record the frames acquired since the previous call (the sampling timer calls it) */
+  void Capture();
+
+protected:
+  /*! Estimate the actual frame rate from the frames recorded in the last few seconds */
+  void UpdateActualFrameRate();
+
+protected:
+  /*! Recording parameters, only modified while not recording */
+  vtkPlusChannel*           m_Channel;
+  vtkIGSIOTrackedFrameList* m_RecordedFrames;
+  double                    m_RequestedFrameRate;
+  double                    m_SamplingPeriodSec;
+
+  /*! Timestamp of last recorded frame (only frames that have more recent timestamp will be added) */
+  double m_RecordingLastAlreadyRecordedFrameTimestamp;
+
+  /*! Desired timestamp of the next frame to be recorded */
+  double m_RecordingNextFrameToBeRecordedTimestamp;
+
+  /*! Frame index of the first frame that is recorded since Start(), earlier frames are not used for the actual frame rate */
+  int m_RecordingFirstFrameIndexInThisSegment;
+
+  /*! Statistics published to the GUI thread */
+  std::atomic<bool>   m_Recording;
+  std::atomic<int>    m_NumberOfRecordedFrames;
+  std::atomic<double> m_ActualFrameRate;
+
+  QTimer* m_SamplingTimer;
+};
+
+#endif // __QPlusRecordingWorker_h
@@ -0,0 +1,253 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "QPlusFrameProfiler.h"
+#include "QPlusSequenceWriteWorker.h"
+
+// PlusLib includes
+#include <vtkIGSIOSequenceIOBase.h>
+#include <vtkIGSIOTrackedFrameList.h>
+#include <vtkPlusSequenceIO.h>
+
+// VTK includes
+#include <vtksys/SystemTools.hxx>
+
+// Qt includes
+#include <QMutexLocker>
+
+// STL includes
+#include <algorithm>
+
+static const int NUMBER_OF_FRAMES_PER_CHUNK = 50; // cancelling takes at most the time of writing this many frames
+
+//-----------------------------------------------------------------------------
+QPlusSequenceWriteWorker::QPlusSequenceWriteWorker(QObject* aParent)
+  : QObject(aParent)
+  , m_NextJobId(0)
+  , m_CancelledJobId(-1)
+{
+}
+
+//-----------------------------------------------------------------------------
+QPlusSequenceWriteWorker::~QPlusSequenceWriteWorker()
+{
+  // Jobs that have not been processed
+  for (std::deque<WriteJob>::iterator jobIt = m_PendingJobs.begin(); jobIt != m_PendingJobs.end(); ++jobIt)
+  {
+    LOG_WARNING("Tracked frame list has not been saved into '" << jobIt->FileName << "'");
+    jobIt->TrackedFrameList->Delete();
+  }
+  m_PendingJobs.clear();
+}
+
+//-----------------------------------------------------------------------------
+void QPlusSequenceWriteWorker::AddJob(const std::string& aFileName, vtkIGSIOTrackedFrameList* aTrackedFrameList, vtkXMLDataElement* aConfiguration)
+{
+  QMutexLocker locker(&m_JobMutex);
+
+  WriteJob job;
+  job.Id = m_NextJobId++;
+  job.FileName = aFileName;
+  job.TrackedFrameList = aTrackedFrameList;
+  job.Configuration = aConfiguration;
+  m_PendingJobs.push_back(job);
+}
+
+//-----------------------------------------------------------------------------
+int QPlusSequenceWriteWorker::GetNumberOfUnfinishedJobs() const
+{
+  QMutexLocker locker(&m_JobMutex);
+  return static_cast<int>(m_PendingJobs.size()) + (m_CurrentJob.Id >= 0 ? 1 : 0);
+}
+
+//-----------------------------------------------------------------------------
+std::string QPlusSequenceWriteWorker::GetCurrentFileName() const
+{
+  QMutexLocker locker(&m_JobMutex);
+  return (m_CurrentJob.Id >= 0 ? m_CurrentJob.FileName : std::string());
+}
+
+//-----------------------------------------------------------------------------
+void QPlusSequenceWriteWorker::CancelCurrentJob()
+{
+  QMutexLocker locker(&m_JobMutex);
+  if (m_CurrentJob.Id >= 0)
+  {
+    m_CancelledJobId = m_CurrentJob.Id;
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool QPlusSequenceWriteWorker::IsJobCancelled(int aJobId) const
+{
+  QMutexLocker locker(&m_JobMutex);
+  return (m_CancelledJobId == aJobId);
+}
+
+//-----------------------------------------------------------------------------
+void QPlusSequenceWriteWorker::ProcessJobs()
+{
+  LOG_TRACE("QPlusSequenceWriteWorker::ProcessJobs");
+
+  while (true)
+  {
+    WriteJob job;
+    {
+      QMutexLocker locker(&m_JobMutex);
+      if (m_PendingJobs.empty())
+      {
+        return;
+      }
+      job = m_PendingJobs.front();
+      m_PendingJobs.pop_front();
+      m_CurrentJob = job;
+    }
+
+    PlusStatus status = PLUS_FAIL;
+    bool cancelled(false);
+    {
+      QPlusFrameProfiler::Scope profilerScope("QPlusSequenceWriteWorker::Write");
+      status = WriteSequenceFile(job, cancelled);
+    }
+    job.TrackedFrameList->Delete();
+    job.TrackedFrameList = NULL;
+
+    {
+      // The job may also have been cancelled after its last chunk was written
+      QMutexLocker locker(&m_JobMutex);
+      cancelled = cancelled || (m_CancelledJobId == job.Id);
+      m_CurrentJob = WriteJob();
+    }
+
+    if (cancelled)
+    {
+      LOG_INFO("Saving into '" << job.FileName << "' has been cancelled, the file is removed");
+      RemoveSequenceFiles(job.FileName);
+    }
+    else if (status != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to save tracked frames to sequence file '" << job.FileName << "'!");
+      RemoveSequenceFiles(job.FileName);
+    }
+    else if (job.Configuration != NULL)
+    {
+      // Save the device set configuration of the recording next to the tracked frame list
+      std::string path = vtksys::SystemTools::GetFilenamePath(job.FileName);
+      std::string filename = vtksys::SystemTools::GetFilenameWithoutExtension(job.FileName);
+      std::string configFileName = path + "/" + filename + "_config.xml";
+      igsioCommon::XML::PrintXML(configFileName, job.Configuration);
+    }
+
+    emit JobFinished(QString::fromLatin1(job.FileName.c_str()), !cancelled && status == PLUS_SUCCESS, cancelled);
+  }
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QPlusSequenceWriteWorker::WriteSequenceFile(const WriteJob& aJob, bool& aCancelled)
+{
+  aCancelled = false;
+
+  QString fileName = QString::fromLatin1(aJob.FileName.c_str());
+  int numberOfFrames = aJob.TrackedFrameList->GetNumberOfTrackedFrames();
+  emit JobProgress(fileName, 0, numberOfFrames);
+  if (numberOfFrames <= NUMBER_OF_FRAMES_PER_CHUNK)
+  {
+    // Short sequences are written at once
+    if (vtkPlusSequenceIO::Write(aJob.FileName, aJob.TrackedFrameList) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    emit JobProgress(fileName, numberOfFrames, numberOfFrames);
+    return PLUS_SUCCESS;
+  }
+
+  vtkSmartPointer<vtkIGSIOSequenceIOBase> writer = vtkSmartPointer<vtkIGSIOSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(aJob.FileName));
+  if (writer == NULL)
+  {
+    LOG_ERROR("No sequence writer is available for file '" << aJob.FileName << "'");
+    return PLUS_FAIL;
+  }
+
+  // The writer appends all the frames of its list, so the frames are copied into the list of the writer chunk by
+  // chunk. The custom fields of the list go into the header of the file.
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> chunk = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  std::vector<std::string> customFieldNames;
+  aJob.TrackedFrameList->GetCustomFieldNameList(customFieldNames);
+  for (std::vector<std::string>::iterator fieldIt = customFieldNames.begin(); fieldIt != customFieldNames.end(); ++fieldIt)
+  {
+    chunk->SetCustomString(fieldIt->c_str(), aJob.TrackedFrameList->GetCustomString(fieldIt->c_str()));
+  }
+  writer->SetTrackedFrameList(chunk);
+  writer->SetFileName(aJob.FileName);
+  writer->SetUseCompression(true);
+  writer->SetImageOrientationInFile(US_IMG_ORIENT_MF);
+
+  for (int firstFrameIndex = 0; firstFrameIndex < numberOfFrames; firstFrameIndex += NUMBER_OF_FRAMES_PER_CHUNK)
+  {
+    if (IsJobCancelled(aJob.Id))
+    {
+      // Release the file, it is removed by the caller
+      aCancelled = true;
+      writer->Close();
+      return PLUS_FAIL;
+    }
+
+    chunk->Clear();
+    int endFrameIndex = std::min(firstFrameIndex + NUMBER_OF_FRAMES_PER_CHUNK, numberOfFrames);
+    for (int frameIndex = firstFrameIndex; frameIndex < endFrameIndex; ++frameIndex)
+    {
+      chunk->AddTrackedFrame(aJob.TrackedFrameList->GetTrackedFrame(frameIndex), vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+
+    // The header is prepared from the first frames
+    if (firstFrameIndex == 0 && writer->PrepareHeader() != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Unable to prepare the header of sequence file '" << aJob.FileName << "'");
+      writer->Close();
+      return PLUS_FAIL;
+    }
+    if (writer->AppendImagesToHeader() != IGSIO_SUCCESS || writer->AppendImages() != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Unable to append frames " << firstFrameIndex << "-" << endFrameIndex - 1 << " to sequence file '" << aJob.FileName << "'");
+      writer->Close();
+      return PLUS_FAIL;
+    }
+    emit JobProgress(fileName, endFrameIndex, numberOfFrames);
+  }
+
+  if (writer->FinalizeHeader() != IGSIO_SUCCESS || writer->Close() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Unable to finalize sequence file '" << aJob.FileName << "'");
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusSequenceWriteWorker::RemoveSequenceFiles(const std::string& aFileName)
+{
+  if (vtksys::SystemTools::FileExists(aFileName.c_str(), true))
+  {
+    vtksys::SystemTools::RemoveFile(aFileName);
+  }
+
+  if (vtksys::SystemTools::GetFilenameLastExtension(aFileName) == ".mhd")
+  {
+    std::string path = vtksys::SystemTools::GetFilenamePath(aFileName);
+    std::string pixelDataFileNameWithoutExtension = (path.empty() ? std::string() : path + "/") + vtksys::SystemTools::GetFilenameWithoutLastExtension(aFileName);
+    const char* pixelDataExtensions[] = { ".raw", ".zraw" };
+    for (int i = 0; i < 2; ++i)
+    {
+      std::string pixelDataFileName = pixelDataFileNameWithoutExtension + pixelDataExtensions[i];
+      if (vtksys::SystemTools::FileExists(pixelDataFileName.c_str(), true))
+      {
+        vtksys::SystemTools::RemoveFile(pixelDataFileName);
+      }
+    }
+  }
+}
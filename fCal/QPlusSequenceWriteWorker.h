@@ -0,0 +1,129 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __QPlusSequenceWriteWorker_h
+#define __QPlusSequenceWriteWorker_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkXMLDataElement.h>
+
+// Qt includes
+#include <QMutex>
+#include <QObject>
+#include <QString>
+
+// STL includes
+#include <deque>
+#include <string>
+
+class vtkIGSIOTrackedFrameList;
+
+/*! \class QPlusSequenceWriteWorker
+\brief Writes tracked frame lists into sequence files on a worker thread
+
+The worker is moved to its own thread by its owner. Tracked frame lists are handed over by AddJob(), which takes the
+ownership of the list, so the owner can continue recording into a new list while the previous one is being written.
+The jobs are written one after the other by ProcessJobs() in the thread of the worker, and the JobFinished signal is
+emitted after each of them. The device set configuration of a job is saved next to its sequence file when the sequence
+has been written.
+
+Long sequences are appended to the file in chunks of frames, so a cancelled job stops after the current chunk and
+its partially written files are removed. The JobProgress signal is emitted after each chunk.
+
+\ingroup PlusAppFCal
+*/
+class QPlusSequenceWriteWorker : public QObject
+{
+  Q_OBJECT
+
+public:
+  QPlusSequenceWriteWorker(QObject* aParent = NULL);
+  virtual ~QPlusSequenceWriteWorker();
+
+  /*!
+  * Add a tracked frame list to be written. Can be called from any thread, ProcessJobs() has to be invoked afterwards.
+  * \param aFileName Output sequence file name
+  * \param aTrackedFrameList Frames to write, the worker takes its ownership and deletes it when it has been written
+  * \param aConfiguration Device set configuration saved into <name>_config.xml next to the sequence file, NULL if none.
+  *   It must not be modified afterwards, so it is typically a copy of the configuration at the time of the recording.
+  */
+  void AddJob(const std::string& aFileName, vtkIGSIOTrackedFrameList* aTrackedFrameList, vtkXMLDataElement* aConfiguration);
+
+  /*! Get the number of jobs that are being written or waiting to be written. Can be called from any thread. */
+  int GetNumberOfUnfinishedJobs() const;
+
+  /*! Get the file name of the job that is being written, empty if none. Can be called from any thread. */
+  std::string GetCurrentFileName() const;
+
+  /*! Cancel the job that is being written: the writing stops and the written files are removed. Can be called from any thread. */
+  void CancelCurrentJob();
+
+public slots:
+  /*! Write all the jobs that have been added. Must be called in the thread of the worker. */
+  void ProcessJobs();
+
+signals:
+  /*!
+  * Emitted when a job is finished
+  * \param aFileName Output sequence file name of the job
+  * \param aSuccess True if the file has been written
+  * \param aCancelled True if the job has been cancelled (the file is removed)
+  */
+  void JobFinished(const QString& aFileName, bool aSuccess, bool aCancelled);
+
+  /*!
+  * Emitted when a job is started and after each chunk of frames that has been written
+  * \param aFileName Output sequence file name of the job
+  * \param aNumberOfWrittenFrames Number of frames that have been written so far
+  * \param aNumberOfFrames Number of frames of the job
+  */
+  void JobProgress(const QString& aFileName, int aNumberOfWrittenFrames, int aNumberOfFrames);
+
+protected:
+  struct WriteJob
+  {
+    WriteJob()
+      : Id(-1)
+      , TrackedFrameList(NULL)
+    {
+    }
+    int                                 Id;
+    std::string                         FileName;
+    vtkIGSIOTrackedFrameList*           TrackedFrameList;
+    vtkSmartPointer<vtkXMLDataElement>  Configuration;
+  };
+
+  /*!
+  * Write the tracked frame list of a job into its sequence file. Long sequences are written in chunks and the writing
+  * stops if the job is cancelled. The partially written file of a cancelled or failed job is left for the caller to remove.
+  * \param aJob Job to write
+  * \param aCancelled Set to true if the writing stopped because the job has been cancelled
+  */
+  PlusStatus WriteSequenceFile(const WriteJob& aJob, bool& aCancelled);
+
+  /*! Returns true if a job has been cancelled. Can be called from any thread. */
+  bool IsJobCancelled(int aJobId) const;
+
+  /*! Remove the files written for a sequence file name (the header and, for .mhd files, the pixel data file) */
+  static void RemoveSequenceFiles(const std::string& aFileName);
+
+protected:
+
+  /*! Protects all the members below */
+  mutable QMutex        m_JobMutex;
+  std::deque<WriteJob>  m_PendingJobs;
+  int                   m_NextJobId;
+  /*! Job that is being written, its Id is -1 if none */
+  WriteJob              m_CurrentJob;
+  /*! Id of the last cancelled job */
+  int                   m_CancelledJobId;
+};
+
+#endif // __QPlusSequenceWriteWorker_h
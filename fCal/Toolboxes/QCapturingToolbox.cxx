@@ -7,6 +7,9 @@ See License.txt for details.
 // Local includes
 #include "PlusCaptureControlWidget.h"
 #include "QCapturingToolbox.h"
+#include "QPlusFrameProfiler.h"
+#include "QPlusRecordingWorker.h"
+#include "QPlusSequenceWriteWorker.h"
 #include "QVolumeReconstructionToolbox.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusVisualizationController.h"
@@ -14,7 +17,6 @@ See License.txt for details.
 // PlusLib includes
 #include <igsioTrackedFrame.h>
 #include <vtkPlusDevice.h>
-#include <vtkPlusSequenceIO.h>
 #include <vtkIGSIOTrackedFrameList.h>
 
 // VTK includes
@@ -27,21 +29,16 @@ See License.txt for details.
 #include <QScrollArea>
 #include <QSpacerItem>
 #include <QString>
-#include <QTimer>
-
-static const int MAX_ALLOWED_RECORDING_LAG_SEC = 3.0; // if the recording lags more than this then it'll skip frames to catch up
 
 //-----------------------------------------------------------------------------
 QCapturingToolbox::QCapturingToolbox(fCalMainWindow* aParentMainWindow, Qt::WindowFlags aFlags)
   : QAbstractToolbox(aParentMainWindow)
   , QWidget(aParentMainWindow, aFlags)
   , m_RecordedFrames(NULL)
-  , m_RecordingTimer(NULL)
-  , m_RecordingLastAlreadyRecordedFrameTimestamp(UNDEFINED_TIMESTAMP)
-  , m_RecordingNextFrameToBeRecordedTimestamp(0.0)
+  , m_RecordingWorker(new QPlusRecordingWorker())
+  , m_SavingWorker(new QPlusSequenceWriteWorker())
   , m_SamplingFrameRate(8)
   , m_RequestedFrameRate(0.0)
-  , m_ActualFrameRate(0.0)
 {
   ui.setupUi(this);
 
@@ -59,10 +56,18 @@ QCapturingToolbox::QCapturingToolbox(fCalMainWindow* aParentMainWindow, Qt::Wind
   connect(ui.pushButton_ClearAll, SIGNAL(clicked()), this, SLOT(ClearAll()));
   connect(ui.pushButton_StartStopAll, SIGNAL(clicked()), this, SLOT(StartStopAll()));
   connect(ui.horizontalSlider_SamplingRate, SIGNAL(valueChanged(int)), this, SLOT(SamplingRateChanged(int)));
+  connect(ui.pushButton_CancelSaving, SIGNAL(clicked()), this, SLOT(CancelSaving()));
+
+  // Recording runs in its own thread so that the sampling does not depend on the load of the GUI thread
+  m_RecordingWorker->moveToThread(&m_RecordingThread);
+  m_RecordingThread.start();
 
-  // Create and connect recording timer
-  m_RecordingTimer = new QTimer(this);
-  connect(m_RecordingTimer, SIGNAL(timeout()), this, SLOT(Capture()));
+  // Saving runs in its own thread so that the GUI remains responsive and recording can continue while a file is written
+  m_SavingWorker->moveToThread(&m_SavingThread);
+  connect(m_SavingWorker, SIGNAL(JobFinished(const QString&, bool, bool)), this, SLOT(SavingFinished(const QString&, bool, bool)), Qt::QueuedConnection);
+  connect(m_SavingWorker, SIGNAL(JobProgress(const QString&, int, int)), this, SLOT(SavingProgress(const QString&, int, int)), Qt::QueuedConnection);
+  m_SavingThread.start();
+  UpdateSavingProgress();
 
   ui.pushButton_Save->setEnabled(m_RecordedFrames->GetNumberOfTrackedFrames() > 0);
   ui.pushButton_SaveAs->setEnabled(m_RecordedFrames->GetNumberOfTrackedFrames() > 0);
@@ -77,6 +82,24 @@ QCapturingToolbox::QCapturingToolbox(fCalMainWindow* aParentMainWindow, Qt::Wind
 //-----------------------------------------------------------------------------
 QCapturingToolbox::~QCapturingToolbox()
 {
+  // Make sure the worker no longer accesses the recorded frames
+  QMetaObject::invokeMethod(m_RecordingWorker, "Stop", Qt::BlockingQueuedConnection);
+  m_RecordingThread.quit();
+  m_RecordingThread.wait();
+  delete m_RecordingWorker;
+  m_RecordingWorker = NULL;
+
+  // Do not lose the recorded frames that are still being saved
+  if (m_SavingWorker->GetNumberOfUnfinishedJobs() > 0)
+  {
+    LOG_INFO("Waiting for the captured tracked frame lists to be saved");
+  }
+  QMetaObject::invokeMethod(m_SavingWorker, "ProcessJobs", Qt::BlockingQueuedConnection);
+  m_SavingThread.quit();
+  m_SavingThread.wait();
+  delete m_SavingWorker;
+  m_SavingWorker = NULL;
+
   if (m_RecordedFrames != NULL)
   {
     m_RecordedFrames->Delete();
@@ -115,12 +138,17 @@ void QCapturingToolbox::RefreshContent()
 {
   //LOG_TRACE("CapturingToolbox::RefreshContent");
 
+  QPlusFrameProfiler::Scope profilerScope("QCapturingToolbox::RefreshContent");
+
   if (m_State == ToolboxState_InProgress)
   {
-    ui.label_ActualRecordingFrameRate->setText(QString::number(m_ActualFrameRate, 'f', 2));
-    ui.label_NumberOfRecordedFrames->setText(QString::number(m_RecordedFrames->GetNumberOfTrackedFrames()));
+    // The recorded frame list is owned by the recording worker while recording, only its statistics are read
+    ui.label_ActualRecordingFrameRate->setText(QString::number(m_RecordingWorker->GetActualFrameRate(), 'f', 2));
+    ui.label_NumberOfRecordedFrames->setText(QString::number(m_RecordingWorker->GetNumberOfRecordedFrames()));
   }
 
+  UpdateSavingProgress();
+
   ui.pushButton_SaveAll->setEnabled(false);
   for (std::vector<PlusCaptureControlWidget*>::iterator it = m_CaptureWidgets.begin(); it != m_CaptureWidgets.end(); ++it)
   {
@@ -380,93 +408,20 @@ void QCapturingToolbox::Record()
 {
   LOG_INFO("Capturing started");
 
-  m_ParentMainWindow->SetToolboxesEnabled(false);
-  m_ActualFrameRate = 0.0; // display 0.00 until a real estimation is available
-
-  // Reset accessory members
-  m_RecordingFirstFrameIndexInThisSegment = m_RecordedFrames->GetNumberOfTrackedFrames();
-
-  ui.plainTextEdit_saveResult->clear();
-
-  m_RecordingNextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
-  m_RecordingLastAlreadyRecordedFrameTimestamp = UNDEFINED_TIMESTAMP; // none yet
-
-  // Start capturing
-  SetState(ToolboxState_InProgress);
-  double samplingPeriodMsec = GetSamplingPeriodSec() * 1000.0;
-  m_RecordingTimer->start(samplingPeriodMsec);
-}
-
-//-----------------------------------------------------------------------------
-void QCapturingToolbox::Capture()
-{
-  //LOG_TRACE("CapturingToolbox::Capture");
-
-  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
-
-  vtkPlusDataCollector* dataCollector = NULL;
-  if ((m_ParentMainWindow == NULL) || (m_ParentMainWindow->GetVisualizationController() == NULL) || ((dataCollector = m_ParentMainWindow->GetVisualizationController()->GetDataCollector()) == NULL))
+  if (m_ParentMainWindow->GetSelectedChannel() == NULL)
   {
-    LOG_ERROR("Unable to reach valid data collector object!");
+    LOG_ERROR("Unable to start capturing: no channel is selected!");
     return;
   }
 
-  // Record
-  double maxProcessingTimeSec = GetSamplingPeriodSec() * 2.0; // put a hard limit on the max processing time to make sure the application remains responsive during recording
-  double requestedFramePeriodSec = 0.1;
-  if (m_RequestedFrameRate > 0)
-  {
-    requestedFramePeriodSec = 1.0 / m_RequestedFrameRate;
-  }
-  else
-  {
-    LOG_WARNING("RequestedFrameRate is invalid");
-  }
-  int nbFramesBefore = m_RecordedFrames->GetNumberOfTrackedFrames();
-  if (m_ParentMainWindow->GetSelectedChannel()->GetTrackedFrameListSampled(m_RecordingLastAlreadyRecordedFrameTimestamp, m_RecordingNextFrameToBeRecordedTimestamp, m_RecordedFrames, requestedFramePeriodSec, maxProcessingTimeSec) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Error while getting tracked frame list from data collector during capturing. Last recorded timestamp: " << std::fixed << m_RecordingNextFrameToBeRecordedTimestamp);
-  }
-  int nbFramesAfter = m_RecordedFrames->GetNumberOfTrackedFrames();
+  m_ParentMainWindow->SetToolboxesEnabled(false);
 
-  // Compute the average frame rate from the ratio of recently acquired frames
-  int frame1Index = m_RecordedFrames->GetNumberOfTrackedFrames() - 1; // index of the latest frame
-  int frame2Index = frame1Index - m_RequestedFrameRate * 5.0 - 1; // index of an earlier acquired frame (go back by approximately 5 seconds + one frame)
-  if (frame2Index < m_RecordingFirstFrameIndexInThisSegment)
-  {
-    // make sure we stay in the current recording segment
-    frame2Index = m_RecordingFirstFrameIndexInThisSegment;
-  }
-  if (frame1Index > frame2Index)
-  {
-    igsioTrackedFrame* frame1 = m_RecordedFrames->GetTrackedFrame(frame1Index);
-    igsioTrackedFrame* frame2 = m_RecordedFrames->GetTrackedFrame(frame2Index);
-    if (frame1 != NULL && frame2 != NULL)
-    {
-      double frameTimeDiff = frame1->GetTimestamp() - frame2->GetTimestamp();
-      if (frameTimeDiff > 0)
-      {
-        m_ActualFrameRate = (frame1Index - frame2Index) / frameTimeDiff;
-      }
-      else
-      {
-        m_ActualFrameRate = 0;
-      }
-    }
-  }
+  ui.plainTextEdit_saveResult->clear();
 
-  // Check whether the recording needed more time than the sampling interval
-  double recordingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
-  if (recordingTimeSec > GetSamplingPeriodSec())
-  {
-    LOG_WARNING("Recording of frames takes too long time (" << recordingTimeSec << "sec instead of the allocated " << GetSamplingPeriodSec() << "sec). This can cause slow-down of the application and non-uniform sampling. Reduce the acquisition rate or sampling rate to resolve the problem.");
-  }
-  double recordingLagSec = vtkIGSIOAccurateTimer::GetSystemTime() - m_RecordingNextFrameToBeRecordedTimestamp;
-  if (recordingLagSec > MAX_ALLOWED_RECORDING_LAG_SEC)
-  {
-    LOG_ERROR("Recording cannot keep up with the acquisition. Skip " << recordingLagSec << " seconds of the data stream to catch up.");
-    m_RecordingNextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
-  }
+  // Start capturing. The worker owns the recorded frame list until it is stopped.
+  m_RecordingWorker->SetRecordingParameters(m_ParentMainWindow->GetSelectedChannel(), m_RecordedFrames, m_RequestedFrameRate, GetSamplingPeriodSec());
+  SetState(ToolboxState_InProgress);
+  QMetaObject::invokeMethod(m_RecordingWorker, "Start", Qt::QueuedConnection);
 }
 
 //-----------------------------------------------------------------------------
@@ -474,7 +429,8 @@ void QCapturingToolbox::Stop()
 {
   LOG_INFO("Capturing stopped");
 
-  m_RecordingTimer->stop();
+  // Wait until the worker has finished recording, the recorded frames can be accessed afterwards
+  QMetaObject::invokeMethod(m_RecordingWorker, "Stop", Qt::BlockingQueuedConnection);
   SetState(ToolboxState_Done);
 
   m_ParentMainWindow->SetToolboxesEnabled(true);
@@ -488,8 +444,6 @@ void QCapturingToolbox::Save()
   // TODO: just for testing
   std::string defaultFileName = m_LastSaveLocation + "/TrackedImageSequence_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + ".mha";
   WriteToFile(QString(defaultFileName.c_str()));
-
-  LOG_INFO("Captured tracked frame list saved into '" << defaultFileName << "'");
 }
 
 //-----------------------------------------------------------------------------
@@ -500,12 +454,15 @@ void QCapturingToolbox::SaveAs()
   std::string defaultFileName = m_LastSaveLocation + "/TrackedImageSequence_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + ".mha";
   QString filter = QString(tr("SequenceMetaFiles (*.mha *.mhd);;"));
   QString fileNameQt = QFileDialog::getSaveFileName(NULL, tr("Save captured tracked frames"), QString(defaultFileName.c_str()), filter);
+  if (fileNameQt.isEmpty())
+  {
+    // Cancelled
+    return;
+  }
   std::string fileName = fileNameQt.toLatin1().constData();
   m_LastSaveLocation = vtksys::SystemTools::GetFilenamePath(fileName.c_str());
 
   WriteToFile(QString(fileName.c_str()));
-
-  LOG_INFO("Captured tracked frame list saved into '" << fileName << "'");
 }
 
 //-----------------------------------------------------------------------------
@@ -517,17 +474,57 @@ void QCapturingToolbox::WriteToFile(const QString& aFilename)
     return;
   }
 
-  QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
+  LOG_INFO("Saving captured tracked frame list (" << m_RecordedFrames->GetNumberOfTrackedFrames() << " frames) into '" << aFilename.toLatin1().constData() << "'");
 
-  // Actual saving
-  if (vtkPlusSequenceIO::Write(aFilename.toLatin1().constData(), m_RecordedFrames) != PLUS_SUCCESS)
+  // Write the current state into the device set configuration XML. The saving thread writes a copy of it next to the
+  // tracked frame list, so that it describes the recording even if the configuration changes while saving.
+  m_ParentMainWindow->GetVisualizationController()->WriteConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
+  vtkSmartPointer<vtkXMLDataElement> configuration;
+  if (vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData() != NULL)
   {
-    LOG_ERROR("Failed to save tracked frames to sequence metafile!");
+    configuration = vtkSmartPointer<vtkXMLDataElement>::New();
+    configuration->DeepCopy(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
+  }
+
+  // The saving thread takes the recorded frames, new frames are recorded into an empty list in the meantime
+  vtkIGSIOTrackedFrameList* savedFrames = m_RecordedFrames;
+  m_RecordedFrames = vtkIGSIOTrackedFrameList::New();
+  m_RecordedFrames->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+  m_SavingWorker->AddJob(aFilename.toLatin1().constData(), savedFrames, configuration);
+  QMetaObject::invokeMethod(m_SavingWorker, "ProcessJobs", Qt::QueuedConnection);
+
+  ui.plainTextEdit_saveResult->clear();
+  SetState(ToolboxState_Idle);
+  UpdateSavingProgress();
+}
+
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::SavingProgress(const QString& aFilename, int aNumberOfWrittenFrames, int aNumberOfFrames)
+{
+  ui.progressBar_Saving->setRange(0, qMax(aNumberOfFrames, 1));
+  ui.progressBar_Saving->setValue(aNumberOfWrittenFrames);
+  UpdateSavingProgress();
+}
+
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::SavingFinished(const QString& aFilename, bool aSuccess, bool aCancelled)
+{
+  ui.progressBar_Saving->reset();
+  UpdateSavingProgress();
+
+  ui.plainTextEdit_saveResult->clear();
+  if (aCancelled)
+  {
+    ui.plainTextEdit_saveResult->insertPlainText("Saving cancelled, file removed:\n" + aFilename);
+    return;
+  }
+  if (!aSuccess)
+  {
+    ui.plainTextEdit_saveResult->insertPlainText("Failed to save file\n" + aFilename);
     return;
   }
 
   QString result = "File saved to\n" + aFilename;
-  ui.plainTextEdit_saveResult->clear();
   ui.plainTextEdit_saveResult->insertPlainText(result);
 
   // Add file name to image list in Volume reconstruction toolbox
@@ -537,21 +534,41 @@ void QCapturingToolbox::WriteToFile(const QString& aFilename)
     volumeReconstructionToolbox->AddImageFileName(aFilename);
   }
 
-  // Write the current state into the device set configuration XML
-  m_ParentMainWindow->GetVisualizationController()->WriteConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
-
-  // Save config file next to the tracked frame list
+  LOG_INFO("Captured tracked frame list saved into '" << aFilename.toLatin1().constData() << "'");
+}
 
-  std::string path = vtksys::SystemTools::GetFilenamePath(aFilename.toLatin1().constData());
-  std::string filename = vtksys::SystemTools::GetFilenameWithoutExtension(aFilename.toLatin1().constData());
-  std::string configFileName = path + "/" + filename + "_config.xml";
-  igsioCommon::XML::PrintXML(configFileName, vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::CancelSaving()
+{
+  std::string fileName = m_SavingWorker->GetCurrentFileName();
+  if (fileName.empty())
+  {
+    return;
+  }
 
-  m_RecordedFrames->Clear();
-  SetState(ToolboxState_Idle);
+  LOG_INFO("Cancel saving into '" << fileName << "'");
+  m_SavingWorker->CancelCurrentJob();
+}
 
-  QApplication::restoreOverrideCursor();
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::UpdateSavingProgress()
+{
+  int numberOfUnfinishedJobs = m_SavingWorker->GetNumberOfUnfinishedJobs();
+  bool saving = (numberOfUnfinishedJobs > 0);
+  ui.label_Saving->setVisible(saving);
+  ui.progressBar_Saving->setVisible(saving);
+  ui.pushButton_CancelSaving->setVisible(saving);
+  if (!saving)
+  {
+    return;
+  }
 
+  QString text = tr("Saving %1").arg(vtksys::SystemTools::GetFilenameName(m_SavingWorker->GetCurrentFileName()).c_str());
+  if (numberOfUnfinishedJobs > 1)
+  {
+    text.append(tr(" (%1 more queued)").arg(numberOfUnfinishedJobs - 1));
+  }
+  ui.label_Saving->setText(text);
 }
 
 //-----------------------------------------------------------------------------
@@ -610,8 +627,14 @@ double QCapturingToolbox::GetMaximumFrameRate()
 //-----------------------------------------------------------------------------
 void QCapturingToolbox::Reset()
 {
-  QAbstractToolbox::Reset();
+  // The base class sets the state to idle, so the recording is stopped before. Stop() waits for the worker (also if
+  // its Start() is still queued) and enables the other toolboxes again, the recorded frames can be cleared afterwards.
+  if (m_State == ToolboxState_InProgress || m_RecordingWorker->IsRecording())
+  {
+    this->Stop();
+  }
 
+  QAbstractToolbox::Reset();
   this->ClearRecordedFramesInternal();
 }
 
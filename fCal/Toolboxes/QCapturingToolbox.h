@@ -15,14 +15,16 @@ See License.txt for details.
 #include "ui_QCapturingToolbox.h"
 
 // Qt includes
+#include <QThread>
 #include <QWidget>
 
 class PlusCaptureControlWidget;
 class QGridLayout;
+class QPlusRecordingWorker;
+class QPlusSequenceWriteWorker;
 class QScrollArea;
 class QSpacerItem;
 class QString;
-class QTimer;
 class vtkIGSIOTrackedFrameList;
 
 //-----------------------------------------------------------------------------
@@ -85,10 +87,13 @@ protected:
   */
   void ClearRecordedFramesInternal();
   /*!
-  * Save data to file
+  * Hand the recorded frames over to the saving thread to be written into a file, recording can continue into a new frame list
   */
   void WriteToFile(const QString& aFilename);
 
+  /*! Show or hide the saving progress according to the jobs of the saving thread */
+  void UpdateSavingProgress();
+
   /*! Get the sampling period length (in seconds). Frames are copied from the devices to the data collection buffer once in every sampling period. */
   double GetSamplingPeriodSec();
 
@@ -148,27 +153,46 @@ protected slots:
   void SamplingRateChanged(int aValue);
 
   /*!
-  * Record tracked frames (the recording timer calls it)
+  * Handle status message from any sub capture widgets
   */
-  void Capture();
+  void HandleStatusMessage(const std::string& aMessage);
 
   /*!
-  * Handle status message from any sub capture widgets
+  * Slot handling the end of saving a file in the saving thread
+  * \param aFilename Name of the saved file
+  * \param aSuccess True if the file has been written
+  * \param aCancelled True if the saving has been cancelled
   */
-  void HandleStatusMessage(const std::string& aMessage);
+  void SavingFinished(const QString& aFilename, bool aSuccess, bool aCancelled);
+
+  /*!
+  * Slot handling the progress of saving a file in the saving thread
+  * \param aFilename Name of the file that is being saved
+  * \param aNumberOfWrittenFrames Number of frames that have been written so far
+  * \param aNumberOfFrames Number of frames of the file
+  */
+  void SavingProgress(const QString& aFilename, int aNumberOfWrittenFrames, int aNumberOfFrames);
+
+  /*!
+  * Slot handling cancel saving button click
+  */
+  void CancelSaving();
 
 protected:
   /*! Recorded tracked frame list */
   vtkIGSIOTrackedFrameList* m_RecordedFrames;
 
-  /*! Timer triggering the */
-  QTimer* m_RecordingTimer;
+  /*! Thread of the recording worker */
+  QThread m_RecordingThread;
+
+  /*! Records the frames into the recorded frame list, lives in the recording thread */
+  QPlusRecordingWorker* m_RecordingWorker;
 
-  /*! Timestamp of last recorded frame (only frames that have more recent timestamp will be added) */
-  double m_RecordingLastAlreadyRecordedFrameTimestamp;
+  /*! Thread of the saving worker */
+  QThread m_SavingThread;
 
-  /*! Desired timestamp of the next frame to be recorded */
-  double m_RecordingNextFrameToBeRecordedTimestamp;
+  /*! Writes the saved frame lists into files, lives in the saving thread */
+  QPlusSequenceWriteWorker* m_SavingWorker;
 
   /*! Frame rate of the sampling */
   const int m_SamplingFrameRate;
@@ -176,17 +200,6 @@ protected:
   /*! Requested frame rate (frames per second) */
   double m_RequestedFrameRate;
 
-  /*! Actual frame rate (frames per second) */
-  double m_ActualFrameRate;
-
-  /*!
-    Frame index of the first frame that is recorded in this segment (since pressed the record button).
-    It is used when estimating the actual frame rate: frames that are acquired before this frame index (i.e.,
-    those that were acquired in a different recording segment) will not be taken into account in the actual
-    frame rate computation.
-  */
-  int m_RecordingFirstFrameIndexInThisSegment;
-
   /*! String to hold the last location of data saved */
   std::string m_LastSaveLocation;
 
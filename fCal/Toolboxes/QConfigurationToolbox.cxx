@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "QConfigurationToolbox.h"
+#include "QPlusFrameProfiler.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusDisplayableObject.h"
 #include "vtkPlusVisualizationController.h"
@@ -96,6 +97,8 @@ void QConfigurationToolbox::RefreshContent()
 {
   //LOG_TRACE("ConfigurationToolbox::RefreshToolboxContent");
 
+  QPlusFrameProfiler::Scope profilerScope("QConfigurationToolbox::RefreshContent");
+
   if (m_ToolStateDisplayWidget->IsInitialized())
   {
     m_ToolStateDisplayWidget->Update();
@@ -204,8 +207,15 @@ void QConfigurationToolbox::ConnectToDevicesByConfigFile(std::string aConfigFile
         // TODO: check if setchannel is called by the previous line
         //m_ParentMainWindow->GetVisualizationController()->SetDataCollectorX(m_ParentMainWindow->GetVisualizationController()->GetDataCollector());
 
-        // Allow object visualizer to load anything it needs
+        // Allow object visualizer to load anything it needs. The models are loaded in the background, show the progress meanwhile.
+        QMetaObject::Connection progressConnection = connect(m_ParentMainWindow->GetVisualizationController(), &vtkPlusVisualizationController::ModelLoadingProgress, connectDialog,
+          [connectLabel](double aProgress)
+        {
+          connectLabel->setText(QString("Loading models, please wait... %1%").arg(static_cast<int>(aProgress * 100.0 + 0.5)));
+          QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+        });
         m_ParentMainWindow->GetVisualizationController()->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
+        disconnect(progressConnection);
 
         // Successful connection
         m_DeviceSetSelectorWidget->SetConnectionSuccessful(true);
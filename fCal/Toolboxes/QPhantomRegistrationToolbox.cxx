@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "QPhantomRegistrationToolbox.h"
+#include "QPlusFrameProfiler.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusDisplayableObject.h"
 #include "vtkPlusVisualizationController.h"
@@ -240,6 +241,8 @@ void QPhantomRegistrationToolbox::RefreshContent()
 {
   //LOG_TRACE("PhantomRegistrationToolbox::RefreshContent");
 
+  QPlusFrameProfiler::Scope profilerScope("QPhantomRegistrationToolbox::RefreshContent");
+
   // If in progress
   if (m_State == ToolboxState_InProgress)
   {
@@ -786,6 +789,7 @@ void QPhantomRegistrationToolbox::RecordPoint()
   // If there are at least 3 acquired points then register
   if (m_CurrentLandmarkIndex >= 3)
   {
+    QPlusFrameProfiler::Scope profilerScope("Phantom landmark registration");
     if (m_PhantomLandmarkRegistration->LandmarkRegister(m_ParentMainWindow->GetVisualizationController()->GetTransformRepository()) == PLUS_SUCCESS)
     {
       m_ParentMainWindow->GetVisualizationController()->ShowObjectById(m_ParentMainWindow->GetPhantomModelId(), true);
@@ -1036,6 +1040,7 @@ void QPhantomRegistrationToolbox::StopLinearObjectRegistration()
   disconnect(&m_ParentMainWindow->GetVisualizationController()->GetAcquisitionTimer(), SIGNAL(timeout()), this, SLOT(AddStylusTipTransformToLinearObjectRegistration()));
 
   //TODO:  send acquired points to algorithm [make sure to catch any errors and to replace any phantom landmark registration done prior] (logic)
+  QPlusFrameProfiler::Scope profilerScope("Phantom linear object registration");
   if (m_PhantomLinearObjectRegistration->LinearObjectRegister(m_ParentMainWindow->GetVisualizationController()->GetTransformRepository()) != PLUS_SUCCESS)
   {
     LOG_WARNING("Unable to register phantom! Try again");
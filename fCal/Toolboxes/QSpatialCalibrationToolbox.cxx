@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "QSpatialCalibrationToolbox.h"
+#include "QPlusFrameProfiler.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusDisplayableObject.h"
 #include "vtkPlusVisualizationController.h"
@@ -651,6 +652,8 @@ void QSpatialCalibrationToolbox::DoCalibration()
 {
   LOG_TRACE("SpatialCalibrationToolbox::DoSpatialCalibration");
 
+  QPlusFrameProfiler::Scope profilerScope("QSpatialCalibrationToolbox::DoCalibration");
+
   // Enable wire label visualization
   m_ParentMainWindow->GetVisualizationController()->EnableWireLabels(true);
 
@@ -661,6 +664,8 @@ void QSpatialCalibrationToolbox::DoCalibration()
   if (m_NumberOfSegmentedCalibrationImages >= m_NumberOfCalibrationImagesToAcquire
       && m_NumberOfSegmentedValidationImages >= m_NumberOfValidationImagesToAcquire)
   {
+    QPlusFrameProfiler::Scope calibrationScope("Spatial calibration");
+
     LOG_INFO("Segmentation success rate: " << m_NumberOfSegmentedCalibrationImages + m_NumberOfSegmentedValidationImages << " out of " << m_SpatialCalibrationData->GetNumberOfTrackedFrames() + m_SpatialValidationData->GetNumberOfTrackedFrames() << " (" << (int)(((double)(m_NumberOfSegmentedCalibrationImages + m_NumberOfSegmentedValidationImages) / (double)(m_SpatialCalibrationData->GetNumberOfTrackedFrames() + m_SpatialValidationData->GetNumberOfTrackedFrames())) * 100.0 + 0.49) << " percent)");
 
     if (m_Calibration->Calibrate(m_SpatialValidationData, m_SpatialCalibrationData, m_ParentMainWindow->GetVisualizationController()->GetTransformRepository(), m_PatternRecognition->GetFidLineFinder()->GetNWires()) != PLUS_SUCCESS)
@@ -764,6 +769,7 @@ void QSpatialCalibrationToolbox::DoCalibration()
   int numberOfNewlySegmentedImages = 0;
   if (numberOfFramesBeforeRecording < trackedFrameListToUse->GetNumberOfTrackedFrames())
   {
+    QPlusFrameProfiler::Scope segmentationScope("Spatial calibration segmentation");
     PlusFidPatternRecognition::PatternRecognitionError error;
     if (m_PatternRecognition->RecognizePattern(trackedFrameListToUse, error, &numberOfNewlySegmentedImages) != PLUS_SUCCESS)
     {
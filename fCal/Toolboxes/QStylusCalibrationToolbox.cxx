@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "QStylusCalibrationToolbox.h"
+#include "QPlusFrameProfiler.h"
 #include "fCalMainWindow.h"
 #include "igsioMath.h"
 #include "vtkPlusPivotCalibrationAlgo.h"
@@ -140,6 +141,8 @@ void QStylusCalibrationToolbox::RefreshContent()
 {
   LOG_TRACE("StylusCalibrationToolbox::RefreshContent");
 
+  QPlusFrameProfiler::Scope profilerScope("QStylusCalibrationToolbox::RefreshContent");
+
   if (m_State == ToolboxState_Idle)
   {
     ui.label_NumberOfPoints->setText(QString("%1 / %2").arg(0).arg(m_NumberOfPoints));
@@ -450,6 +453,7 @@ void QStylusCalibrationToolbox::StopCalibration()
   else
   {
     // Calibrate async
+    QPlusFrameProfiler::Scope profilerScope("Stylus pivot calibration");
     PlusStatus result = m_PivotCalibration->DoPivotCalibration(m_ParentMainWindow->GetVisualizationController()->GetTransformRepository());
 
     if (result == PLUS_SUCCESS)
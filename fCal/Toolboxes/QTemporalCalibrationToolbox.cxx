@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "QTemporalCalibrationToolbox.h"
+#include "QPlusFrameProfiler.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusVisualizationController.h"
 
@@ -286,6 +287,8 @@ PlusStatus QTemporalCalibrationToolbox::ReadConfiguration(vtkXMLDataElement* aCo
 //-----------------------------------------------------------------------------
 void QTemporalCalibrationToolbox::RefreshContent()
 {
+  QPlusFrameProfiler::Scope profilerScope("QTemporalCalibrationToolbox::RefreshContent");
+
   if (m_ParentMainWindow->GetVisualizationController() == nullptr ||
       this->m_ParentMainWindow->GetVisualizationController()->GetSelectedChannel() == nullptr)
   {
@@ -330,6 +333,8 @@ void QTemporalCalibrationToolbox::RefreshContent()
 //----------------------------------------------------------------------------
 void QTemporalCalibrationToolbox::SegmentAndDisplayLine(igsioTrackedFrame& frame)
 {
+  QPlusFrameProfiler::Scope profilerScope("Temporal calibration line segmentation");
+
   // Try segmenting the line from the image
   this->LineSegmenter->SetTrackedFrame(frame);
   this->LineSegmenter->SetSaveIntermediateImages(false);
@@ -659,6 +664,8 @@ void QTemporalCalibrationToolbox::StartCalibration()
 //-----------------------------------------------------------------------------
 void QTemporalCalibrationToolbox::ComputeCalibrationResults()
 {
+  QPlusFrameProfiler::Scope profilerScope("Temporal calibration");
+
   // Create dialog
   QDialog* temporalCalibrationDialog = new QDialog(this, Qt::Dialog);
   temporalCalibrationDialog->setMinimumSize(QSize(360, 80));
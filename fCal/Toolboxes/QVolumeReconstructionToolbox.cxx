@@ -6,6 +6,7 @@ See License.txt for details.
 
 #include "QCapturingToolbox.h"
 #include "QVolumeReconstructionToolbox.h"
+#include "QPlusFrameProfiler.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusVisualizationController.h"
 
@@ -103,6 +104,8 @@ void QVolumeReconstructionToolbox::RefreshContent()
 {
   //LOG_TRACE("VolumeReconstructionToolbox::RefreshContent");
 
+  QPlusFrameProfiler::Scope profilerScope("QVolumeReconstructionToolbox::RefreshContent");
+
   ui.label_ContouringThreshold->setText(QString::number(m_ContouringThreshold));
 
   if (m_State == ToolboxState_InProgress)
@@ -321,6 +324,8 @@ void QVolumeReconstructionToolbox::Reconstruct()
 {
   LOG_TRACE("VolumeReconstructionToolbox::Reconstruct");
 
+  QPlusFrameProfiler::Scope profilerScope("Volume reconstruction");
+
   QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
 
   if (ReconstructVolumeFromInputImage() != PLUS_SUCCESS)
@@ -7,6 +7,7 @@ See License.txt for details.
 // Local includes
 #include "fCalMainWindow.h"
 #include "QPlusChannelAction.h"
+#include "QPlusFrameProfiler.h"
 #include "vtkPlusVisualizationController.h"
 
 // Toolbox includes
@@ -19,6 +20,7 @@ See License.txt for details.
 #include "QVolumeReconstructionToolbox.h"
 
 // PlusLib includes
+#include <vtkIGSIOAccurateTimer.h>
 #include <vtkPlusDataSource.h>
 #include <vtkPlusVirtualCapture.h>
 #include <vtkPlusVirtualMixer.h>
@@ -27,14 +29,22 @@ See License.txt for details.
 
 // vtk includes
 #include "vtkRenderWindow.h"
+#include <vtksys/SystemTools.hxx>
 
 // Qt includes
 #include <QFileDialog>
+#include <QGridLayout>
+#include <QGuiApplication>
 #include <QLabel>
 #include <QMenu>
 #include <QProgressBar>
+#include <QScreen>
+#include <QSignalBlocker>
 #include <QTimer>
 
+// STL includes
+#include <cmath>
+
 
 //-----------------------------------------------------------------------------
 fCalMainWindow::fCalMainWindow(QWidget* parent, Qt::WindowFlags flags)
@@ -44,6 +54,21 @@ fCalMainWindow::fCalMainWindow(QWidget* parent, Qt::WindowFlags flags)
   , m_LockedTabIndex(-1)
   , m_ActiveToolbox(ToolboxType_Undefined)
   , m_VisualizationController(NULL)
+  , m_UiRefreshTimer(NULL)
+  , m_IdleRefreshTimer(NULL)
+  , m_FrameIntervalMsec(1000 / DEFAULT_SCREEN_REFRESH_RATE_HZ)
+  , m_LastFrameTimeSec(0.0)
+  , m_FrameStatisticsStartTimeSec(0.0)
+  , m_FrameStatisticsFrameCount(0)
+  , m_FrameStatisticsTotalFrameTimeSec(0.0)
+  , m_FrameStatisticsMaxFrameTimeSec(0.0)
+  , m_FrameStatisticsMaxLatencySec(0.0)
+  , m_LastRenderedSceneMTime(0)
+  , m_LastRenderedSnapshotTimestamp(UNDEFINED_TIMESTAMP)
+  , m_ShowFrameStatisticsAction(NULL)
+  , m_ProfileFrameTimesAction(NULL)
+  , m_ShowChannelTilesAction(NULL)
+  , m_ChannelTileContainer(NULL)
   , m_StatusIcon(NULL)
   , m_ShowPoints(false)
   , m_ForceShowAllDevicesIn3D(false)
@@ -64,8 +89,17 @@ fCalMainWindow::fCalMainWindow(QWidget* parent, Qt::WindowFlags flags)
 //-----------------------------------------------------------------------------
 fCalMainWindow::~fCalMainWindow()
 {
+  if (m_IdleRefreshTimer != NULL)
+  {
+    m_IdleRefreshTimer->stop();
+    delete m_IdleRefreshTimer;
+    m_IdleRefreshTimer = NULL;
+  }
+
   if (m_VisualizationController != NULL)
   {
+    // The tile canvases are deleted with the window, the controller must not access them afterwards
+    m_VisualizationController->ClearChannelTiles();
     m_VisualizationController->Delete();
     m_VisualizationController = NULL;
   }
@@ -100,13 +134,36 @@ void fCalMainWindow::Initialize()
   // Create status icon
   m_StatusIcon = new QPlusStatusIcon(this);
 
-  // Set up timer for refreshing UI
+  // Set up timers for refreshing UI. The GUI is updated when a new frame arrives, but at most once per screen refresh.
+  QScreen* screen = QGuiApplication::primaryScreen();
+  if (screen != NULL && screen->refreshRate() > 0)
+  {
+    m_FrameIntervalMsec = std::max(1, static_cast<int>(1000.0 / screen->refreshRate()));
+  }
   m_UiRefreshTimer = new QTimer(this);
+  m_UiRefreshTimer->setSingleShot(true);
+  m_UiRefreshTimer->setTimerType(Qt::PreciseTimer);
+  m_IdleRefreshTimer = new QTimer(this);
 
   // Set up menu items for tools button
   QAction* dumpBuffersAction = new QAction("Dump buffers into files...", ui.pushButton_Tools);
   connect(dumpBuffersAction, SIGNAL(triggered()), this, SLOT(DumpBuffers()));
   ui.pushButton_Tools->addAction(dumpBuffersAction);
+  m_ShowFrameStatisticsAction = new QAction("Show frame statistics", ui.pushButton_Tools);
+  m_ShowFrameStatisticsAction->setCheckable(true);
+  connect(m_ShowFrameStatisticsAction, &QAction::toggled, this, &fCalMainWindow::ShowFrameStatisticsToggled);
+  ui.pushButton_Tools->addAction(m_ShowFrameStatisticsAction);
+  m_ProfileFrameTimesAction = new QAction("Profile frame times", ui.pushButton_Tools);
+  m_ProfileFrameTimesAction->setCheckable(true);
+  connect(m_ProfileFrameTimesAction, &QAction::toggled, this, &fCalMainWindow::ProfileFrameTimesToggled);
+  ui.pushButton_Tools->addAction(m_ProfileFrameTimesAction);
+  QAction* exportFrameProfileAction = new QAction("Export frame profile...", ui.pushButton_Tools);
+  connect(exportFrameProfileAction, &QAction::triggered, this, &fCalMainWindow::ExportFrameProfile);
+  ui.pushButton_Tools->addAction(exportFrameProfileAction);
+  m_ShowChannelTilesAction = new QAction("Show all video channels", ui.pushButton_Tools);
+  m_ShowChannelTilesAction->setCheckable(true);
+  connect(m_ShowChannelTilesAction, &QAction::toggled, this, &fCalMainWindow::ShowChannelTilesToggled);
+  ui.pushButton_Tools->addAction(m_ShowChannelTilesAction);
 
   // Declare this class as the event handler
   ui.pushButton_Tools->installEventFilter(this);
@@ -147,6 +204,18 @@ void fCalMainWindow::Initialize()
   m_VisualizationController = vtkPlusVisualizationController::New();
   m_VisualizationController->SetCanvas(ui.canvas);
 
+  // Put the canvas into a grid, so that the channel tiles can be shown next to it
+  m_CanvasMinimumSize = ui.canvas->minimumSize();
+  m_ChannelTileContainer = new QWidget(ui.widget_viewingContainer);
+  m_ChannelTileContainer->setSizePolicy(ui.canvas->sizePolicy());
+  QGridLayout* tileLayout = new QGridLayout(m_ChannelTileContainer);
+  tileLayout->setContentsMargins(0, 0, 0, 0);
+  tileLayout->setSpacing(2);
+  int canvasIndex = ui.verticalLayout_viewingContainer->indexOf(ui.canvas);
+  ui.verticalLayout_viewingContainer->removeWidget(ui.canvas);
+  ui.verticalLayout_viewingContainer->insertWidget(canvasIndex, m_ChannelTileContainer);
+  tileLayout->addWidget(ui.canvas, 0, 0);
+
   // Hide it until we have something to show
   ui.canvas->setVisible(true);
   ui.label_SliceNumber->setVisible(false);
@@ -163,6 +232,8 @@ void fCalMainWindow::Initialize()
   connect(ui.toolbox, SIGNAL(currentChanged(int)), this, SLOT(CurrentToolboxChanged(int)));
   connect(ui.pushButton_SaveConfiguration, SIGNAL(clicked()), this, SLOT(SaveDeviceSetConfiguration()));
   connect(m_UiRefreshTimer, SIGNAL(timeout()), this, SLOT(UpdateGUI()));
+  connect(m_IdleRefreshTimer, SIGNAL(timeout()), this, SLOT(ScheduleGUIUpdate()));
+  connect(m_VisualizationController, SIGNAL(SnapshotReady()), this, SLOT(OnSnapshotReady()));
   connect(ui.horizontalSlider_SliceNumber, SIGNAL(valueChanged(int)), this, SLOT(SliceNumberSliderChanged(int)));
   connect(ui.spinBox_SliceNumber, SIGNAL(valueChanged(int)), this, SLOT(SliceNumberSpinBoxChanged(int)));
 
@@ -172,8 +243,11 @@ void fCalMainWindow::Initialize()
   // Initialize default toolbox widget
   CurrentToolboxChanged(ui.toolbox->currentIndex());
 
-  // Start timer
-  m_UiRefreshTimer->start(50);
+  // Start polling and timers
+  m_VisualizationController->SetSnapshotPollingIntervalMsec(m_FrameIntervalMsec);
+  m_VisualizationController->SetTargetFrameRate(1000.0 / m_FrameIntervalMsec);
+  m_IdleRefreshTimer->start(IDLE_REFRESH_INTERVAL_MSEC);
+  ScheduleGUIUpdate();
 }
 
 //----------------------------------------------------------------------------
@@ -396,11 +470,12 @@ void fCalMainWindow::UpdateGUI()
 {
   LOG_TRACE("fCalMainWindow::UpdateGUI");
 
-  // We do not update the gui when a mouse button is pressed
-  if (QApplication::mouseButtons() != Qt::NoButton)
-  {
-    return;
-  }
+  QPlusFrameProfiler::Scope profilerScope("fCalMainWindow::UpdateGUI");
+
+  double frameStartTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  m_LastFrameTimeSec = frameStartTimeSec;
+
+  m_VisualizationController->Update();
 
   m_ToolboxList[m_ActiveToolbox]->RefreshContent();
 
@@ -414,7 +489,250 @@ void fCalMainWindow::UpdateGUI()
     }
   }
 
-  ui.canvas->update();
+  // The tiles are rendered independently of the canvas, only those that have a new frame
+  m_VisualizationController->RenderChannelTiles();
+
+  // Render only if something in the scene has changed: new image or transforms, toolbox or menu changes, or camera movement.
+  // Interaction renders by itself through the render window interactor, this only catches up with the changes it has made.
+  if (m_VisualizationController->GetSceneMTime() == m_LastRenderedSceneMTime)
+  {
+    // Use the idle time to extract the slices next to the displayed one
+    m_VisualizationController->PrefetchSlices();
+    return;
+  }
+
+  // Render synchronously so that the frame time includes rendering
+  {
+    QPlusFrameProfiler::Scope renderScope("Render canvas");
+    ui.canvas->repaint();
+  }
+
+  // Rendering itself may modify the scene (e.g., camera clipping range), so the time is taken afterwards
+  m_LastRenderedSceneMTime = m_VisualizationController->GetSceneMTime();
+
+  UpdateFrameStatistics(frameStartTimeSec, vtkIGSIOAccurateTimer::GetSystemTime());
+
+  // Extract the slices next to the displayed one after the frame, so that scrolling does not have to wait for them
+  {
+    QPlusFrameProfiler::Scope prefetchScope("Prefetch slices");
+    m_VisualizationController->PrefetchSlices();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::ScheduleGUIUpdate()
+{
+  if (m_UiRefreshTimer->isActive())
+  {
+    // Already scheduled
+    return;
+  }
+
+  double elapsedMsec = (vtkIGSIOAccurateTimer::GetSystemTime() - m_LastFrameTimeSec) * 1000.0;
+  int delayMsec = std::max(0, m_FrameIntervalMsec - static_cast<int>(elapsedMsec));
+  m_UiRefreshTimer->start(delayMsec);
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::OnSnapshotReady()
+{
+  // New data arrived, no need for the idle refresh until data stops coming
+  m_IdleRefreshTimer->start(IDLE_REFRESH_INTERVAL_MSEC);
+  ScheduleGUIUpdate();
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::UpdateFrameStatistics(double aFrameStartTimeSec, double aFrameEndTimeSec)
+{
+  if (!m_ShowFrameStatisticsAction->isChecked())
+  {
+    return;
+  }
+
+  double frameTimeSec = aFrameEndTimeSec - aFrameStartTimeSec;
+  m_FrameStatisticsFrameCount++;
+  m_FrameStatisticsTotalFrameTimeSec += frameTimeSec;
+  m_FrameStatisticsMaxFrameTimeSec = std::max(m_FrameStatisticsMaxFrameTimeSec, frameTimeSec);
+
+  QPlusFrameSnapshotWorker::SnapshotConstPtr snapshot = m_VisualizationController->GetLatestSnapshot();
+  if (snapshot && snapshot->Timestamp != m_LastRenderedSnapshotTimestamp)
+  {
+    m_LastRenderedSnapshotTimestamp = snapshot->Timestamp;
+    m_FrameStatisticsMaxLatencySec = std::max(m_FrameStatisticsMaxLatencySec, aFrameEndTimeSec - snapshot->CreationTimeSec);
+  }
+
+  double periodSec = aFrameEndTimeSec - m_FrameStatisticsStartTimeSec;
+  if (periodSec * 1000.0 < FRAME_STATISTICS_PERIOD_MSEC)
+  {
+    return;
+  }
+
+  std::ostringstream statistics;
+  statistics << std::fixed << std::setprecision(1)
+             << m_FrameStatisticsFrameCount / periodSec << " fps" << std::endl
+             << "Frame time: " << m_FrameStatisticsTotalFrameTimeSec / m_FrameStatisticsFrameCount * 1000.0 << " ms"
+             << " (max " << m_FrameStatisticsMaxFrameTimeSec * 1000.0 << " ms)" << std::endl
+             << "Max latency: " << m_FrameStatisticsMaxLatencySec * 1000.0 << " ms";
+  if (QPlusFrameProfiler::GetInstance()->IsEnabled())
+  {
+    // Average time spent in the instrumented parts since the previous statistics period
+    statistics << std::endl << QPlusFrameProfiler::GetInstance()->GetStatisticsText(MAX_NUMBER_OF_FRAME_PROFILE_LINES, true);
+  }
+  m_VisualizationController->SetFrameStatisticsText(statistics.str());
+
+  m_FrameStatisticsStartTimeSec = aFrameEndTimeSec;
+  m_FrameStatisticsFrameCount = 0;
+  m_FrameStatisticsTotalFrameTimeSec = 0.0;
+  m_FrameStatisticsMaxFrameTimeSec = 0.0;
+  m_FrameStatisticsMaxLatencySec = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::ShowFrameStatisticsToggled(bool aOn)
+{
+  LOG_TRACE("fCalMainWindow::ShowFrameStatisticsToggled(" << (aOn ? "true" : "false") << ")");
+
+  // Start a new statistics period
+  m_FrameStatisticsStartTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  m_FrameStatisticsFrameCount = 0;
+  m_FrameStatisticsTotalFrameTimeSec = 0.0;
+  m_FrameStatisticsMaxFrameTimeSec = 0.0;
+  m_FrameStatisticsMaxLatencySec = 0.0;
+
+  m_VisualizationController->SetFrameStatisticsText("Measuring...");
+  m_VisualizationController->ShowFrameStatistics(aOn);
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::ProfileFrameTimesToggled(bool aOn)
+{
+  LOG_TRACE("fCalMainWindow::ProfileFrameTimesToggled(" << (aOn ? "true" : "false") << ")");
+
+  // Enabling starts a new profile, the previous one can no longer be exported
+  QPlusFrameProfiler::GetInstance()->SetEnabled(aOn);
+
+  // The profile is shown in the frame statistics
+  if (aOn && !m_ShowFrameStatisticsAction->isChecked())
+  {
+    m_ShowFrameStatisticsAction->setChecked(true);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::ExportFrameProfile()
+{
+  LOG_TRACE("fCalMainWindow::ExportFrameProfile");
+
+  if (QPlusFrameProfiler::GetInstance()->GetNumberOfTraceEvents() == 0)
+  {
+    LOG_WARNING("No frame profile has been recorded. Turn on Profile frame times in the Tools menu first.");
+    return;
+  }
+
+  std::string defaultFileName = vtkPlusConfig::GetInstance()->GetOutputDirectory() + "/fCalFrameProfile_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + ".json";
+  QString fileName = QFileDialog::getSaveFileName(NULL, tr("Save frame profile"), QString(defaultFileName.c_str()), tr("Chrome trace files (*.json)"));
+  if (fileName.isEmpty())
+  {
+    // Cancel button hit, just cancel gracefully
+    return;
+  }
+
+  if (QPlusFrameProfiler::GetInstance()->WriteTrace(fileName.toLatin1().constData()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Saving the frame profile failed (file: " << fileName.toLatin1().constData() << ")");
+    return;
+  }
+
+  LOG_INFO("Frame profile saved into '" << fileName.toLatin1().constData() << "'");
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::ShowChannelTilesToggled(bool aOn)
+{
+  LOG_TRACE("fCalMainWindow::ShowChannelTilesToggled(" << (aOn ? "true" : "false") << ")");
+
+  UpdateChannelTiles();
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::UpdateChannelTiles()
+{
+  LOG_TRACE("fCalMainWindow::UpdateChannelTiles");
+
+  // Collect all the video channels, the selected one is highlighted among them
+  std::vector<vtkPlusChannel*> tileChannels;
+  DeviceCollection devices;
+  vtkPlusDataCollector* dataCollector = m_VisualizationController->GetDataCollector();
+  if (m_ShowChannelTilesAction != NULL && m_ShowChannelTilesAction->isChecked() && m_SelectedChannel != NULL
+      && dataCollector != NULL && dataCollector->GetConnected() && dataCollector->GetDevices(devices) == PLUS_SUCCESS)
+  {
+    for (DeviceCollectionIterator it = devices.begin(); it != devices.end(); ++it)
+    {
+      vtkPlusDevice* device = *it;
+      if (dynamic_cast<vtkPlusVirtualCapture*>(device) != NULL)
+      {
+        continue;
+      }
+      for (ChannelContainerIterator channelIter = device->GetOutputChannelsStart(); channelIter != device->GetOutputChannelsEnd(); ++channelIter)
+      {
+        if ((*channelIter)->GetVideoDataAvailable())
+        {
+          tileChannels.push_back(*channelIter);
+        }
+      }
+    }
+  }
+  if (tileChannels.size() < 2)
+  {
+    // The only video channel is already shown in the canvas
+    tileChannels.clear();
+  }
+
+  // Creating the tile canvases is expensive, so the tiles are only rebuilt if the channels have changed
+  if (tileChannels == m_ChannelTileChannels)
+  {
+    m_VisualizationController->SetHighlightedChannelTile(m_SelectedChannel);
+    return;
+  }
+  m_ChannelTileChannels = tileChannels;
+
+  m_VisualizationController->ClearChannelTiles();
+  for (std::vector<QVTKWidget*>::iterator canvasIt = m_ChannelTileCanvases.begin(); canvasIt != m_ChannelTileCanvases.end(); ++canvasIt)
+  {
+    delete *canvasIt;
+  }
+  m_ChannelTileCanvases.clear();
+
+  // Arrange the canvas and the tiles in a square grid, the canvas stays in the top left cell
+  QGridLayout* tileLayout = static_cast<QGridLayout*>(m_ChannelTileContainer->layout());
+  int numberOfColumns = static_cast<int>(std::ceil(std::sqrt(tileChannels.size() + 1.0)));
+  for (std::vector<vtkPlusChannel*>::iterator channelIt = tileChannels.begin(); channelIt != tileChannels.end(); ++channelIt)
+  {
+    QVTKWidget* tileCanvas = new QVTKWidget(m_ChannelTileContainer);
+    tileCanvas->setMinimumSize(CHANNEL_TILE_MINIMUM_WIDTH, CHANNEL_TILE_MINIMUM_HEIGHT);
+    tileCanvas->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    if (m_VisualizationController->AddChannelTile(*channelIt, tileCanvas) != PLUS_SUCCESS)
+    {
+      delete tileCanvas;
+      continue;
+    }
+    m_ChannelTileCanvases.push_back(tileCanvas);
+    int cellIndex = static_cast<int>(m_ChannelTileCanvases.size());
+    tileLayout->addWidget(tileCanvas, cellIndex / numberOfColumns, cellIndex % numberOfColumns);
+  }
+  m_VisualizationController->SetHighlightedChannelTile(m_SelectedChannel);
+
+  // Let the canvas shrink to the size of a tile, otherwise the window would grow with each tile
+  if (m_ChannelTileCanvases.empty())
+  {
+    ui.canvas->setMinimumSize(m_CanvasMinimumSize);
+  }
+  else
+  {
+    ui.canvas->setMinimumSize(CHANNEL_TILE_MINIMUM_WIDTH, CHANNEL_TILE_MINIMUM_HEIGHT);
+  }
+
+  ScheduleGUIUpdate();
 }
 
 //-----------------------------------------------------------------------------
@@ -1040,6 +1358,9 @@ void fCalMainWindow::SetSelectedChannel(vtkPlusChannel* aChannel)
 
   this->GetVisualizationController()->SetSelectedChannel(aChannel);
 
+  // The tiles show all video channels and highlight the one shown in the canvas
+  this->UpdateChannelTiles();
+
   this->m_ToolboxList[m_ActiveToolbox]->SetDisplayAccordingToState();
 
   this->UpdateSliceNumberUI();
@@ -1060,15 +1381,27 @@ void fCalMainWindow::SetStatusIconMaxMessageCount(int count)
 //-----------------------------------------------------------------------------
 void fCalMainWindow::SliceNumberSliderChanged(int number)
 {
-  this->ui.spinBox_SliceNumber->setValue(number);
+  // Update the spin box without its signal, otherwise the slice would be set twice
+  {
+    QSignalBlocker blocker(this->ui.spinBox_SliceNumber);
+    this->ui.spinBox_SliceNumber->setValue(number);
+  }
   this->GetVisualizationController()->SetSliceNumber(number);
+
+  // Show the new slice right away instead of waiting for the next frame or idle refresh
+  ScheduleGUIUpdate();
 }
 
 //-----------------------------------------------------------------------------
 void fCalMainWindow::SliceNumberSpinBoxChanged(int number)
 {
-  this->ui.horizontalSlider_SliceNumber->setValue(number);
+  {
+    QSignalBlocker blocker(this->ui.horizontalSlider_SliceNumber);
+    this->ui.horizontalSlider_SliceNumber->setValue(number);
+  }
   this->GetVisualizationController()->SetSliceNumber(number);
+
+  ScheduleGUIUpdate();
 }
 
 //-----------------------------------------------------------------------------
@@ -10,13 +10,16 @@ See License.txt for details.
 #include "PlusConfigure.h"
 #include "ui_fCalMainWindow.h"
 #include <QMainWindow>
+#include <vtkType.h>
 
 class QAbstractToolbox;
+class QAction;
 class QPlusChannelAction;
 class QLabel;
 class QPlusStatusIcon;
 class QProgressBar;
 class QTimer;
+class QVTKWidget;
 class vtkPlusChannel;
 class vtkPlusDevice;
 class vtkPlusVisualizationController;
@@ -205,6 +208,19 @@ protected:
   */
   bool eventFilter(QObject* obj, QEvent* ev);
 
+  /*!
+  * Update the frame rate and frame time statistics and show them if enabled
+  * \param aFrameStartTimeSec System time when the frame update started
+  * \param aFrameEndTimeSec System time when the frame has been rendered
+  */
+  void UpdateFrameStatistics(double aFrameStartTimeSec, double aFrameEndTimeSec);
+
+  /*!
+  * Update the channel tiles of the tiled view. If the tiled view is enabled, all video channels are shown in tiles next
+  * to the canvas and the tile of the selected channel is highlighted. The tiles are only rebuilt if the channels change.
+  */
+  void UpdateChannelTiles();
+
 protected slots:
   /*!
   * Handle tab change
@@ -219,10 +235,40 @@ protected slots:
   void ChangeBackToolbox(int);
 
   /*!
-  * Updates every part of the GUI (called by ui refresh timer)
+  * Updates every part of the GUI (called by ui refresh timer). The canvas is rendered only if the scene has changed.
   */
   void UpdateGUI();
 
+  /*!
+  * Schedule a GUI update. The update happens immediately if the last one was more than a display refresh interval ago,
+  * otherwise it is delayed until the next refresh interval. Multiple requests before the update are merged.
+  */
+  void ScheduleGUIUpdate();
+
+  /*!
+  * Called when the visualization controller has a snapshot of a new tracked frame
+  */
+  void OnSnapshotReady();
+
+  /*!
+  * Slot handling show frame statistics action toggle
+  */
+  void ShowFrameStatisticsToggled(bool aOn);
+
+  /*!
+  * Slot handling profile frame times action toggle. While profiling, the frame statistics show the time spent in the
+  * instrumented parts of the update.
+  */
+  void ProfileFrameTimesToggled(bool aOn);
+
+  /*! Save the recorded frame profile into a trace file (Chrome trace event format, can be opened in Perfetto) */
+  void ExportFrameProfile();
+
+  /*!
+  * Slot handling show all video channels action toggle
+  */
+  void ShowChannelTilesToggled(bool aOn);
+
   /*!
   * Update the slicer number UI based on channel data
   */
@@ -294,9 +340,58 @@ protected:
   /*! Active toolbox identifier */
   ToolboxType                         m_ActiveToolbox;
 
-  /*! Timer that refreshes the UI */
+  /*! Single shot timer that refreshes the UI at the next display refresh interval */
   QTimer*                             m_UiRefreshTimer;
 
+  /*! Timer that refreshes the toolboxes and checks the scene for changes when no new frames arrive (e.g., data collection is not started) */
+  QTimer*                             m_IdleRefreshTimer;
+
+  /*! Minimum time between two GUI updates, determined from the refresh rate of the screen */
+  int                                 m_FrameIntervalMsec;
+
+  /*! System time of the start of the last GUI update */
+  double                              m_LastFrameTimeSec;
+
+  /*! Start of the current frame statistics period */
+  double                              m_FrameStatisticsStartTimeSec;
+
+  /*! Number of frames in the current frame statistics period */
+  int                                 m_FrameStatisticsFrameCount;
+
+  /*! Sum and maximum of the frame times in the current frame statistics period */
+  double                              m_FrameStatisticsTotalFrameTimeSec;
+  double                              m_FrameStatisticsMaxFrameTimeSec;
+
+  /*! Maximum time between receiving a snapshot and rendering it in the current frame statistics period */
+  double                              m_FrameStatisticsMaxLatencySec;
+
+  /*! Scene modification time after the last render, the canvas is only rendered again if the scene has been modified since */
+  vtkMTimeType                        m_LastRenderedSceneMTime;
+
+  /*! Timestamp of the last rendered snapshot, used to measure the latency only once per snapshot */
+  double                              m_LastRenderedSnapshotTimestamp;
+
+  /*! Show frame statistics action in the tools menu */
+  QAction*                            m_ShowFrameStatisticsAction;
+
+  /*! Profile frame times action in the tools menu, turns the frame profiler on and off */
+  QAction*                            m_ProfileFrameTimesAction;
+
+  /*! Show all video channels action in the tools menu, turns the tiled view on and off */
+  QAction*                            m_ShowChannelTilesAction;
+
+  /*! Widget holding the canvas and the channel tiles in a grid */
+  QWidget*                            m_ChannelTileContainer;
+
+  /*! Canvases of the channel tiles */
+  std::vector<QVTKWidget*>            m_ChannelTileCanvases;
+
+  /*! Channels that the channel tiles were built for */
+  std::vector<vtkPlusChannel*>        m_ChannelTileChannels;
+
+  /*! Minimum size of the canvas when no channel tiles are shown */
+  QSize                               m_CanvasMinimumSize;
+
   /*! Status icon instance */
   QPlusStatusIcon*                    m_StatusIcon;
 
@@ -363,6 +458,18 @@ protected:
   /*! Selected channel */
   vtkPlusChannel*                     m_SelectedChannel;
 
+  /*! Interval of the GUI update when no new frames arrive. The canvas is only rendered if the scene has changed, so this is cheap. */
+  static const int IDLE_REFRESH_INTERVAL_MSEC = 100;
+  /*! Screen refresh rate used if the screen does not report it */
+  static const int DEFAULT_SCREEN_REFRESH_RATE_HZ = 60;
+  /*! Length of the period over which the frame statistics are averaged */
+  static const int FRAME_STATISTICS_PERIOD_MSEC = 1000;
+  /*! Maximum number of profiled scopes listed in the frame statistics */
+  static const int MAX_NUMBER_OF_FRAME_PROFILE_LINES = 8;
+  /*! Minimum size of the canvas and the channel tiles in the tiled view */
+  static const int CHANNEL_TILE_MINIMUM_WIDTH = 320;
+  static const int CHANNEL_TILE_MINIMUM_HEIGHT = 240;
+
 private:
   Ui::fCalMainWindow ui;
 };
@@ -6,7 +6,9 @@ See License.txt for details.
 
 // Local includes
 #include "vtkPlus3DObjectVisualizer.h"
+#include "QPlusFrameProfiler.h"
 #include "vtkPlusDisplayableObject.h"
+#include "vtkPlusImageSliceCache.h"
 
 // PlusLib includes
 #include <PlusConfigure.h>
@@ -15,13 +17,55 @@ See License.txt for details.
 #include <vtkPlusDevice.h>
 
 // VTK includes
-#include <vtkGlyph3D.h>
+#include <vtkCommand.h>
+#include <vtkGlyph3DMapper.h>
+#include <vtkImageData.h>
 #include <vtkImageSliceMapper.h>
+#include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
+#include <vtkTransform.h>
+
+// Qt includes
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QThreadPool>
+
+// STL includes
+#include <set>
+
+namespace
+{
+  /*! How often progress is reported while the model files are being loaded */
+  const int MODEL_LOADING_PROGRESS_INTERVAL_MSEC = 50;
+
+  //----------------------------------------------------------------------------
+  // Loads one model file on a thread pool thread
+  class ModelFileLoader : public QRunnable
+  {
+  public:
+    ModelFileLoader(const std::string& aModelFilePath, int aNumberOfLevelsOfDetail, QAtomicInt* aNumberOfLoadedModels)
+      : ModelFilePath(aModelFilePath)
+      , NumberOfLevelsOfDetail(aNumberOfLevelsOfDetail)
+      , NumberOfLoadedModels(aNumberOfLoadedModels)
+    {
+    }
+
+    virtual void run()
+    {
+      vtkDisplayableModel::PreloadModelFile(this->ModelFilePath, this->NumberOfLevelsOfDetail);
+      this->NumberOfLoadedModels->ref();
+    }
+
+  protected:
+    std::string ModelFilePath;
+    int NumberOfLevelsOfDetail;
+    QAtomicInt* NumberOfLoadedModels;
+  };
+}
 
 //-----------------------------------------------------------------------------
 
@@ -32,39 +76,44 @@ vtkPlus3DObjectVisualizer::vtkPlus3DObjectVisualizer()
   : CanvasRenderer(vtkSmartPointer<vtkRenderer>::New())
   , ImageActor(vtkSmartPointer<vtkImageActor>::New())
   , InputActor(vtkSmartPointer<vtkActor>::New())
-  , InputGlyph(vtkSmartPointer<vtkGlyph3D>::New())
+  , SliceCache(vtkSmartPointer<vtkPlusImageSliceCache>::New())
+  , InputGlyph(vtkSmartPointer<vtkGlyph3DMapper>::New())
   , ResultActor(vtkSmartPointer<vtkActor>::New())
-  , ResultGlyph(vtkSmartPointer<vtkGlyph3D>::New())
+  , ResultGlyph(vtkSmartPointer<vtkGlyph3DMapper>::New())
   , TransformRepository(NULL)
   , WorldCoordinateFrame("")
   , VolumeID("")
   , SelectedChannel(NULL)
+  , ObjectTransformCacheRepository(NULL)
 {
   // Set up canvas renderer
   this->CanvasRenderer->SetBackground(0.1, 0.1, 0.1);
   this->CanvasRenderer->SetBackground2(0.4, 0.4, 0.4);
   this->CanvasRenderer->SetGradientBackground(true);
 
-  // Input points actor
-  vtkSmartPointer<vtkPolyDataMapper> inputMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+  // Input points actor. The glyph mapper draws the sphere once per point with instancing, so the cost of a point
+  // update is a per-point instance attribute, not a copy of the sphere triangles.
   vtkSmartPointer<vtkSphereSource> inputSphereSource = vtkSmartPointer<vtkSphereSource>::New();
   inputSphereSource->SetRadius(2.0);   // mm
 
   // Connect all input items (except poly data) in chain
   this->InputGlyph->SetSourceConnection(inputSphereSource->GetOutputPort());
-  inputMapper->SetInputConnection(this->InputGlyph->GetOutputPort());
-  this->InputActor->SetMapper(inputMapper);
+  this->InputGlyph->ScalingOff();
+  this->InputGlyph->OrientOff();
+  this->InputGlyph->ScalarVisibilityOff();
+  this->InputActor->SetMapper(this->InputGlyph);
   this->InputActor->GetProperty()->SetColor(0.0, 0.7, 1.0);
 
   // Result points actor
-  vtkSmartPointer<vtkPolyDataMapper> resultMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
   vtkSmartPointer<vtkSphereSource> resultSphereSource = vtkSmartPointer<vtkSphereSource>::New();
   resultSphereSource->SetRadius(1.0);   // mm
 
   // Connect all result items (except poly data) in chain
   this->ResultGlyph->SetSourceConnection(resultSphereSource->GetOutputPort());
-  resultMapper->SetInputConnection(this->ResultGlyph->GetOutputPort());
-  this->ResultActor->SetMapper(resultMapper);
+  this->ResultGlyph->ScalingOff();
+  this->ResultGlyph->OrientOff();
+  this->ResultGlyph->ScalarVisibilityOff();
+  this->ResultActor->SetMapper(this->ResultGlyph);
   this->ResultActor->GetProperty()->SetColor(0.0, 0.8, 0.0);
 
   this->ImageMapper = vtkImageSliceMapper::SafeDownCast(this->ImageActor->GetMapper());
@@ -88,6 +137,8 @@ vtkPlus3DObjectVisualizer::~vtkPlus3DObjectVisualizer()
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlus3DObjectVisualizer::Update()
 {
+  QPlusFrameProfiler::Scope profilerScope("vtkPlus3DObjectVisualizer::Update");
+
   // If none of the objects are displayable then return with fail
   bool noObjectsToDisplay = true;
   for (std::vector<vtkPlusDisplayableObject*>::iterator it = this->DisplayableObjects.begin(); it != this->DisplayableObjects.end(); ++it)
@@ -105,36 +156,28 @@ PlusStatus vtkPlus3DObjectVisualizer::Update()
     return PLUS_SUCCESS;
   }
 
-  // Get tracked frame and set the transforms
-  igsioTrackedFrame trackedFrame;
-  if (this->SelectedChannel->GetTrackedFrame(trackedFrame) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Failed to get tracked frame!");
-    return PLUS_FAIL;
-  }
-
+  // The transforms of the current frame are set in the repository by the owner before calling this function
   if (this->TransformRepository == NULL)
   {
     return PLUS_FAIL;
   }
-  if (this->TransformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Failed to set current transforms to transform repository!");
-    return PLUS_FAIL;
-  }
+
+  this->UpdateObjectTransformCache();
 
   bool resetCameraNeeded = false;
 
   // Update actors of displayable objects
-  for (std::vector<vtkPlusDisplayableObject*>::iterator it = this->DisplayableObjects.begin(); it != this->DisplayableObjects.end(); ++it)
+  for (std::vector<ObjectTransformCacheEntry>::iterator it = this->ObjectTransformCache.begin(); it != this->ObjectTransformCache.end(); ++it)
   {
-    vtkPlusDisplayableObject* displayableObject = *it;
-    igsioTransformName objectCoordinateFrameToWorldTransformName(displayableObject->GetObjectCoordinateFrame(), this->WorldCoordinateFrame);
-    vtkSmartPointer<vtkMatrix4x4> objectCoordinateFrameToWorldTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    ObjectTransformCacheEntry& cacheEntry = *it;
+    vtkPlusDisplayableObject* displayableObject = cacheEntry.Object;
 
     // If not displayable or valid transform does not exist then hide
-    if ((displayableObject->IsDisplayable() == false)
-        || (this->TransformRepository->IsExistingTransform(objectCoordinateFrameToWorldTransformName) != PLUS_SUCCESS))
+    if (!cacheEntry.TransformExists && displayableObject->IsDisplayable())
+    {
+      cacheEntry.TransformExists = (this->TransformRepository->IsExistingTransform(cacheEntry.ObjectToWorldTransformName) == PLUS_SUCCESS);
+    }
+    if ((displayableObject->IsDisplayable() == false) || !cacheEntry.TransformExists)
     {
       if (displayableObject->GetActor())
       {
@@ -145,12 +188,26 @@ PlusStatus vtkPlus3DObjectVisualizer::Update()
 
     // Get object to world transform
     ToolStatus status(TOOL_INVALID);
-    if (this->TransformRepository->GetTransform(objectCoordinateFrameToWorldTransformName, objectCoordinateFrameToWorldTransformMatrix, &status) != PLUS_SUCCESS)
+    if (this->TransformRepository->GetTransform(cacheEntry.ObjectToWorldTransformName, cacheEntry.ObjectToWorldMatrix, &status) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to get transform from object (" << displayableObject->GetObjectCoordinateFrame() << ") to world! (" << this->WorldCoordinateFrame << ")");
+      cacheEntry.TransformExists = false;
       continue;
     }
 
+    // Skip the actor update if the object has not moved since the last update
+    bool transformChanged = !cacheEntry.LastObjectToWorldMatrixValid || status != cacheEntry.LastStatus;
+    for (int i = 0; i < 16 && !transformChanged; ++i)
+    {
+      transformChanged = (cacheEntry.LastObjectToWorldMatrix[i] != cacheEntry.ObjectToWorldMatrix->GetElement(i / 4, i % 4));
+    }
+    if (transformChanged)
+    {
+      vtkMatrix4x4::DeepCopy(cacheEntry.LastObjectToWorldMatrix, cacheEntry.ObjectToWorldMatrix);
+      cacheEntry.LastObjectToWorldMatrixValid = true;
+      cacheEntry.LastStatus = status;
+    }
+
     // If the transform is valid then display it normally
     if (status == TOOL_OK)
     {
@@ -162,19 +219,26 @@ PlusStatus vtkPlus3DObjectVisualizer::Update()
         resetCameraNeeded = true;
       }
 
-      // Assemble and set transform for visualization
-      vtkSmartPointer<vtkTransform> objectModelToWorldTransform = vtkSmartPointer<vtkTransform>::New();
-      objectModelToWorldTransform->Identity();
-      objectModelToWorldTransform->Concatenate(objectCoordinateFrameToWorldTransformMatrix);
-
-      vtkDisplayableModel* displayableModel = dynamic_cast<vtkDisplayableModel*>(displayableObject);
-      if (displayableModel)
+      // Assemble and set transform for visualization. The model to object transform is concatenated by reference,
+      // so its changes are followed without reassembling.
+      vtkTransform* objectModelToWorldTransform = cacheEntry.ObjectModelToWorldTransform;
+      if (transformChanged)
       {
-        objectModelToWorldTransform->Concatenate(displayableModel->GetModelToObjectTransform());
+        objectModelToWorldTransform->Identity();
+        objectModelToWorldTransform->Concatenate(cacheEntry.ObjectToWorldMatrix);
+
+        vtkDisplayableModel* displayableModel = dynamic_cast<vtkDisplayableModel*>(displayableObject);
+        if (displayableModel)
+        {
+          objectModelToWorldTransform->Concatenate(displayableModel->GetModelToObjectTransform());
+        }
+        objectModelToWorldTransform->Modified();
       }
-      objectModelToWorldTransform->Modified();
 
-      displayableObject->GetActor()->SetUserTransform(objectModelToWorldTransform);
+      if (displayableObject->GetActor()->GetUserTransform() != objectModelToWorldTransform)
+      {
+        displayableObject->GetActor()->SetUserTransform(objectModelToWorldTransform);
+      }
     }
     // If invalid then make it partially transparent and leave in place
     else
@@ -195,6 +259,37 @@ PlusStatus vtkPlus3DObjectVisualizer::Update()
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlus3DObjectVisualizer::UpdateObjectTransformCache()
+{
+  // Paths found in a different repository or to a different world frame are not valid anymore
+  bool resetAll = (this->ObjectTransformCacheRepository != this->TransformRepository || this->ObjectTransformCacheWorldCoordinateFrame != this->WorldCoordinateFrame);
+  this->ObjectTransformCacheRepository = this->TransformRepository;
+  this->ObjectTransformCacheWorldCoordinateFrame = this->WorldCoordinateFrame;
+
+  this->ObjectTransformCache.resize(this->DisplayableObjects.size());
+  for (unsigned int i = 0; i < this->DisplayableObjects.size(); ++i)
+  {
+    ObjectTransformCacheEntry& cacheEntry = this->ObjectTransformCache[i];
+    vtkPlusDisplayableObject* displayableObject = this->DisplayableObjects[i];
+    if (!resetAll && cacheEntry.Object == displayableObject && cacheEntry.ObjectCoordinateFrame == displayableObject->GetObjectCoordinateFrame())
+    {
+      continue;
+    }
+
+    cacheEntry.Object = displayableObject;
+    cacheEntry.ObjectCoordinateFrame = displayableObject->GetObjectCoordinateFrame();
+    cacheEntry.ObjectToWorldTransformName = igsioTransformName(cacheEntry.ObjectCoordinateFrame, this->WorldCoordinateFrame);
+    cacheEntry.TransformExists = false;
+    cacheEntry.LastObjectToWorldMatrixValid = false;
+    if (cacheEntry.ObjectToWorldMatrix == NULL)
+    {
+      cacheEntry.ObjectToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      cacheEntry.ObjectModelToWorldTransform = vtkSmartPointer<vtkTransform>::New();
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 void vtkPlus3DObjectVisualizer::SetCanvasRenderer(vtkSmartPointer<vtkRenderer> renderer)
 {
@@ -213,6 +308,28 @@ vtkImageActor* vtkPlus3DObjectVisualizer::GetImageActor() const
   return this->ImageActor;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlus3DObjectVisualizer::SetImageData(vtkImageData* aImage)
+{
+  this->SliceCache->SetInputData(aImage);
+  if (aImage == NULL)
+  {
+    // Nothing to show
+    this->ImageActor->SetInputData(NULL);
+  }
+  else if (this->ImageMapper->GetInputAlgorithm() != this->SliceCache.GetPointer())
+  {
+    // The mapper gets only the displayed slice, so changing the slice of a volume only uploads the new slice
+    this->ImageMapper->SetInputConnection(this->SliceCache->GetOutputPort());
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkPlus3DObjectVisualizer::GetImageData() const
+{
+  return vtkImageData::SafeDownCast(this->SliceCache->GetInputDataObject(0, 0));
+}
+
 //----------------------------------------------------------------------------
 void vtkPlus3DObjectVisualizer::SetImageActor(vtkSmartPointer<vtkImageActor> imageActor)
 {
@@ -232,25 +349,25 @@ void vtkPlus3DObjectVisualizer::SetResultActor(vtkSmartPointer<vtkActor> resultA
 }
 
 //----------------------------------------------------------------------------
-void vtkPlus3DObjectVisualizer::SetResultGlyph(vtkSmartPointer<vtkGlyph3D> glyph)
+void vtkPlus3DObjectVisualizer::SetResultGlyph(vtkSmartPointer<vtkGlyph3DMapper> glyph)
 {
   this->ResultGlyph = glyph;
 }
 
 //----------------------------------------------------------------------------
-vtkSmartPointer<vtkGlyph3D> vtkPlus3DObjectVisualizer::GetResultGlyph() const
+vtkSmartPointer<vtkGlyph3DMapper> vtkPlus3DObjectVisualizer::GetResultGlyph() const
 {
   return this->ResultGlyph;
 }
 
 //----------------------------------------------------------------------------
-void vtkPlus3DObjectVisualizer::SetInputGlyph(vtkSmartPointer<vtkGlyph3D> glyph)
+void vtkPlus3DObjectVisualizer::SetInputGlyph(vtkSmartPointer<vtkGlyph3DMapper> glyph)
 {
   this->InputGlyph = glyph;
 }
 
 //----------------------------------------------------------------------------
-vtkSmartPointer<vtkGlyph3D> vtkPlus3DObjectVisualizer::GetInputGlyph() const
+vtkSmartPointer<vtkGlyph3DMapper> vtkPlus3DObjectVisualizer::GetInputGlyph() const
 {
   return this->InputGlyph;
 }
@@ -276,6 +393,7 @@ PlusStatus vtkPlus3DObjectVisualizer::ClearDisplayableObjects()
   }
 
   this->DisplayableObjects.clear();
+  this->ObjectTransformCache.clear();
 
   return PLUS_SUCCESS;
 }
@@ -368,7 +486,7 @@ PlusStatus vtkPlus3DObjectVisualizer::SetChannel(vtkPlusChannel* channel)
     if (this->SelectedChannel->GetVideoDataAvailable())
     {
       this->ImageActor->VisibilityOn();
-      this->ImageActor->SetInputData(this->SelectedChannel->GetBrightnessOutput());
+      this->SetImageData(this->SelectedChannel->GetBrightnessOutput());
     }
     else
     {
@@ -402,6 +520,9 @@ PlusStatus vtkPlus3DObjectVisualizer::ReadConfiguration(vtkXMLDataElement* aXMLE
 
   this->SetWorldCoordinateFrame(worldCoordinateFrame);
 
+  // Load the models in parallel, the displayable models below copy the loaded geometry
+  this->PreloadModelFiles(renderingElement);
+
   // Read displayable tool configurations
   bool imageFound = false;
   for (int i = 0; i < renderingElement->GetNumberOfNestedElements(); ++i)
@@ -440,6 +561,7 @@ PlusStatus vtkPlus3DObjectVisualizer::ReadConfiguration(vtkXMLDataElement* aXMLE
 
     this->DisplayableObjects.push_back(displayableObject);
   }
+  vtkDisplayableModel::ClearPreloadedModelFiles();
 
   if (this->DisplayableObjects.size() == 0)
   {
@@ -485,6 +607,51 @@ PlusStatus vtkPlus3DObjectVisualizer::ReadConfiguration(vtkXMLDataElement* aXMLE
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlus3DObjectVisualizer::PreloadModelFiles(vtkXMLDataElement* aRenderingElement)
+{
+  LOG_TRACE("vtkPlus3DObjectVisualizer::PreloadModelFiles");
+
+  std::set<std::string> modelFilePaths;
+  QAtomicInt numberOfLoadedModels(0);
+  QThreadPool threadPool;
+  for (int i = 0; i < aRenderingElement->GetNumberOfNestedElements(); ++i)
+  {
+    vtkXMLDataElement* displayableObjectElement = aRenderingElement->GetNestedElement(i);
+    const char* type = displayableObjectElement->GetAttribute("Type");
+    if (STRCASECMP(displayableObjectElement->GetName(), "DisplayableObject") != 0 || type == NULL || STRCASECMP(type, "Model") != 0)
+    {
+      continue;
+    }
+
+    std::string modelFilePath;
+    int numberOfLevelsOfDetail(0);
+    if (vtkDisplayableModel::ReadModelFileConfiguration(displayableObjectElement, modelFilePath, numberOfLevelsOfDetail) != PLUS_SUCCESS
+        || !modelFilePaths.insert(modelFilePath).second)
+    {
+      // Missing files are reported when the object is configured, a model used by multiple objects is loaded once
+      continue;
+    }
+    threadPool.start(new ModelFileLoader(modelFilePath, numberOfLevelsOfDetail, &numberOfLoadedModels));
+  }
+
+  if (modelFilePaths.empty())
+  {
+    return;
+  }
+
+  double progress(0.0);
+  while (!threadPool.waitForDone(MODEL_LOADING_PROGRESS_INTERVAL_MSEC))
+  {
+    progress = static_cast<double>(numberOfLoadedModels.load()) / modelFilePaths.size();
+    this->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+  }
+  progress = 1.0;
+  this->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+
+  LOG_DEBUG(modelFilePaths.size() << " model files loaded");
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlus3DObjectVisualizer::ShowObjectById(const std::string& aModelId, bool aOn)
 {
@@ -621,10 +788,19 @@ vtkActor* vtkPlus3DObjectVisualizer::GetVolumeActor()
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlus3DObjectVisualizer::SetSliceNumber(int number)
 {
-  if (number >= this->ImageMapper->GetSliceNumberMinValue() && number <= this->ImageMapper->GetSliceNumberMaxValue())
+  int range[2] = {0, 0};
+  if (this->SliceCache->GetSliceNumberRange(range) == PLUS_SUCCESS && number >= range[0] && number <= range[1])
   {
+    this->SliceCache->SetSliceNumber(number);
+    // The mapper shows the only slice of its input, but the slice number keeps it consistent with the slice extent
     this->ImageMapper->SetSliceNumber(number);
     return PLUS_SUCCESS;
   }
   return PLUS_FAIL;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlus3DObjectVisualizer::PrefetchSlices()
+{
+  return this->SliceCache->Prefetch();
 }
\ No newline at end of file
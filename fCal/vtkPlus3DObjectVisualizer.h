@@ -18,7 +18,7 @@
 // VTK includes
 #include <vtkActor.h>
 #include <vtkCamera.h>
-#include <vtkGlyph3D.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkImageActor.h>
 #include <vtkObject.h>
 #include <vtkPolyData.h>
@@ -27,7 +27,11 @@
 
 //-----------------------------------------------------------------------------
 
+class vtkImageData;
 class vtkImageSliceMapper;
+class vtkMatrix4x4;
+class vtkPlusImageSliceCache;
+class vtkTransform;
 
 /*! \class vtkPlus3DObjectVisualizer
  * \brief Class that manages the displaying of a 3D object visualization in a QT canvas element
@@ -74,6 +78,12 @@ public:
   */
   PlusStatus SetSliceNumber(int number);
 
+  /*!
+  * Extract some of the slices next to the displayed one if the image is a volume, so that they can be shown without delay
+  * \return Number of slices extracted
+  */
+  int PrefetchSlices();
+
   /*!
   * Set the volume actor color
   * \param r red value
@@ -113,7 +123,8 @@ public:
   PlusStatus HideAll();
 
   /*!
-  * Read the active configuration file to create displayable objects
+  * Read the active configuration file to create displayable objects. The model files are loaded in parallel first,
+  * vtkCommand::ProgressEvent is invoked periodically meanwhile with the ratio of loaded models (double) as call data.
   */
   PlusStatus ReadConfiguration(vtkXMLDataElement* aXMLElement);
 
@@ -125,6 +136,11 @@ public:
   // Set/Get for member variables
   vtkRenderer* GetCanvasRenderer() const;
   vtkImageActor* GetImageActor() const;
+
+  /*! Set the image shown by the image actor, NULL to show none */
+  void SetImageData(vtkImageData* aImage);
+  /*! Get the image shown by the image actor */
+  vtkImageData* GetImageData() const;
   vtkSetObjectMacro(TransformRepository, vtkIGSIOTransformRepository);
 
   vtkSetMacro(WorldCoordinateFrame, std::string);
@@ -143,16 +159,58 @@ protected:
   void SetInputActor(vtkSmartPointer<vtkActor> inputActor);
   void SetResultActor(vtkSmartPointer<vtkActor> resultActor);
 
-  void SetResultGlyph(vtkSmartPointer<vtkGlyph3D> glyph);
-  vtkSmartPointer<vtkGlyph3D> GetResultGlyph() const;
+  void SetResultGlyph(vtkSmartPointer<vtkGlyph3DMapper> glyph);
+  vtkSmartPointer<vtkGlyph3DMapper> GetResultGlyph() const;
 
-  void SetInputGlyph(vtkSmartPointer<vtkGlyph3D> glyph);
-  vtkSmartPointer<vtkGlyph3D> GetInputGlyph() const;
+  void SetInputGlyph(vtkSmartPointer<vtkGlyph3DMapper> glyph);
+  vtkSmartPointer<vtkGlyph3DMapper> GetInputGlyph() const;
 
   vtkSetMacro(VolumeID, std::string);
   vtkSetObjectMacro(SelectedChannel, vtkPlusChannel);
 
+  /*! Make sure there is a valid transform cache entry for every displayable object */
+  void UpdateObjectTransformCache();
+
+  /*!
+  * Load the model files of all the displayable models in a rendering element on a thread pool
+  * \param aRenderingElement Rendering element containing the DisplayableObject elements
+  */
+  void PreloadModelFiles(vtkXMLDataElement* aRenderingElement);
+
 protected:
+  /*! Object to world transform of a displayable object, kept between updates so that nothing is allocated per frame */
+  struct ObjectTransformCacheEntry
+  {
+    ObjectTransformCacheEntry()
+      : Object(NULL)
+      , TransformExists(false)
+      , LastObjectToWorldMatrixValid(false)
+      , LastStatus(TOOL_INVALID)
+    {
+    }
+    /*! Displayable object this entry belongs to */
+    vtkPlusDisplayableObject*     Object;
+    /*! Object coordinate frame that the transform name was created for */
+    std::string                   ObjectCoordinateFrame;
+    igsioTransformName            ObjectToWorldTransformName;
+    /*! True if the transform has been found in the repository. A path does not disappear from the repository, so it is only searched until found. */
+    bool                          TransformExists;
+    vtkSmartPointer<vtkMatrix4x4> ObjectToWorldMatrix;
+    /*! User transform of the actor, updated in place */
+    vtkSmartPointer<vtkTransform> ObjectModelToWorldTransform;
+    /*! Object to world matrix and status that the user transform was last computed from */
+    double                        LastObjectToWorldMatrix[16];
+    bool                          LastObjectToWorldMatrixValid;
+    ToolStatus                    LastStatus;
+  };
+
+  /*! Transform cache entries, in the same order as DisplayableObjects */
+  std::vector<ObjectTransformCacheEntry> ObjectTransformCache;
+
+  /*! World coordinate frame and repository that the transform cache was built for */
+  std::string                   ObjectTransformCacheWorldCoordinateFrame;
+  vtkIGSIOTransformRepository*  ObjectTransformCacheRepository;
+
   /*! List of displayable objects */
   std::vector<vtkPlusDisplayableObject*> DisplayableObjects;
 
@@ -168,14 +226,17 @@ protected:
   /*! Slice mapper to enable slice selection */
   vtkSmartPointer<vtkImageSliceMapper> ImageMapper;
 
-  /*! Glyph producer for result */
-  vtkSmartPointer<vtkGlyph3D> InputGlyph;
+  /*! Passes the displayed slice of the image to the slice mapper and caches the slices around it */
+  vtkSmartPointer<vtkPlusImageSliceCache> SliceCache;
+
+  /*! Glyph mapper for input points, draws one instance of the sphere per point instead of copying the sphere geometry */
+  vtkSmartPointer<vtkGlyph3DMapper> InputGlyph;
 
   /*! Actor for displaying the result points (eg. stylus tip, segmented points) */
   vtkSmartPointer<vtkActor> ResultActor;
 
-  /*! Glyph producer for result */
-  vtkSmartPointer<vtkGlyph3D> ResultGlyph;
+  /*! Glyph mapper for result points, draws one instance of the sphere per point instead of copying the sphere geometry */
+  vtkSmartPointer<vtkGlyph3DMapper> ResultGlyph;
 
   /*! Name of the rendering world coordinate frame */
   std::string WorldCoordinateFrame;
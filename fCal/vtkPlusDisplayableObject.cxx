@@ -10,22 +10,126 @@ See License.txt for details.
 // VTK includes
 #include <vtkActor.h>
 #include <vtkImageActor.h>
+#include <vtkLODActor.h>
 #include <vtkPlusToolAxesActor.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
+#include <vtkQuadricDecimation.h>
 #include <vtkSTLReader.h>
 #include <vtkCylinderSource.h>
 #include <vtkConeSource.h>
 #include <vtkAppendPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkPointData.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkXMLPolyDataReader.h>
+#include <vtkXMLPolyDataWriter.h>
 #include <vtkXMLUtilities.h>
 #include <vtkObjectFactory.h>
 #include <vtkPolyData.h>
+#include <vtksys/SystemTools.hxx>
+
+// Qt includes
+#include <QCryptographicHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+// STL includes
+#include <map>
+#include <sstream>
+#include <vector>
 
 //-----------------------------------------------------------------------------
 
 vtkCxxSetObjectMacro(vtkPlusDisplayableObject, Actor, vtkProp3D);
 
+namespace
+{
+  /*! Models with less triangles than this are rendered at full resolution only */
+  const vtkIdType MINIMUM_NUMBER_OF_TRIANGLES_FOR_LOD = 20000;
+  /*! Ratio of the triangles removed from each level of detail compared to the previous one */
+  const double LOD_TARGET_REDUCTION = 0.75;
+  const int DEFAULT_NUMBER_OF_LEVELS_OF_DETAIL = 2;
+  /*! Subdirectory of the output directory where the parsed models and their levels of detail are cached */
+  const char* MODEL_CACHE_DIRECTORY_NAME = "ModelCache";
+
+  //----------------------------------------------------------------------------
+  // Models loaded by vtkDisplayableModel::PreloadModelFile, until vtkDisplayableModel::ClearPreloadedModelFiles is called
+  struct PreloadedModelFile
+  {
+    PreloadedModelFile()
+      : NumberOfLevelsOfDetail(0)
+    {
+    }
+    vtkSmartPointer<vtkPolyData>                Model;
+    std::vector<vtkSmartPointer<vtkPolyData> >  LevelsOfDetail;
+    int                                         NumberOfLevelsOfDetail;
+  };
+  QMutex PreloadedModelFilesMutex;
+  std::map<std::string, PreloadedModelFile> PreloadedModelFiles;
+
+  //----------------------------------------------------------------------------
+  // Read a cached model geometry. Returns NULL if the cache file does not exist, it is older than the model file or it cannot be read.
+  vtkSmartPointer<vtkPolyData> ReadModelCacheFile(const std::string& aModelFilePath, const std::string& aCacheFilePath)
+  {
+    int modelFileAge(0);
+    if (!vtksys::SystemTools::FileExists(aCacheFilePath.c_str(), true)
+        || !vtksys::SystemTools::FileTimeCompare(aModelFilePath, aCacheFilePath, &modelFileAge) || modelFileAge >= 0)
+    {
+      return NULL;
+    }
+
+    vtkSmartPointer<vtkXMLPolyDataReader> cacheReader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    cacheReader->SetFileName(aCacheFilePath.c_str());
+    cacheReader->Update();
+    if (cacheReader->GetErrorCode() != 0 || cacheReader->GetOutput()->GetNumberOfPolys() == 0)
+    {
+      LOG_WARNING("Unable to read model cache file " << aCacheFilePath << ", the model is processed again");
+      return NULL;
+    }
+
+    return cacheReader->GetOutput();
+  }
+
+  //----------------------------------------------------------------------------
+  // Write a model geometry to the cache. Returns false if the cache file cannot be written.
+  bool WriteModelCacheFile(vtkPolyData* aPolyData, const std::string& aCacheFilePath)
+  {
+    vtksys::SystemTools::MakeDirectory(vtksys::SystemTools::GetFilenamePath(aCacheFilePath));
+
+    vtkSmartPointer<vtkXMLPolyDataWriter> cacheWriter = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+    cacheWriter->SetFileName(aCacheFilePath.c_str());
+    cacheWriter->SetInputData(aPolyData);
+    cacheWriter->SetDataModeToBinary();
+    if (cacheWriter->Write() == 0)
+    {
+      LOG_WARNING("Unable to write model cache file " << aCacheFilePath);
+      return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Append cells to a cell array, shifting the point ids by the number of points that preceded the appended points
+  void AppendCells(vtkCellArray* aCells, vtkCellArray* aNewCells, vtkIdType aPointIdOffset)
+  {
+    std::vector<vtkIdType> shiftedPointIds;
+    vtkIdType numberOfPoints(0);
+    vtkIdType* pointIds(NULL);
+    for (aNewCells->InitTraversal(); aNewCells->GetNextCell(numberOfPoints, pointIds);)
+    {
+      shiftedPointIds.resize(numberOfPoints);
+      for (vtkIdType i = 0; i < numberOfPoints; ++i)
+      {
+        shiftedPointIds[i] = pointIds[i] + aPointIdOffset;
+      }
+      aCells->InsertNextCell(numberOfPoints, shiftedPointIds.empty() ? NULL : &shiftedPointIds[0]);
+    }
+    aCells->Modified();
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkPlusDisplayableObject* vtkPlusDisplayableObject::New(const char* aType)
 {
@@ -234,9 +338,11 @@ vtkStandardNewMacro(vtkDisplayablePolyData);
 vtkDisplayablePolyData::vtkDisplayablePolyData()
   : vtkPlusDisplayableObject()
   , PolyData(NULL)
+  , PolyDataAppendable(false)
 {
   vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
   this->SetPolyData(polyData);
+  this->PolyDataAppendable = true;
 }
 
 //-----------------------------------------------------------------------------
@@ -255,6 +361,7 @@ void vtkDisplayablePolyData::SetPolyData(vtkPolyData* aPolyData)
 
   vtkPolyData* tempPolyData = this->PolyData;
   this->PolyData = aPolyData;
+  this->PolyDataAppendable = false;
   if (this->PolyData != NULL)
   {
     this->PolyData->Register(this);
@@ -364,11 +471,108 @@ PlusStatus vtkDisplayablePolyData::AppendPolyData(vtkPolyData* aPolyData)
 {
   LOG_TRACE("vtkDisplayablePolyData::AppendPolyData");
 
-  vtkSmartPointer<vtkAppendPolyData> appendFilter = vtkSmartPointer<vtkAppendPolyData>::New();
-  appendFilter->AddInputData(this->PolyData);
-  appendFilter->AddInputData(aPolyData);
-  appendFilter->Update();
-  SetPolyData(appendFilter->GetOutput());
+  if (aPolyData == NULL)
+  {
+    LOG_ERROR("Unable to append invalid poly data!");
+    return PLUS_FAIL;
+  }
+
+  // Cell attributes are ordered by cell type in a poly data, so appending them would need reordering. This is not used
+  // for displayable objects, let the append filter handle it.
+  if ((this->PolyData != NULL && this->PolyData->GetCellData()->GetNumberOfArrays() > 0) || aPolyData->GetCellData()->GetNumberOfArrays() > 0)
+  {
+    vtkSmartPointer<vtkAppendPolyData> appendFilter = vtkSmartPointer<vtkAppendPolyData>::New();
+    if (this->PolyData != NULL)
+    {
+      appendFilter->AddInputData(this->PolyData);
+    }
+    appendFilter->AddInputData(aPolyData);
+    appendFilter->Update();
+    SetPolyData(appendFilter->GetOutput());
+    return PLUS_SUCCESS;
+  }
+
+  // Poly data that has been set from outside may be used elsewhere, so it is copied once before appending in place
+  if (this->PolyData == NULL || !this->PolyDataAppendable)
+  {
+    vtkSmartPointer<vtkPolyData> appendablePolyData = vtkSmartPointer<vtkPolyData>::New();
+    if (this->PolyData != NULL)
+    {
+      appendablePolyData->DeepCopy(this->PolyData);
+    }
+    this->SetPolyData(appendablePolyData);
+    this->PolyDataAppendable = true;
+  }
+
+  vtkPolyData* polyData = this->PolyData;
+  if (polyData->GetNumberOfPoints() == 0)
+  {
+    polyData->DeepCopy(aPolyData);
+    polyData->Modified();
+    return PLUS_SUCCESS;
+  }
+
+  // Points and point attributes. Only the arrays that both poly data have are kept, as in vtkAppendPolyData.
+  vtkIdType pointIdOffset = polyData->GetNumberOfPoints();
+  vtkIdType numberOfNewPoints = aPolyData->GetNumberOfPoints();
+  vtkPointData* pointData = polyData->GetPointData();
+  vtkPointData* newPointData = aPolyData->GetPointData();
+  for (int arrayIndex = pointData->GetNumberOfArrays() - 1; arrayIndex >= 0; --arrayIndex)
+  {
+    vtkAbstractArray* array = pointData->GetAbstractArray(arrayIndex);
+    vtkAbstractArray* newArray = (array->GetName() != NULL ? newPointData->GetAbstractArray(array->GetName()) : NULL);
+    if (newArray == NULL || newArray->GetDataType() != array->GetDataType() || newArray->GetNumberOfComponents() != array->GetNumberOfComponents())
+    {
+      pointData->RemoveArray(arrayIndex);
+      continue;
+    }
+    array->InsertTuples(pointIdOffset, numberOfNewPoints, 0, newArray);
+  }
+
+  vtkPoints* points = polyData->GetPoints();
+  for (vtkIdType pointId = 0; pointId < numberOfNewPoints; ++pointId)
+  {
+    points->InsertNextPoint(aPolyData->GetPoint(pointId));
+  }
+  points->Modified();
+
+  // Cells. The cell arrays of an empty poly data may be a shared placeholder, so new ones are created for them.
+  if (aPolyData->GetNumberOfVerts() > 0)
+  {
+    if (polyData->GetNumberOfVerts() == 0)
+    {
+      polyData->SetVerts(vtkSmartPointer<vtkCellArray>::New());
+    }
+    AppendCells(polyData->GetVerts(), aPolyData->GetVerts(), pointIdOffset);
+  }
+  if (aPolyData->GetNumberOfLines() > 0)
+  {
+    if (polyData->GetNumberOfLines() == 0)
+    {
+      polyData->SetLines(vtkSmartPointer<vtkCellArray>::New());
+    }
+    AppendCells(polyData->GetLines(), aPolyData->GetLines(), pointIdOffset);
+  }
+  if (aPolyData->GetNumberOfPolys() > 0)
+  {
+    if (polyData->GetNumberOfPolys() == 0)
+    {
+      polyData->SetPolys(vtkSmartPointer<vtkCellArray>::New());
+    }
+    AppendCells(polyData->GetPolys(), aPolyData->GetPolys(), pointIdOffset);
+  }
+  if (aPolyData->GetNumberOfStrips() > 0)
+  {
+    if (polyData->GetNumberOfStrips() == 0)
+    {
+      polyData->SetStrips(vtkSmartPointer<vtkCellArray>::New());
+    }
+    AppendCells(polyData->GetStrips(), aPolyData->GetStrips(), pointIdOffset);
+  }
+
+  // The random access cell structure is rebuilt on demand, the mapper does not need it
+  polyData->DeleteCells();
+  polyData->Modified();
 
   return PLUS_SUCCESS;
 }
@@ -382,6 +586,7 @@ vtkDisplayableModel::vtkDisplayableModel()
   : vtkDisplayablePolyData()
   , STLModelFileName(NULL)
   , ModelToObjectTransform(NULL)
+  , NumberOfLevelsOfDetail(DEFAULT_NUMBER_OF_LEVELS_OF_DETAIL)
 {
   vtkSmartPointer<vtkTransform> ModelToObjectTransform = vtkSmartPointer<vtkTransform>::New();
   ModelToObjectTransform->Identity();
@@ -451,23 +656,42 @@ PlusStatus vtkDisplayableModel::ReadConfiguration(vtkXMLDataElement* aConfig)
 
   // Find absolute path for the file
   std::string modelFileFullPath;
-  if (modelFileName != NULL && vtkPlusConfig::GetInstance()->FindModelPath(modelFileName, modelFileFullPath) == PLUS_SUCCESS)
+  int numberOfLevelsOfDetail(DEFAULT_NUMBER_OF_LEVELS_OF_DETAIL);
+  if (ReadModelFileConfiguration(aConfig, modelFileFullPath, numberOfLevelsOfDetail) == PLUS_SUCCESS)
   {
     this->SetSTLModelFileName(modelFileFullPath.c_str());
   }
+  this->SetNumberOfLevelsOfDetail(numberOfLevelsOfDetail);
 
   vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+  vtkSmartPointer<vtkActor> actor;
 
-  if (this->STLModelFileName != NULL)
+  vtkSmartPointer<vtkPolyData> model;
+  std::vector<vtkSmartPointer<vtkPolyData> > levelsOfDetail;
+  if (this->STLModelFileName != NULL && ReadModelFile(this->STLModelFileName, this->NumberOfLevelsOfDetail, model, levelsOfDetail) == PLUS_SUCCESS)
   {
-    vtkSmartPointer<vtkSTLReader> stlReader = vtkSmartPointer<vtkSTLReader>::New();
-    stlReader->SetFileName(this->STLModelFileName);
-    stlReader->Update();
-    SetPolyData(stlReader->GetOutput());
+    SetPolyData(model);
     mapper->SetInputData(this->PolyData);
+
+    // The LOD actor renders the highest resolution that fits in the render time allocated to it. It is only used if
+    // there are levels of detail, otherwise it would show its own point cloud and bounding box levels.
+    if (!levelsOfDetail.empty())
+    {
+      vtkSmartPointer<vtkLODActor> lodActor = vtkSmartPointer<vtkLODActor>::New();
+      for (std::vector<vtkSmartPointer<vtkPolyData> >::iterator levelIt = levelsOfDetail.begin(); levelIt != levelsOfDetail.end(); ++levelIt)
+      {
+        vtkSmartPointer<vtkPolyDataMapper> lodMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+        lodMapper->SetInputData(*levelIt);
+        lodActor->AddLODMapper(lodMapper);
+      }
+      actor = lodActor;
+    }
   }
 
-  vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
+  if (actor == NULL)
+  {
+    actor = vtkSmartPointer<vtkActor>::New();
+  }
   actor->SetMapper(mapper);
   this->SetActor(actor);
   this->SetOpacity(this->LastOpacity);
@@ -483,6 +707,129 @@ PlusStatus vtkDisplayableModel::ReadConfiguration(vtkXMLDataElement* aConfig)
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+PlusStatus vtkDisplayableModel::ReadModelFileConfiguration(vtkXMLDataElement* aConfig, std::string& aModelFilePath, int& aNumberOfLevelsOfDetail)
+{
+  aNumberOfLevelsOfDetail = DEFAULT_NUMBER_OF_LEVELS_OF_DETAIL;
+  aConfig->GetScalarAttribute("NumberOfLevelsOfDetail", aNumberOfLevelsOfDetail);
+
+  const char* modelFileName = aConfig->GetAttribute("File");
+  if (modelFileName == NULL || STRCASECMP(modelFileName, "") == 0)
+  {
+    return PLUS_FAIL;
+  }
+  return vtkPlusConfig::GetInstance()->FindModelPath(modelFileName, aModelFilePath);
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkDisplayableModel::GetModelCacheFilePath(const std::string& aModelFilePath, int aLevel)
+{
+  // The hash of the full path keeps models with the same name in different directories apart
+  std::ostringstream cacheFileName;
+  cacheFileName << vtksys::SystemTools::GetFilenameWithoutLastExtension(aModelFilePath) << "_"
+                << QCryptographicHash::hash(QByteArray::fromStdString(vtksys::SystemTools::CollapseFullPath(aModelFilePath)), QCryptographicHash::Sha256).toHex().toStdString()
+                << ".LOD" << aLevel << ".vtp";
+  return vtksys::SystemTools::CollapseFullPath(cacheFileName.str(), vtkPlusConfig::GetInstance()->GetOutputPath(MODEL_CACHE_DIRECTORY_NAME));
+}
+
+//-----------------------------------------------------------------------------
+void vtkDisplayableModel::PreloadModelFile(const std::string& aModelFilePath, int aNumberOfLevelsOfDetail)
+{
+  PreloadedModelFile preloadedModelFile;
+  preloadedModelFile.NumberOfLevelsOfDetail = aNumberOfLevelsOfDetail;
+  if (ReadModelFile(aModelFilePath, aNumberOfLevelsOfDetail, preloadedModelFile.Model, preloadedModelFile.LevelsOfDetail) != PLUS_SUCCESS)
+  {
+    return;
+  }
+
+  QMutexLocker preloadedModelFilesLock(&PreloadedModelFilesMutex);
+  PreloadedModelFiles[aModelFilePath] = preloadedModelFile;
+}
+
+//-----------------------------------------------------------------------------
+void vtkDisplayableModel::ClearPreloadedModelFiles()
+{
+  QMutexLocker preloadedModelFilesLock(&PreloadedModelFilesMutex);
+  PreloadedModelFiles.clear();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkDisplayableModel::ReadModelFile(const std::string& aModelFilePath, int aNumberOfLevelsOfDetail, vtkSmartPointer<vtkPolyData>& aModel, std::vector<vtkSmartPointer<vtkPolyData> >& aLevelsOfDetail)
+{
+  LOG_TRACE("vtkDisplayableModel::ReadModelFile(" << aModelFilePath << ")");
+
+  aLevelsOfDetail.clear();
+
+  // Copy the model if it has already been loaded by PreloadModelFile. The same model file may be used by several
+  // displayable objects, so the preloaded model is kept and each object gets its own copy.
+  {
+    QMutexLocker preloadedModelFilesLock(&PreloadedModelFilesMutex);
+    std::map<std::string, PreloadedModelFile>::iterator preloadedIt = PreloadedModelFiles.find(aModelFilePath);
+    if (preloadedIt != PreloadedModelFiles.end() && preloadedIt->second.NumberOfLevelsOfDetail == aNumberOfLevelsOfDetail)
+    {
+      aModel = vtkSmartPointer<vtkPolyData>::New();
+      aModel->DeepCopy(preloadedIt->second.Model);
+      for (std::vector<vtkSmartPointer<vtkPolyData> >::iterator levelIt = preloadedIt->second.LevelsOfDetail.begin(); levelIt != preloadedIt->second.LevelsOfDetail.end(); ++levelIt)
+      {
+        vtkSmartPointer<vtkPolyData> levelOfDetail = vtkSmartPointer<vtkPolyData>::New();
+        levelOfDetail->DeepCopy(*levelIt);
+        aLevelsOfDetail.push_back(levelOfDetail);
+      }
+      return PLUS_SUCCESS;
+    }
+  }
+
+  // Parsing an STL file (especially a text one) and merging its points is much slower than reading the cached geometry
+  bool cacheWritable(true);
+  std::string modelCacheFilePath = GetModelCacheFilePath(aModelFilePath, 0);
+  aModel = ReadModelCacheFile(aModelFilePath, modelCacheFilePath);
+  if (aModel == NULL)
+  {
+    vtkSmartPointer<vtkSTLReader> stlReader = vtkSmartPointer<vtkSTLReader>::New();
+    stlReader->SetFileName(aModelFilePath.c_str());
+    stlReader->Update();
+    if (stlReader->GetErrorCode() != 0)
+    {
+      LOG_ERROR("Unable to read model file: " << aModelFilePath);
+      return PLUS_FAIL;
+    }
+    aModel = stlReader->GetOutput();
+    cacheWritable = WriteModelCacheFile(aModel, modelCacheFilePath);
+  }
+
+  if (aNumberOfLevelsOfDetail <= 0 || aModel->GetNumberOfPolys() < MINIMUM_NUMBER_OF_TRIANGLES_FOR_LOD)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  vtkSmartPointer<vtkPolyData> previousLevel = aModel;
+  for (int level = 1; level <= aNumberOfLevelsOfDetail; ++level)
+  {
+    std::string cacheFilePath = GetModelCacheFilePath(aModelFilePath, level);
+    vtkSmartPointer<vtkPolyData> levelOfDetail = ReadModelCacheFile(aModelFilePath, cacheFilePath);
+    if (levelOfDetail == NULL)
+    {
+      LOG_INFO("Generating level of detail " << level << " for model " << aModelFilePath);
+      vtkSmartPointer<vtkQuadricDecimation> decimation = vtkSmartPointer<vtkQuadricDecimation>::New();
+      decimation->SetInputData(previousLevel);
+      decimation->SetTargetReduction(LOD_TARGET_REDUCTION);
+      decimation->Update();
+      levelOfDetail = decimation->GetOutput();
+
+      // Do not try again if the cache directory cannot be written, the levels are generated at every load then
+      if (cacheWritable)
+      {
+        cacheWritable = WriteModelCacheFile(levelOfDetail, cacheFilePath);
+      }
+    }
+
+    aLevelsOfDetail.push_back(levelOfDetail);
+    previousLevel = levelOfDetail;
+  }
+
+  return PLUS_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkDisplayableModel::SetDefaultStylusModel()
 {
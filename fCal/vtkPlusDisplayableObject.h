@@ -12,8 +12,12 @@
 
 // VTK includes
 #include <vtkObject.h>
+#include <vtkSmartPointer.h>
 #include <vtkTransform.h>
 
+// STL includes
+#include <vector>
+
 class vtkProp3D;
 class vtkMapper;
 class vtkPolyData;
@@ -168,7 +172,10 @@ public:
   /* Set poly data mapper */
   virtual void SetPolyDataMapper(vtkPolyDataMapper* aPolyDataMapper);
 
-  /*! Appends a polydata to the already existing one */
+  /*!
+  * Appends a polydata to the already existing one. Points and cells are inserted in place into growable arrays,
+  * so the cost of an append is proportional to the size of the appended data, not to the size of the existing data.
+  */
   PlusStatus AppendPolyData(vtkPolyData* aPolyData);
 
 public:
@@ -184,6 +191,9 @@ protected:
 protected:
   /*! Displayed poly data */
   vtkPolyData* PolyData;
+
+  /*! True if PolyData is owned by this object and can be appended to in place. Poly data set from outside is copied at the first append. */
+  bool PolyDataAppendable;
 };
 
 //-----------------------------------------------------------------------------
@@ -213,6 +223,41 @@ public:
   /*! Get model to tool transform */
   vtkGetObjectMacro(ModelToObjectTransform, vtkTransform);
 
+  /*! Set the number of decimated levels of detail generated for the model (0 disables level of detail rendering) */
+  vtkSetMacro(NumberOfLevelsOfDetail, int);
+  /*! Get the number of decimated levels of detail generated for the model */
+  vtkGetMacro(NumberOfLevelsOfDetail, int);
+
+  /*!
+  * Get the model file and the number of levels of detail from a DisplayableObject element, without reading the model
+  * \param aConfig DisplayableObject element of a model
+  * \param aModelFilePath Output full path of the STL file
+  * \param aNumberOfLevelsOfDetail Output number of levels of detail
+  * \return PLUS_FAIL if no model file is defined or it cannot be found
+  */
+  static PlusStatus ReadModelFileConfiguration(vtkXMLDataElement* aConfig, std::string& aModelFilePath, int& aNumberOfLevelsOfDetail);
+
+  /*!
+  * Read an STL model and its decimated levels of detail. The parsed model and the levels are cached in the ModelCache
+  * subdirectory of the output directory, later loads read them from the cache as long as it is newer than the model.
+  * Small models (less than 20000 triangles) get no levels of detail. If the model has been loaded by PreloadModelFile
+  * then a copy of that result is returned.
+  * \param aModelFilePath Full path of the STL file
+  * \param aNumberOfLevelsOfDetail Number of decimated levels to generate, each one has about a quarter of the triangles of the previous one
+  * \param aModel Output full resolution model
+  * \param aLevelsOfDetail Output decimated models, from the highest to the lowest resolution
+  */
+  static PlusStatus ReadModelFile(const std::string& aModelFilePath, int aNumberOfLevelsOfDetail, vtkSmartPointer<vtkPolyData>& aModel, std::vector<vtkSmartPointer<vtkPolyData> >& aLevelsOfDetail);
+
+  /*!
+  * Read a model file and keep the result until ClearPreloadedModelFiles is called. Can be called from any thread, so that
+  * multiple models can be loaded in parallel before the displayable objects are configured.
+  */
+  static void PreloadModelFile(const std::string& aModelFilePath, int aNumberOfLevelsOfDetail);
+
+  /*! Release the preloaded models */
+  static void ClearPreloadedModelFiles();
+
 protected:
   /*! Set model to tool transform */
   vtkSetObjectMacro(ModelToObjectTransform, vtkTransform);
@@ -220,6 +265,9 @@ protected:
   /*! Assemble and set default stylus model for stylus tool actor */
   PlusStatus SetDefaultStylusModel();
 
+  /*! Get the path of the cache file of a level of detail of a model. Level 0 is the full resolution model. */
+  static std::string GetModelCacheFilePath(const std::string& aModelFilePath, int aLevel);
+
 protected:
   vtkDisplayableModel();
   virtual ~vtkDisplayableModel();
@@ -230,6 +278,9 @@ protected:
 
   /* Model to tool transform */
   vtkTransform*       ModelToObjectTransform;
+
+  /*! Number of decimated levels of detail generated for the model */
+  int                 NumberOfLevelsOfDetail;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,227 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "vtkPlusImageOverlaySource.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
+#include <vtkUnsignedCharArray.h>
+
+// STL includes
+#include <cmath>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Add the color of a cell
+  void InsertNextCellColor(vtkUnsignedCharArray* aColors, const double aColor[3], double aOpacity)
+  {
+    unsigned char color[4] =
+    {
+      static_cast<unsigned char>(aColor[0] * 255.0 + 0.5),
+      static_cast<unsigned char>(aColor[1] * 255.0 + 0.5),
+      static_cast<unsigned char>(aColor[2] * 255.0 + 0.5),
+      static_cast<unsigned char>(aOpacity * 255.0 + 0.5)
+    };
+    aColors->InsertNextTypedTuple(color);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+vtkStandardNewMacro(vtkPlusImageOverlaySource);
+
+const char* vtkPlusImageOverlaySource::LABELS_ARRAY_NAME = "Labels";
+
+//-----------------------------------------------------------------------------
+vtkPlusImageOverlaySource::vtkPlusImageOverlaySource()
+  : Depth(-1.0)
+  , ShowResultPoints(true)
+  , ResultPointOpacity(1.0)
+  , ShowRegionOfInterest(false)
+  , ShowLineSegmentation(false)
+  , LineSegmentationWidth(4.0)
+  , ShowLabels(false)
+{
+  this->SetNumberOfInputPorts(1);
+  this->SetNumberOfOutputPorts(2);
+
+  for (int i = 0; i < 3; ++i)
+  {
+    this->ResultPointColor[i] = 1.0;
+    this->RegionOfInterestColor[i] = 1.0;
+    this->LineSegmentationColor[i] = 1.0;
+  }
+  for (int i = 0; i < 4; ++i)
+  {
+    this->RegionOfInterest[i] = 0.0;
+    this->LineSegmentationPoints[i] = 0.0;
+  }
+}
+
+//-----------------------------------------------------------------------------
+vtkPlusImageOverlaySource::~vtkPlusImageOverlaySource()
+{
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusImageOverlaySource::SetResultPolyData(vtkPolyData* aResultPolyData)
+{
+  this->SetInputData(0, aResultPolyData);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusImageOverlaySource::SetLabelTexts(const std::vector<std::string>& aLabelTexts)
+{
+  this->LabelTexts = aLabelTexts;
+  this->LabelPositions.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageOverlaySource::GetNumberOfLabels() const
+{
+  return static_cast<int>(this->LabelTexts.size());
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusImageOverlaySource::SetLabelPositions(vtkPoints* aLabelPositions, double aOffset)
+{
+  if (aLabelPositions == NULL || aLabelPositions->GetNumberOfPoints() != this->GetNumberOfLabels())
+  {
+    LOG_ERROR("Number of label positions does not match the number of labels.");
+    return PLUS_FAIL;
+  }
+
+  this->LabelPositions.resize(2 * this->LabelTexts.size());
+  for (vtkIdType i = 0; i < aLabelPositions->GetNumberOfPoints(); ++i)
+  {
+    double* position = aLabelPositions->GetPoint(i);
+    this->LabelPositions[2 * i] = position[0] + aOffset;
+    this->LabelPositions[2 * i + 1] = position[1] + aOffset;
+  }
+  this->Modified();
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageOverlaySource::FillInputPortInformation(int vtkNotUsed(port), vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkPolyData");
+  info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageOverlaySource::RequestData(vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  vtkPolyData* resultPolyData = vtkPolyData::GetData(inputVector[0], 0);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector, 0);
+  vtkPolyData* labelOutput = vtkPolyData::GetData(outputVector, 1);
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> verts = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkUnsignedCharArray> colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  colors->SetNumberOfComponents(4);
+  colors->SetName("Colors");
+
+  // Cell data of a poly data is ordered as vertices, lines, polygons, so the cells are generated in this order
+
+  // Result points
+  if (this->ShowResultPoints && resultPolyData != NULL && resultPolyData->GetPoints() != NULL)
+  {
+    vtkPoints* resultPoints = resultPolyData->GetPoints();
+    for (vtkIdType i = 0; i < resultPoints->GetNumberOfPoints(); ++i)
+    {
+      double* resultPoint = resultPoints->GetPoint(i);
+      vtkIdType pointId = points->InsertNextPoint(resultPoint[0], resultPoint[1], this->Depth);
+      verts->InsertNextCell(1, &pointId);
+      InsertNextCellColor(colors, this->ResultPointColor, this->ResultPointOpacity);
+    }
+  }
+
+  // Region of interest rectangle
+  if (this->ShowRegionOfInterest)
+  {
+    vtkIdType cornerIds[5] =
+    {
+      points->InsertNextPoint(this->RegionOfInterest[0], this->RegionOfInterest[2], this->Depth),
+      points->InsertNextPoint(this->RegionOfInterest[1], this->RegionOfInterest[2], this->Depth),
+      points->InsertNextPoint(this->RegionOfInterest[1], this->RegionOfInterest[3], this->Depth),
+      points->InsertNextPoint(this->RegionOfInterest[0], this->RegionOfInterest[3], this->Depth),
+      0
+    };
+    cornerIds[4] = cornerIds[0];
+    lines->InsertNextCell(5, cornerIds);
+    InsertNextCellColor(colors, this->RegionOfInterestColor, 1.0);
+  }
+
+  // Line segmentation result, as a rectangle around the line so that its thickness scales with the image
+  if (this->ShowLineSegmentation)
+  {
+    double direction[2] = {this->LineSegmentationPoints[2] - this->LineSegmentationPoints[0], this->LineSegmentationPoints[3] - this->LineSegmentationPoints[1]};
+    double length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1]);
+    if (length > 0.0)
+    {
+      double halfWidthNormal[2] = { -direction[1] / length * this->LineSegmentationWidth / 2.0, direction[0] / length * this->LineSegmentationWidth / 2.0 };
+      vtkIdType cornerIds[4] =
+      {
+        points->InsertNextPoint(this->LineSegmentationPoints[0] + halfWidthNormal[0], this->LineSegmentationPoints[1] + halfWidthNormal[1], this->Depth),
+        points->InsertNextPoint(this->LineSegmentationPoints[2] + halfWidthNormal[0], this->LineSegmentationPoints[3] + halfWidthNormal[1], this->Depth),
+        points->InsertNextPoint(this->LineSegmentationPoints[2] - halfWidthNormal[0], this->LineSegmentationPoints[3] - halfWidthNormal[1], this->Depth),
+        points->InsertNextPoint(this->LineSegmentationPoints[0] - halfWidthNormal[0], this->LineSegmentationPoints[1] - halfWidthNormal[1], this->Depth)
+      };
+      polys->InsertNextCell(4, cornerIds);
+      InsertNextCellColor(colors, this->LineSegmentationColor, 1.0);
+    }
+  }
+
+  output->SetPoints(points);
+  output->SetVerts(verts);
+  output->SetLines(lines);
+  output->SetPolys(polys);
+  output->GetCellData()->SetScalars(colors);
+
+  this->GenerateLabels(labelOutput);
+
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusImageOverlaySource::GenerateLabels(vtkPolyData* aOutput)
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> verts = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkStringArray> labels = vtkSmartPointer<vtkStringArray>::New();
+  labels->SetName(LABELS_ARRAY_NAME);
+
+  if (this->ShowLabels && this->LabelPositions.size() == 2 * this->LabelTexts.size())
+  {
+    for (size_t i = 0; i < this->LabelTexts.size(); ++i)
+    {
+      vtkIdType pointId = points->InsertNextPoint(this->LabelPositions[2 * i], this->LabelPositions[2 * i + 1], this->Depth);
+      verts->InsertNextCell(1, &pointId);
+      labels->InsertNextValue(this->LabelTexts[i]);
+    }
+  }
+
+  aOutput->SetPoints(points);
+  aOutput->SetVerts(verts);
+  aOutput->GetPointData()->AddArray(labels);
+}
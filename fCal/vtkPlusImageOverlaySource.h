@@ -0,0 +1,129 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusImageOverlaySource_h
+#define __vtkPlusImageOverlaySource_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// VTK includes
+#include <vtkPolyDataAlgorithm.h>
+
+// STL includes
+#include <string>
+#include <vector>
+
+class vtkPoints;
+
+//-----------------------------------------------------------------------------
+
+/*! \class vtkPlusImageOverlaySource
+* \brief Generates the 2D overlay of the image view (segmentation results, region of interest, line segmentation and wire labels)
+*
+* All the overlay items are in image coordinates and are generated in one pass into one poly data, so they can be drawn
+* by a single actor. The colors are stored as cell scalars (RGBA unsigned char). Output port 0 contains the geometry:
+*   - result points as vertices (from the points of the optional input poly data)
+*   - region of interest rectangle as lines
+*   - line segmentation result as a polygon (a thick line)
+* Output port 1 contains the label positions as vertices and the label texts in the "Labels" point data array, to be drawn
+* by a single vtkLabeledDataMapper.
+*
+* Changing a parameter only marks the source modified, the overlay is regenerated at the next render.
+* \ingroup PlusAppCommonWidgets
+*/
+class vtkPlusImageOverlaySource : public vtkPolyDataAlgorithm
+{
+public:
+  vtkTypeMacro(vtkPlusImageOverlaySource, vtkPolyDataAlgorithm);
+  static vtkPlusImageOverlaySource* New();
+
+  /*! Name of the label text array in the label output */
+  static const char* LABELS_ARRAY_NAME;
+
+  /*! Set the depth (Z coordinate) of the overlay, it has to be between the image and the camera */
+  vtkSetMacro(Depth, double);
+  vtkGetMacro(Depth, double);
+
+  /*! Show/hide the result points (the points of the input poly data) */
+  vtkSetMacro(ShowResultPoints, bool);
+  vtkGetMacro(ShowResultPoints, bool);
+  vtkSetVector3Macro(ResultPointColor, double);
+  vtkGetVector3Macro(ResultPointColor, double);
+  vtkSetMacro(ResultPointOpacity, double);
+  vtkGetMacro(ResultPointOpacity, double);
+
+  /*! Show/hide the region of interest rectangle */
+  vtkSetMacro(ShowRegionOfInterest, bool);
+  vtkGetMacro(ShowRegionOfInterest, bool);
+  /*! Set the region of interest as xMin, xMax, yMin, yMax */
+  vtkSetVector4Macro(RegionOfInterest, double);
+  vtkGetVector4Macro(RegionOfInterest, double);
+  vtkSetVector3Macro(RegionOfInterestColor, double);
+  vtkGetVector3Macro(RegionOfInterestColor, double);
+
+  /*! Show/hide the line segmentation result */
+  vtkSetMacro(ShowLineSegmentation, bool);
+  vtkGetMacro(ShowLineSegmentation, bool);
+  /*! Set the line segmentation result as start x, start y, end x, end y */
+  vtkSetVector4Macro(LineSegmentationPoints, double);
+  vtkGetVector4Macro(LineSegmentationPoints, double);
+  vtkSetVector3Macro(LineSegmentationColor, double);
+  vtkGetVector3Macro(LineSegmentationColor, double);
+  /*! Set the thickness of the line segmentation result, in image pixels */
+  vtkSetMacro(LineSegmentationWidth, double);
+  vtkGetMacro(LineSegmentationWidth, double);
+
+  /*! Show/hide the labels */
+  vtkSetMacro(ShowLabels, bool);
+  vtkGetMacro(ShowLabels, bool);
+  /*! Set the label texts. Removes the label positions. */
+  void SetLabelTexts(const std::vector<std::string>& aLabelTexts);
+  /*! Get the number of labels */
+  int GetNumberOfLabels() const;
+  /*!
+  * Set the positions of all the labels
+  * \param aLabelPositions Position of each label in image coordinates, the number of points must be the same as the number of labels
+  * \param aOffset Offset added to each label position, in image pixels
+  */
+  PlusStatus SetLabelPositions(vtkPoints* aLabelPositions, double aOffset);
+
+  /*! Set the poly data whose points are shown as result points */
+  void SetResultPolyData(vtkPolyData* aResultPolyData);
+
+protected:
+  vtkPlusImageOverlaySource();
+  virtual ~vtkPlusImageOverlaySource();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info);
+  virtual int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector);
+
+  /*! Generate the label output */
+  void GenerateLabels(vtkPolyData* aOutput);
+
+protected:
+  double  Depth;
+
+  bool    ShowResultPoints;
+  double  ResultPointColor[3];
+  double  ResultPointOpacity;
+
+  bool    ShowRegionOfInterest;
+  double  RegionOfInterest[4];
+  double  RegionOfInterestColor[3];
+
+  bool    ShowLineSegmentation;
+  double  LineSegmentationPoints[4];
+  double  LineSegmentationColor[3];
+  double  LineSegmentationWidth;
+
+  bool                      ShowLabels;
+  std::vector<std::string>  LabelTexts;
+  /*! Label positions as x, y pairs, empty if the positions are not known */
+  std::vector<double>       LabelPositions;
+};
+
+#endif
@@ -0,0 +1,266 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "vtkPlusImageSliceCache.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STL includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+
+vtkStandardNewMacro(vtkPlusImageSliceCache);
+
+//-----------------------------------------------------------------------------
+vtkPlusImageSliceCache::vtkPlusImageSliceCache()
+  : SliceNumber(0)
+  , PrefetchRadius(8)
+  , MaxNumberOfSlicesPerPrefetch(4)
+  , OutputSliceNumber(0)
+  , ScrollDirection(1)
+  , CachedInputMTime(0)
+  , PrefetchInputMTime(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+vtkPlusImageSliceCache::~vtkPlusImageSliceCache()
+{
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusImageSliceCache::GetSliceNumberRange(int aRange[2])
+{
+  vtkImageData* input = vtkImageData::SafeDownCast(this->GetInputDataObject(0, 0));
+  if (input == NULL)
+  {
+    aRange[0] = 0;
+    aRange[1] = 0;
+    return PLUS_FAIL;
+  }
+
+  int* extent = input->GetExtent();
+  aRange[0] = extent[4];
+  aRange[1] = extent[5];
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageSliceCache::Prefetch()
+{
+  vtkImageData* input = this->GetInputVolume();
+  if (input == NULL)
+  {
+    return 0;
+  }
+
+  // A live volume is modified with every frame, the prefetched slices would be thrown away before they are shown.
+  // Only prefetch once the input has not changed since the previous call.
+  if (input->GetMTime() != this->PrefetchInputMTime)
+  {
+    this->PrefetchInputMTime = input->GetMTime();
+    return 0;
+  }
+  this->ValidateCache(input);
+
+  int numberOfExtractedSlices(0);
+  for (int side = 0; side < 2; ++side)
+  {
+    // Ahead in the scrolling direction first, then behind
+    int direction = (side == 0 ? this->ScrollDirection : -this->ScrollDirection);
+    for (int distance = 1; distance <= this->PrefetchRadius; ++distance)
+    {
+      if (numberOfExtractedSlices >= this->MaxNumberOfSlicesPerPrefetch)
+      {
+        return numberOfExtractedSlices;
+      }
+      int sliceNumber = this->OutputSliceNumber + direction * distance;
+      if (sliceNumber < input->GetExtent()[4] || sliceNumber > input->GetExtent()[5])
+      {
+        break;
+      }
+      if (this->Slices.find(sliceNumber) == this->Slices.end() && this->GetSlice(input, sliceNumber) != NULL)
+      {
+        ++numberOfExtractedSlices;
+      }
+    }
+  }
+
+  return numberOfExtractedSlices;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusImageSliceCache::ClearCache()
+{
+  this->Slices.clear();
+  this->CachedInput = NULL;
+  this->CachedInputMTime = 0;
+  this->PrefetchInputMTime = 0;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageSliceCache::FillInputPortInformation(int vtkNotUsed(port), vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageSliceCache::RequestInformation(vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+
+  int wholeExtent[6] = {0, -1, 0, -1, 0, -1};
+  if (inInfo != NULL)
+  {
+    inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+    int sliceNumber = std::min(std::max(this->SliceNumber, wholeExtent[4]), wholeExtent[5]);
+    wholeExtent[4] = sliceNumber;
+    wholeExtent[5] = sliceNumber;
+  }
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent, 6);
+
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageSliceCache::RequestUpdateExtent(vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector, vtkInformationVector* vtkNotUsed(outputVector))
+{
+  // The neighboring slices are extracted from the same input, so the whole volume is needed
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  if (inInfo != NULL)
+  {
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()), 6);
+  }
+
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageSliceCache::RequestData(vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0], 0);
+  vtkImageData* output = vtkImageData::GetData(outputVector, 0);
+
+  if (input == NULL || input->GetPointData()->GetScalars() == NULL)
+  {
+    this->ClearCache();
+    output->Initialize();
+    return 1;
+  }
+
+  int* extent = input->GetExtent();
+  if (extent[4] >= extent[5])
+  {
+    // Only one slice, nothing to extract
+    this->ClearCache();
+    output->ShallowCopy(input);
+    return 1;
+  }
+
+  this->ValidateCache(input);
+
+  int sliceNumber = std::min(std::max(this->SliceNumber, extent[4]), extent[5]);
+  if (sliceNumber != this->OutputSliceNumber)
+  {
+    this->ScrollDirection = (sliceNumber > this->OutputSliceNumber ? 1 : -1);
+    this->OutputSliceNumber = sliceNumber;
+  }
+
+  vtkImageData* slice = this->GetSlice(input, sliceNumber);
+  if (slice == NULL)
+  {
+    output->Initialize();
+    return 1;
+  }
+  output->ShallowCopy(slice);
+
+  this->RemoveDistantSlices();
+
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+vtkImageData* vtkPlusImageSliceCache::GetInputVolume()
+{
+  vtkImageData* input = vtkImageData::SafeDownCast(this->GetInputDataObject(0, 0));
+  if (input == NULL || input->GetPointData()->GetScalars() == NULL || input->GetExtent()[4] >= input->GetExtent()[5])
+  {
+    return NULL;
+  }
+  return input;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusImageSliceCache::ValidateCache(vtkImageData* aInput)
+{
+  if (this->CachedInput.GetPointer() != aInput || this->CachedInputMTime != aInput->GetMTime())
+  {
+    this->Slices.clear();
+    this->CachedInput = aInput;
+    this->CachedInputMTime = aInput->GetMTime();
+  }
+}
+
+//-----------------------------------------------------------------------------
+vtkImageData* vtkPlusImageSliceCache::GetSlice(vtkImageData* aInput, int aSliceNumber)
+{
+  std::map<int, vtkSmartPointer<vtkImageData> >::iterator sliceIt = this->Slices.find(aSliceNumber);
+  if (sliceIt != this->Slices.end())
+  {
+    return sliceIt->second;
+  }
+
+  int* extent = aInput->GetExtent();
+  if (aSliceNumber < extent[4] || aSliceNumber > extent[5])
+  {
+    return NULL;
+  }
+
+  // The slices are contiguous in memory, so a slice is extracted by a single copy
+  vtkSmartPointer<vtkImageData> slice = vtkSmartPointer<vtkImageData>::New();
+  slice->SetExtent(extent[0], extent[1], extent[2], extent[3], aSliceNumber, aSliceNumber);
+  slice->SetOrigin(aInput->GetOrigin());
+  slice->SetSpacing(aInput->GetSpacing());
+  slice->AllocateScalars(aInput->GetScalarType(), aInput->GetNumberOfScalarComponents());
+  slice->GetPointData()->GetScalars()->SetName(aInput->GetPointData()->GetScalars()->GetName());
+  size_t sliceSizeBytes = static_cast<size_t>(extent[1] - extent[0] + 1) * static_cast<size_t>(extent[3] - extent[2] + 1)
+                          * aInput->GetNumberOfScalarComponents() * aInput->GetScalarSize();
+  memcpy(slice->GetScalarPointer(), aInput->GetScalarPointer(extent[0], extent[2], aSliceNumber), sliceSizeBytes);
+
+  this->Slices[aSliceNumber] = slice;
+  return slice;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusImageSliceCache::RemoveDistantSlices()
+{
+  std::map<int, vtkSmartPointer<vtkImageData> >::iterator sliceIt = this->Slices.begin();
+  while (sliceIt != this->Slices.end())
+  {
+    if (abs(sliceIt->first - this->OutputSliceNumber) > this->PrefetchRadius)
+    {
+      this->Slices.erase(sliceIt++);
+    }
+    else
+    {
+      ++sliceIt;
+    }
+  }
+}
@@ -0,0 +1,112 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusImageSliceCache_h
+#define __vtkPlusImageSliceCache_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// VTK includes
+#include <vtkImageAlgorithm.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+// STL includes
+#include <map>
+
+class vtkImageData;
+
+//-----------------------------------------------------------------------------
+
+/*! \class vtkPlusImageSliceCache
+* \brief Outputs one slice of a volume and keeps the slices around it extracted, for smooth scrolling through the slices
+*
+* The output is the slice at SliceNumber along the third image axis, with the same origin and spacing as the input and
+* an extent of one slice, so it is displayed at the same position as the mapper would display the slice of the volume.
+* As the mapper only receives one slice, changing the slice only uploads the texture of the new slice.
+*
+* The extracted slices are kept in a cache until the input is modified. Prefetch() extracts the slices around the
+* current one, the ones ahead in the scrolling direction first, so it can be called when the application is idle
+* (e.g., after rendering) and scrolling then only needs to pass a cached slice to the mapper. It does nothing while the
+* input keeps changing between calls (e.g., a live volume). Slices farther than PrefetchRadius from the current slice
+* are removed from the cache.
+*
+* If the input has only one slice, it is passed to the output without copying.
+* \ingroup PlusAppFCal
+*/
+class vtkPlusImageSliceCache : public vtkImageAlgorithm
+{
+public:
+  vtkTypeMacro(vtkPlusImageSliceCache, vtkImageAlgorithm);
+  static vtkPlusImageSliceCache* New();
+
+  /*! Set the index of the slice to output (along the third image axis). Clamped to the extent of the input. */
+  vtkSetMacro(SliceNumber, int);
+  vtkGetMacro(SliceNumber, int);
+
+  /*! Set the number of slices kept in the cache on each side of the current slice */
+  vtkSetMacro(PrefetchRadius, int);
+  vtkGetMacro(PrefetchRadius, int);
+
+  /*! Set the maximum number of slices extracted by one Prefetch() call, to limit the time it takes */
+  vtkSetMacro(MaxNumberOfSlicesPerPrefetch, int);
+  vtkGetMacro(MaxNumberOfSlicesPerPrefetch, int);
+
+  /*! Get the range of the slice numbers of the input. Returns PLUS_FAIL if there is no input. */
+  PlusStatus GetSliceNumberRange(int aRange[2]);
+
+  /*!
+  * Extract the slices around the current slice that are not cached yet, the ones ahead in the scrolling direction first.
+  * Nothing is extracted if the input has been modified since the previous call. Does not modify the output.
+  * \return Number of slices extracted
+  */
+  int Prefetch();
+
+  /*! Remove all the slices from the cache */
+  void ClearCache();
+
+protected:
+  vtkPlusImageSliceCache();
+  virtual ~vtkPlusImageSliceCache();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info);
+  virtual int RequestInformation(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector);
+  virtual int RequestUpdateExtent(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector);
+  virtual int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector);
+
+  /*! Get the input if it is a volume with more than one slice, NULL otherwise */
+  vtkImageData* GetInputVolume();
+
+  /*! Clear the cache if the slices were extracted from another input or the input has been modified since */
+  void ValidateCache(vtkImageData* aInput);
+
+  /*! Get a slice from the cache, extract it from the input first if it is not cached. Returns NULL if the slice is out of range. */
+  vtkImageData* GetSlice(vtkImageData* aInput, int aSliceNumber);
+
+  /*! Remove the slices that are farther than PrefetchRadius from the current slice */
+  void RemoveDistantSlices();
+
+protected:
+  int SliceNumber;
+  int PrefetchRadius;
+  int MaxNumberOfSlicesPerPrefetch;
+
+  /*! Slice number of the last output */
+  int OutputSliceNumber;
+  /*! Direction of the last slice change, +1 or -1 */
+  int ScrollDirection;
+
+  /*! Extracted slices by slice number */
+  std::map<int, vtkSmartPointer<vtkImageData> > Slices;
+  /*! Input the slices were extracted from and its modification time at that point */
+  vtkWeakPointer<vtkImageData>  CachedInput;
+  vtkMTimeType                  CachedInputMTime;
+  /*! Modification time of the input at the previous Prefetch() call */
+  vtkMTimeType                  PrefetchInputMTime;
+};
+
+#endif
@@ -5,6 +5,8 @@ See License.txt for details.
 =========================================================Plus=header=end*/
 
 // Local includes
+#include "vtkPlusImageOverlaySource.h"
+#include "vtkPlusImageSliceCache.h"
 #include "vtkPlusImageVisualizer.h"
 
 // PlusLib includes
@@ -14,13 +16,13 @@ See License.txt for details.
 // VTK includes
 #include <vtkConeSource.h>
 #include <vtkImageSliceMapper.h>
+#include <vtkLabeledDataMapper.h>
 #include <vtkLineSource.h>
-#include <vtkProp3DCollection.h>
+#include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
 #include <vtkRenderWindow.h>
-#include <vtkSphereSource.h>
 #include <vtkTextProperty.h>
 
 //-----------------------------------------------------------------------------
@@ -29,6 +31,9 @@ vtkStandardNewMacro(vtkPlusImageVisualizer);
 
 double vtkPlusImageVisualizer::ROI_COLOR[3] = {1.0, 0.0, 0.5};
 static double RESULT_SPHERE_COLOR[3] = {0.0, 0.8, 0.0};
+static double LINE_SEGMENTATION_COLOR[3] = {0.0, 1.0, 0.0};
+static const double RESULT_POINT_SIZE = 6.0;  // in screen pixels
+static const double WIRE_LABEL_OFFSET = -10.0;  // in image pixels
 static const double MAX_WIDGET_THICKNESS = 10.0;  // maximum thickness of any object in the scene (camera is positioned at -MAX_WIDGET_THICKNESS - 1
 static double HORIZONTAL_TEXT_ORIENTATION_MARKER_OFFSET[3] = {30.0, 17.0, -1.0};
 static double VERTICAL_TEXT_ORIENTATION_MARKER_OFFSET[3] = {4.0, 40.0, -1.0};
@@ -42,24 +47,17 @@ static const double ORIENTATION_MARKER_CONE_HEIGHT = 15.0;
 vtkPlusImageVisualizer::vtkPlusImageVisualizer()
   : CanvasRenderer(vtkSmartPointer<vtkRenderer>::New())
   , ImageActor(vtkSmartPointer<vtkImageActor>::New())
-  , ResultActor(vtkSmartPointer<vtkActor>::New())
-  , ResultGlyph(vtkSmartPointer<vtkGlyph3D>::New())
+  , SliceCache(vtkSmartPointer<vtkPlusImageSliceCache>::New())
+  , OverlaySource(vtkSmartPointer<vtkPlusImageOverlaySource>::New())
+  , OverlayActor(vtkSmartPointer<vtkActor>::New())
+  , LabelActor(vtkSmartPointer<vtkActor2D>::New())
   , ImageCamera(vtkSmartPointer<vtkCamera>::New())
   , OrientationMarkerAssembly(vtkSmartPointer<vtkAssembly>::New())
   , HorizontalOrientationTextActor(vtkSmartPointer<vtkTextActor3D>::New())
   , VerticalOrientationTextActor(vtkSmartPointer<vtkTextActor3D>::New())
-  , ScreenAlignedCurrentXRotation(0.0)
-  , ScreenAlignedCurrentYRotation(0.0)
   , CurrentMarkerOrientation(US_IMG_ORIENT_MF)
-  , ScreenAlignedProps(vtkSmartPointer<vtkProp3DCollection>::New())
-  , ROIActorAssembly(vtkSmartPointer<vtkAssembly>::New())
-  , LeftLineSource(vtkSmartPointer<vtkLineSource>::New())
-  , TopLineSource(vtkSmartPointer<vtkLineSource>::New())
-  , RightLineSource(vtkSmartPointer<vtkLineSource>::New())
-  , BottomLineSource(vtkSmartPointer<vtkLineSource>::New())
+  , ScreenAlignedTransformMatrix(vtkSmartPointer<vtkMatrix4x4>::New())
   , SelectedChannel(NULL)
-  , LineSegmentationLineSource(vtkSmartPointer<vtkLineSource>::New())
-  , LineSegmentationActor(vtkSmartPointer<vtkActor>::New())
 {
   this->RegionOfInterest[0] = -1;
   this->RegionOfInterest[1] = -1;
@@ -73,27 +71,14 @@ vtkPlusImageVisualizer::vtkPlusImageVisualizer()
   // Set camera
   this->CanvasRenderer->SetActiveCamera(this->ImageCamera);
 
-  // Create Glyph and Actor
-  vtkSmartPointer<vtkPolyDataMapper> resultMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  vtkSmartPointer<vtkSphereSource> resultSphereSource = vtkSmartPointer<vtkSphereSource>::New();
-  resultSphereSource->SetRadius(3.0);   // mm
-
-  this->ResultGlyph->SetSourceConnection(resultSphereSource->GetOutputPort());
-  resultMapper->SetInputConnection(this->ResultGlyph->GetOutputPort());
-  this->ResultActor->SetMapper(resultMapper);
-  this->ResultActor->GetProperty()->SetColor(RESULT_SPHERE_COLOR);
-
   this->ImageMapper = vtkImageSliceMapper::SafeDownCast(this->ImageActor->GetMapper());
 
   // Add actors to the renderer
-  this->CanvasRenderer->AddActor(this->ResultActor);
   this->CanvasRenderer->AddActor(this->ImageActor);
 
   this->InitializeOrientationMarkers();
 
-  this->InitializeROIVisualization();
-
-  this->InitializeLineSegmentationMarkers();
+  this->InitializeOverlay();
 }
 
 //-----------------------------------------------------------------------------
@@ -185,59 +170,57 @@ void vtkPlusImageVisualizer::InitializeOrientationMarkers()
   this->AddScreenAlignedProp(this->OrientationMarkerAssembly);
 }
 
-//----------------------------------------------------------------------------
-void vtkPlusImageVisualizer::InitializeLineSegmentationMarkers()
-{
-  LOG_TRACE("vtkPlusImageVisualizer::InitializeLineSegmentationMarkers");
-
-  this->LineSegmentationLineSource->SetPoint1(0.0, 0.0, 0.0);
-  this->LineSegmentationLineSource->SetPoint2(0.0, 0.0, 0.0);
-  this->LineSegmentationLineSource->Update();
-
-  // Visualize
-  vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  mapper->SetInputConnection(this->LineSegmentationLineSource->GetOutputPort());
-  this->LineSegmentationActor->SetMapper(mapper);
-  this->LineSegmentationActor->GetProperty()->SetColor(0.f, 1.f, 0.f);
-  this->LineSegmentationActor->GetProperty()->SetLineWidth(4);
-  this->SetLineSegmentationVisible(false);
-  this->AddScreenAlignedProp(this->LineSegmentationActor);
+//-----------------------------------------------------------------------------
+void vtkPlusImageVisualizer::InitializeOverlay()
+{
+  LOG_TRACE("vtkPlusImageVisualizer::InitializeOverlay");
+
+  this->OverlaySource->SetResultPointColor(RESULT_SPHERE_COLOR);
+  this->OverlaySource->SetRegionOfInterestColor(ROI_COLOR);
+  this->OverlaySource->SetShowRegionOfInterest(false);
+  this->OverlaySource->SetLineSegmentationColor(LINE_SEGMENTATION_COLOR);
+  this->OverlaySource->SetShowLineSegmentation(false);
+  this->OverlaySource->SetShowLabels(false);
+
+  // Result points, ROI and line segmentation are drawn by one actor, colored by the cell scalars of the overlay
+  vtkSmartPointer<vtkPolyDataMapper> overlayMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+  overlayMapper->SetInputConnection(this->OverlaySource->GetOutputPort(0));
+  overlayMapper->SetScalarModeToUseCellData();
+  overlayMapper->SetColorModeToDirectScalars();
+  this->OverlayActor->SetMapper(overlayMapper);
+  this->OverlayActor->GetProperty()->LightingOff();
+  this->OverlayActor->GetProperty()->SetPointSize(RESULT_POINT_SIZE);
+  this->CanvasRenderer->AddActor(this->OverlayActor);
+
+  // Wire labels are drawn in screen space, so they are readable in any orientation
+  vtkSmartPointer<vtkLabeledDataMapper> labelMapper = vtkSmartPointer<vtkLabeledDataMapper>::New();
+  labelMapper->SetInputConnection(this->OverlaySource->GetOutputPort(1));
+  labelMapper->SetLabelModeToLabelFieldData();
+  labelMapper->SetFieldDataName(vtkPlusImageOverlaySource::LABELS_ARRAY_NAME);
+  vtkTextProperty* labelTextProperty = labelMapper->GetLabelTextProperty();
+  labelTextProperty->SetColor(RESULT_SPHERE_COLOR);
+  labelTextProperty->SetFontFamilyToArial();
+  labelTextProperty->SetFontSize(16);
+  labelTextProperty->SetJustificationToLeft();
+  labelTextProperty->SetVerticalJustificationToTop();
+  labelTextProperty->BoldOn();
+  labelTextProperty->ShadowOff();
+  this->LabelActor->SetMapper(labelMapper);
+  this->CanvasRenderer->AddActor2D(this->LabelActor);
+
+  this->UpdateOverlayDepth();
 }
 
 //-----------------------------------------------------------------------------
-void vtkPlusImageVisualizer::InitializeROIVisualization()
+void vtkPlusImageVisualizer::UpdateOverlayDepth()
 {
-  LOG_TRACE("vtkPlusImageVisualizer::InitializeROIVisualization");
-
-  vtkSmartPointer<vtkActor> leftLineActor = vtkSmartPointer<vtkActor>::New();
-  vtkSmartPointer<vtkPolyDataMapper> leftLineMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  leftLineActor->GetProperty()->SetColor(ROI_COLOR);
-  leftLineMapper->SetInputConnection(this->LeftLineSource->GetOutputPort());
-  leftLineActor->SetMapper(leftLineMapper);
-  this->ROIActorAssembly->AddPart(leftLineActor);
-
-  vtkSmartPointer<vtkActor> topLineActor = vtkSmartPointer<vtkActor>::New();
-  vtkSmartPointer<vtkPolyDataMapper> topLineMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  topLineActor->GetProperty()->SetColor(ROI_COLOR);
-  topLineMapper->SetInputConnection(this->TopLineSource->GetOutputPort());
-  topLineActor->SetMapper(topLineMapper);
-  this->ROIActorAssembly->AddPart(topLineActor);
-
-  vtkSmartPointer<vtkActor> rightLineActor = vtkSmartPointer<vtkActor>::New();
-  vtkSmartPointer<vtkPolyDataMapper> rightLineMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  rightLineActor->GetProperty()->SetColor(ROI_COLOR);
-  rightLineMapper->SetInputConnection(this->RightLineSource->GetOutputPort());
-  rightLineActor->SetMapper(rightLineMapper);
-  this->ROIActorAssembly->AddPart(rightLineActor);
-
-  vtkSmartPointer<vtkActor> bottomLineActor = vtkSmartPointer<vtkActor>::New();
-  vtkSmartPointer<vtkPolyDataMapper> bottomLineMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  bottomLineActor->GetProperty()->SetColor(ROI_COLOR);
-  bottomLineMapper->SetInputConnection(this->BottomLineSource->GetOutputPort());
-  bottomLineActor->SetMapper(bottomLineMapper);
-  this->ROIActorAssembly->AddPart(bottomLineActor);
-
-  this->CanvasRenderer->AddActor(this->ROIActorAssembly);
+  // The camera is on the -z side of the image plane, except for MN and UF orientations
+  double depth = -1.0;
+  if (this->CurrentMarkerOrientation == US_IMG_ORIENT_MN || this->CurrentMarkerOrientation == US_IMG_ORIENT_UF)
+  {
+    depth = 1.0;
+  }
+  this->OverlaySource->SetDepth(depth);
 }
 
 //-----------------------------------------------------------------------------
@@ -387,7 +370,7 @@ PlusStatus vtkPlusImageVisualizer::UpdateCameraPose()
     return PLUS_FAIL;
   }
 
-  this->SetROIBounds(this->RegionOfInterest[0], this->RegionOfInterest[1], this->RegionOfInterest[2], this->RegionOfInterest[3]);
+  this->UpdateOverlayDepth();
 
   return UpdateOrientationMarkerLabelling();
 }
@@ -430,7 +413,7 @@ PlusStatus vtkPlusImageVisualizer::ShowOrientationMarkers(bool aShow)
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusImageVisualizer::HideAll()
 {
-  this->ResultActor->VisibilityOff();
+  this->OverlaySource->SetShowResultPoints(false);
   this->ImageActor->VisibilityOff();
 
   this->CanvasRenderer->Modified();
@@ -441,7 +424,7 @@ PlusStatus vtkPlusImageVisualizer::HideAll()
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusImageVisualizer::ShowResult(bool aOn)
 {
-  this->ResultActor->SetVisibility(aOn);
+  this->OverlaySource->SetShowResultPoints(aOn);
   this->CanvasRenderer->Modified();
 
   return PLUS_SUCCESS;
@@ -450,7 +433,7 @@ PlusStatus vtkPlusImageVisualizer::ShowResult(bool aOn)
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusImageVisualizer::SetResultColor(double r, double g, double b)
 {
-  this->ResultActor->GetProperty()->SetColor(r, g, b);
+  this->OverlaySource->SetResultPointColor(r, g, b);
 
   return PLUS_SUCCESS;
 }
@@ -458,7 +441,7 @@ PlusStatus vtkPlusImageVisualizer::SetResultColor(double r, double g, double b)
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusImageVisualizer::SetResultOpacity(double aOpacity)
 {
-  this->ResultActor->GetProperty()->SetOpacity(aOpacity);
+  this->OverlaySource->SetResultPointOpacity(aOpacity);
 
   return PLUS_SUCCESS;
 }
@@ -466,15 +449,13 @@ PlusStatus vtkPlusImageVisualizer::SetResultOpacity(double aOpacity)
 //----------------------------------------------------------------------------
 void vtkPlusImageVisualizer::SetLineSegmentationVisible(bool _arg)
 {
-  LineSegmentationActor->SetVisibility(_arg);
+  this->OverlaySource->SetShowLineSegmentation(_arg);
 }
 
 //----------------------------------------------------------------------------
 void vtkPlusImageVisualizer::SetLineSegmentationPoints(double startPoint[2], double endPoint[2])
 {
-  this->LineSegmentationLineSource->SetPoint1(startPoint[0], startPoint[1], 0.0);
-  this->LineSegmentationLineSource->SetPoint2(endPoint[0], endPoint[1], 0.0);
-  this->LineSegmentationLineSource->Update();
+  this->OverlaySource->SetLineSegmentationPoints(startPoint[0], startPoint[1], endPoint[0], endPoint[1]);
 }
 
 //-----------------------------------------------------------------------------
@@ -482,14 +463,30 @@ void vtkPlusImageVisualizer::SetInputData(vtkImageData* aImage)
 {
   LOG_TRACE("vtkPlusImageVisualizer::SetInputData");
 
-  this->GetImageActor()->SetInputData(aImage);
+  this->SliceCache->SetInputData(aImage);
+  if (aImage == NULL)
+  {
+    // Nothing to show
+    this->ImageActor->SetInputData(NULL);
+  }
+  else if (this->ImageMapper->GetInputAlgorithm() != this->SliceCache.GetPointer())
+  {
+    // The mapper gets only the displayed slice, so changing the slice of a volume only uploads the new slice
+    this->ImageMapper->SetInputConnection(this->SliceCache->GetOutputPort());
+  }
+}
+
+//-----------------------------------------------------------------------------
+vtkImageData* vtkPlusImageVisualizer::GetInputData()
+{
+  return vtkImageData::SafeDownCast(this->SliceCache->GetInputDataObject(0, 0));
 }
 
 //-----------------------------------------------------------------------------
 void vtkPlusImageVisualizer::SetResultPolyData(vtkPolyData* aResultPolyData)
 {
   LOG_TRACE("vtkPlusImageVisualizer::SetResultPolyData");
-  this->ResultGlyph->SetInputData(aResultPolyData);
+  this->OverlaySource->SetResultPolyData(aResultPolyData);
 }
 
 //-----------------------------------------------------------------------------
@@ -497,15 +494,18 @@ PlusStatus vtkPlusImageVisualizer::AddScreenAlignedProp(vtkProp3D* aProp)
 {
   LOG_TRACE("vtkPlusImageVisualizer::AddScreenAlignedProp");
 
-  // Store the prop for later manipulation
-  this->ScreenAlignedProps->AddItem(aProp);
+  if (aProp == NULL || this->ScreenAlignedPropSlots.count(aProp) > 0)
+  {
+    LOG_ERROR("Invalid or already added screen aligned prop.");
+    return PLUS_FAIL;
+  }
+
+  this->ScreenAlignedPropSlots[aProp] = this->ScreenAlignedProps.size();
+  this->ScreenAlignedProps.push_back(aProp);
 
-  // Store the original position of the prop
-  std::vector<double> pos;
-  pos.push_back(aProp->GetPosition()[0]);
-  pos.push_back(aProp->GetPosition()[1]);
-  pos.push_back(aProp->GetPosition()[2]);
-  this->ScreenAlignedPropOriginalPosition.push_back(pos);
+  // The position and orientation of the prop stay in MF orientation, all the props are moved to the current
+  // orientation at once by modifying the shared user matrix
+  aProp->SetUserMatrix(this->ScreenAlignedTransformMatrix);
 
   // Add it to the canvas
   this->GetCanvasRenderer()->AddActor(aProp);
@@ -516,33 +516,24 @@ PlusStatus vtkPlusImageVisualizer::AddScreenAlignedProp(vtkProp3D* aProp)
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusImageVisualizer::RemoveScreenAlignedProp(vtkProp3D* aProp)
 {
-  // Find index of aProp
-  int i = 0;
-  {
-    vtkProp3D* prop = NULL;
-    this->ScreenAlignedProps->InitTraversal();
-
-    do
-    {
-      prop = this->ScreenAlignedProps->GetNextProp3D();
-      if (prop == NULL || prop == aProp)
-      {
-        break;
-      }
-      ++i;
-    }
-    while (prop != NULL);
-  }
-
-  if (i > this->ScreenAlignedProps->GetNumberOfItems())
+  std::unordered_map<vtkProp3D*, size_t>::iterator slotIt = this->ScreenAlignedPropSlots.find(aProp);
+  if (slotIt == this->ScreenAlignedPropSlots.end())
   {
     LOG_ERROR("Prop not found in screen aligned prop list.");
     return PLUS_FAIL;
   }
 
-  this->ScreenAlignedProps->RemoveItem(aProp);
-  this->ScreenAlignedPropOriginalPosition.erase(this->ScreenAlignedPropOriginalPosition.begin() + i);
+  // Move the last prop to the freed slot, the order of the props does not matter
+  size_t slot = slotIt->second;
+  this->ScreenAlignedPropSlots.erase(slotIt);
+  if (slot != this->ScreenAlignedProps.size() - 1)
+  {
+    this->ScreenAlignedProps[slot] = this->ScreenAlignedProps.back();
+    this->ScreenAlignedPropSlots[this->ScreenAlignedProps[slot]] = slot;
+  }
+  this->ScreenAlignedProps.pop_back();
 
+  aProp->SetUserMatrix(NULL);
   this->GetCanvasRenderer()->RemoveActor(aProp);
 
   return PLUS_SUCCESS;
@@ -553,15 +544,14 @@ PlusStatus vtkPlusImageVisualizer::ClearScreenAlignedActorList()
 {
   LOG_TRACE("vtkPlusImageVisualizer::ClearScreenAlignedActorList");
 
-  vtkProp3D* prop = NULL;
-  vtkCollectionSimpleIterator pit;
-  for (this->ScreenAlignedProps->InitTraversal(pit);  prop = this->ScreenAlignedProps->GetNextProp3D(pit);)
+  for (std::vector<vtkSmartPointer<vtkProp3D> >::iterator propIt = this->ScreenAlignedProps.begin(); propIt != this->ScreenAlignedProps.end(); ++propIt)
   {
-    this->GetCanvasRenderer()->RemoveActor(prop);
+    (*propIt)->SetUserMatrix(NULL);
+    this->GetCanvasRenderer()->RemoveActor(*propIt);
   }
 
-  this->ScreenAlignedPropOriginalPosition.clear();
-  this->ScreenAlignedProps->RemoveAllItems();
+  this->ScreenAlignedPropSlots.clear();
+  this->ScreenAlignedProps.clear();
 
   return PLUS_SUCCESS;
 }
@@ -580,78 +570,43 @@ PlusStatus vtkPlusImageVisualizer::UpdateScreenAlignedActors()
   FrameSizeType dimensions = {0, 0, 0};
   this->SelectedChannel->GetBrightnessFrameSize(dimensions);
 
-  vtkCollectionSimpleIterator pit;
-  vtkProp3D* prop = NULL;
-  int i = 0;
-  for (this->ScreenAlignedProps->InitTraversal(pit); prop = this->ScreenAlignedProps->GetNextProp3D(pit); ++i)
-  {
-    // Undo any existing rotations to the prop, so that all subsequent rotations are from a base orientation
-    // Base orientation is MF_SCREEN_RIGHT_DOWN
-    prop->RotateX(-this->ScreenAlignedCurrentXRotation);
-    prop->RotateY(-this->ScreenAlignedCurrentYRotation);
-
-    // Future work: instead of saving the original position of a prop (which will prevent any clients from changing the position of the prop after adding it)
-    // determine a method to back calculate the original position
-    // Possible solution is to pass in the previous orientation, then reverse the following calculations
-    double originalPosition[3] = {0};
-    originalPosition[0] = this->ScreenAlignedPropOriginalPosition.at(i).at(0);
-    originalPosition[1] = this->ScreenAlignedPropOriginalPosition.at(i).at(1);
-    originalPosition[2] = this->ScreenAlignedPropOriginalPosition.at(i).at(2);
-
-    // Apply any necessary rotations and repositioning
-    double newPosition[3] = {0};
-    switch (this->CurrentMarkerOrientation)
-    {
-      case US_IMG_ORIENT_MF:
-        newPosition[0] = originalPosition[0];
-        newPosition[1] = originalPosition[1];
-        newPosition[2] = originalPosition[2];
-        break;
-      case US_IMG_ORIENT_MN:
-        prop->RotateX(180);
-        newPosition[0] = originalPosition[0];
-        newPosition[1] = dimensions[1] - originalPosition[1];
-        newPosition[2] = -originalPosition[2];
-        break;
-      case US_IMG_ORIENT_UN:
-        prop->RotateX(180);
-        prop->RotateY(180);
-        newPosition[0] = dimensions[0] - originalPosition[0];
-        newPosition[1] = dimensions[1] - originalPosition[1];
-        newPosition[2] = originalPosition[2];
-        break;
-      case US_IMG_ORIENT_UF:
-        prop->RotateY(180);
-        newPosition[0] = dimensions[0] - originalPosition[0];
-        newPosition[1] = originalPosition[1];
-        newPosition[2] = -originalPosition[2];
-        break;
-    }
-
-    prop->SetPosition(newPosition);
-  }
-
-  // Now update the member variables so that future rotations correctly undo the current rotations
+  // Compose the transform from the base orientation (MF) to the current one. Rotations by 180 degrees around the
+  // X and/or Y axes are mirrorings, so the matrix is set directly and there is no rounding error to accumulate.
+  double mirror[3] = {1.0, 1.0, 1.0};
+  double translation[3] = {0.0, 0.0, 0.0};
   switch (this->CurrentMarkerOrientation)
   {
     case US_IMG_ORIENT_MF:
-      this->ScreenAlignedCurrentXRotation = 0;
-      this->ScreenAlignedCurrentYRotation = 0;
       break;
     case US_IMG_ORIENT_MN:
-      this->ScreenAlignedCurrentYRotation = 0;
-      this->ScreenAlignedCurrentXRotation = 180;
+      // Rotate around X by 180 degrees
+      mirror[1] = -1.0;
+      mirror[2] = -1.0;
+      translation[1] = dimensions[1];
       break;
     case US_IMG_ORIENT_UN:
-      this->ScreenAlignedCurrentXRotation = 180.0;
-      this->ScreenAlignedCurrentYRotation = 180.0;
+      // Rotate around X and Y by 180 degrees
+      mirror[0] = -1.0;
+      mirror[1] = -1.0;
+      translation[0] = dimensions[0];
+      translation[1] = dimensions[1];
       break;
     case US_IMG_ORIENT_UF:
-      this->ScreenAlignedCurrentYRotation = 180.0;
-      this->ScreenAlignedCurrentXRotation = 0;
+      // Rotate around Y by 180 degrees
+      mirror[0] = -1.0;
+      mirror[2] = -1.0;
+      translation[0] = dimensions[0];
       break;
   }
 
+  // The matrix is shared by all the props as user matrix, so this updates the position and orientation of every prop
+  this->ScreenAlignedTransformMatrix->Identity();
+  for (int i = 0; i < 3; ++i)
+  {
+    this->ScreenAlignedTransformMatrix->SetElement(i, i, mirror[i]);
+    this->ScreenAlignedTransformMatrix->SetElement(i, 3, translation[i]);
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -747,21 +702,7 @@ PlusStatus vtkPlusImageVisualizer::SetROIBounds(int xMin, int xMax, int yMin, in
     this->RegionOfInterest[3] = yMax;
   }
 
-  double zPos = -1.0;
-  if (this->CurrentMarkerOrientation == US_IMG_ORIENT_MN || this->CurrentMarkerOrientation == US_IMG_ORIENT_UF)
-  {
-    zPos = 1.0;
-  }
-
-  // Set line positions
-  LeftLineSource->SetPoint1(this->RegionOfInterest[0], this->RegionOfInterest[2], zPos);
-  LeftLineSource->SetPoint2(this->RegionOfInterest[0], this->RegionOfInterest[3],  zPos);
-  TopLineSource->SetPoint1(this->RegionOfInterest[0], this->RegionOfInterest[2], zPos);
-  TopLineSource->SetPoint2(this->RegionOfInterest[1], this->RegionOfInterest[2], zPos);
-  RightLineSource->SetPoint1(this->RegionOfInterest[1], this->RegionOfInterest[2], zPos);
-  RightLineSource->SetPoint2(this->RegionOfInterest[1], this->RegionOfInterest[3], zPos);
-  BottomLineSource->SetPoint1(this->RegionOfInterest[0], this->RegionOfInterest[3], zPos);
-  BottomLineSource->SetPoint2(this->RegionOfInterest[1], this->RegionOfInterest[3], zPos);
+  this->OverlaySource->SetRegionOfInterest(this->RegionOfInterest);
 
   return PLUS_SUCCESS;
 }
@@ -778,11 +719,11 @@ PlusStatus vtkPlusImageVisualizer::EnableROI(bool aEnable)
       LOG_WARNING("Valid ROI is not defined. Check configuration or define valid ROI (Segmentation element, ClipRectangleOrigin and ClipRectangleSize attributes)");
       return PLUS_FAIL;
     }
-    this->ROIActorAssembly->VisibilityOn();
+    this->OverlaySource->SetShowRegionOfInterest(true);
   }
   else
   {
-    this->ROIActorAssembly->VisibilityOff();
+    this->OverlaySource->SetShowRegionOfInterest(false);
   }
 
   return PLUS_SUCCESS;
@@ -793,17 +734,7 @@ PlusStatus vtkPlusImageVisualizer::EnableWireLabels(bool aEnable)
 {
   LOG_TRACE("vtkPlusImageVisualizer::EnableWireLabels");
 
-  for (auto it = this->WireActors.begin(); it != this->WireActors.end(); ++it)
-  {
-    if (aEnable)
-    {
-      (*it)->VisibilityOn();
-    }
-    else
-    {
-      (*it)->VisibilityOff();
-    }
-  }
+  this->OverlaySource->SetShowLabels(aEnable);
 
   return PLUS_SUCCESS;
 }
@@ -827,6 +758,8 @@ PlusStatus vtkPlusImageVisualizer::InitializeWireLabelVisualization(vtkXMLDataEl
 
   this->ClearWireLabelVisualization();
 
+  std::vector<std::string> wireNames;
+
   // Load phantom definition
   vtkXMLDataElement* phantomDefinition = aConfig->FindNestedElementWithName("PhantomDefinition");
   if (phantomDefinition == NULL)
@@ -880,24 +813,13 @@ PlusStatus vtkPlusImageVisualizer::InitializeWireLabelVisualization(vtkXMLDataEl
             return PLUS_FAIL;
           }
 
-          // Since the internal orientation is always MF, display the indicators for MF in all cases
-          vtkSmartPointer<vtkTextActor3D> textActor = vtkSmartPointer<vtkTextActor3D>::New();
-          textActor->GetTextProperty()->SetColor(RESULT_SPHERE_COLOR);
-          textActor->GetTextProperty()->SetFontFamilyToArial();
-          textActor->GetTextProperty()->SetFontSize(16);
-          textActor->GetTextProperty()->SetJustificationToLeft();
-          textActor->GetTextProperty()->SetVerticalJustificationToTop();
-          textActor->GetTextProperty()->BoldOn();
-          textActor->SetInput(wireName);
-          textActor->RotateWXYZ(180.0, 1.0, 0.0, 0.0);
-          this->WireActors.push_back(textActor);
-          textActor->SetPosition(0.0, 0.0, -1.0);
-          this->AddScreenAlignedProp(textActor);
+          wireNames.push_back(wireName);
         }
       }
     }
   }
 
+  this->OverlaySource->SetLabelTexts(wireNames);
   this->EnableWireLabels(false);
 
   return PLUS_SUCCESS;
@@ -915,37 +837,18 @@ PlusStatus vtkPlusImageVisualizer::SetWireLabelPositions(vtkPoints* aPointList)
     return PLUS_SUCCESS;
   }
 
-  if (aPointList->GetNumberOfPoints() != this->WireActors.size())
+  if (aPointList->GetNumberOfPoints() != this->OverlaySource->GetNumberOfLabels())
   {
     this->EnableWireLabels(false);
     LOG_ERROR("Number of candidates does not match the number of wire labels.");
     return PLUS_FAIL;
   }
 
-  for (int i = 0; i < aPointList->GetNumberOfPoints(); ++i)
+  // The points are in image coordinates, the same as the image and the result points, so the labels follow the fiducials in any orientation
+  if (this->OverlaySource->SetLabelPositions(aPointList, WIRE_LABEL_OFFSET) != PLUS_SUCCESS)
   {
-    double* coords = aPointList->GetPoint(i);
-    vtkTextActor3D* actor = this->WireActors.at(i);
-    actor->SetPosition(coords[0] - 10.0, coords[1] - 10.0, actor->GetPosition()[2]);
-
-    // Since we would like the screen aligned prop system to manage the orientation of these for us,
-    // We must update the "original position" of the prop so that the system can use the latest position of the
-    // wire labels
-    int j = 0;
-    vtkProp3D* prop = NULL;
-    vtkCollectionSimpleIterator pit;
-    for (this->ScreenAlignedProps->InitTraversal(pit);  prop = this->ScreenAlignedProps->GetNextProp3D(pit); ++j)
-    {
-      vtkTextActor3D* ptr = dynamic_cast<vtkTextActor3D*>(prop);
-      if (ptr != NULL && ptr == actor)
-      {
-        std::vector<double> origCoords = ScreenAlignedPropOriginalPosition[j];
-        origCoords[0] = coords[0];
-        origCoords[1] = coords[1];
-        ScreenAlignedPropOriginalPosition[j] = origCoords;
-        break;
-      }
-    }
+    this->EnableWireLabels(false);
+    return PLUS_FAIL;
   }
   this->EnableWireLabels(true);
 
@@ -961,11 +864,8 @@ PlusStatus vtkPlusImageVisualizer::Reset()
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusImageVisualizer::ClearWireLabelVisualization()
 {
-  for (auto it = this->WireActors.begin(); it != this->WireActors.end(); ++it)
-  {
-    this->RemoveScreenAlignedProp(*it);
-  }
-  this->WireActors.clear();
+  this->OverlaySource->SetLabelTexts(std::vector<std::string>());
+  this->OverlaySource->SetShowLabels(false);
 
   return PLUS_SUCCESS;
 }
@@ -990,10 +890,19 @@ void vtkPlusImageVisualizer::SetChannel(vtkPlusChannel* channel)
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusImageVisualizer::SetSliceNumber(int number)
 {
-  if (number >= this->ImageMapper->GetSliceNumberMinValue() && number <= this->ImageMapper->GetSliceNumberMaxValue())
+  int range[2] = {0, 0};
+  if (this->SliceCache->GetSliceNumberRange(range) == PLUS_SUCCESS && number >= range[0] && number <= range[1])
   {
+    this->SliceCache->SetSliceNumber(number);
+    // The mapper shows the only slice of its input, but the slice number keeps it consistent with the slice extent
     this->ImageMapper->SetSliceNumber(number);
     return PLUS_SUCCESS;
   }
   return PLUS_FAIL;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusImageVisualizer::PrefetchSlices()
+{
+  return this->SliceCache->Prefetch();
 }
\ No newline at end of file
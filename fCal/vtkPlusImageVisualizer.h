@@ -15,20 +15,25 @@ See License.txt for details.
 // VTK includes
 #include <vtkActor.h>
 #include <vtkAssembly.h>
+#include <vtkActor2D.h>
 #include <vtkCamera.h>
-#include <vtkGlyph3D.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
 #include <vtkObject.h>
 #include <vtkPolyData.h>
-#include <vtkProp3DCollection.h>
 #include <vtkRenderer.h>
 #include <vtkSmartPointer.h>
 #include <vtkTextActor3D.h>
 
+// STL includes
+#include <unordered_map>
+#include <vector>
+
 class vtkXMLDataElement;
-class vtkLineSource;
 class vtkImageSliceMapper;
+class vtkMatrix4x4;
+class vtkPlusImageOverlaySource;
+class vtkPlusImageSliceCache;
 
 //-----------------------------------------------------------------------------
 
@@ -68,9 +73,15 @@ public:
   */
   void SetInputData(vtkImageData* aImage);
 
+  /*! Get the image data shown, NULL if there is none */
+  vtkImageData* GetInputData();
+
   /* Set the slice number of the data */
   PlusStatus SetSliceNumber(int number);
 
+  /*! Extract some of the slices next to the displayed one if the input is a volume, so that they can be shown without delay */
+  int PrefetchSlices();
+
   void SetResultPolyData(vtkPolyData* aResultPolyData);
 
   /*! Show or hide result points
@@ -87,6 +98,9 @@ public:
   */
   PlusStatus SetScreenRightDownAxesOrientation(US_IMAGE_ORIENTATION aOrientation = US_IMG_ORIENT_MF);
 
+  /*! Get the current MF orientation in 2D mode */
+  vtkGetMacro(CurrentMarkerOrientation, US_IMAGE_ORIENTATION);
+
   /*! Add an actor to the list of screen aligned actors
   * \param aProp vtkProp3D to be managed
   */
@@ -148,11 +162,11 @@ protected:
   /// Initialize Orientation 3D Actors
   void InitializeOrientationMarkers();
 
-  // Initialize line segmentation 3D actors
-  void InitializeLineSegmentationMarkers();
+  /// Initialize the overlay of results, ROI, line segmentation and wire labels
+  void InitializeOverlay();
 
-  /// Initialize the ROI sources/actors
-  void InitializeROIVisualization();
+  /// Set the depth of the overlay so that it is between the image and the camera in the current orientation
+  void UpdateOverlayDepth();
 
   /// Calculate the correct orientation and position of the markers
   PlusStatus UpdateOrientationMarkerLabelling();
@@ -161,7 +175,6 @@ protected:
   PlusStatus ClearScreenAlignedActorList();
 
   /// Update the position and orientation of actors to become screen aligned
-
   PlusStatus UpdateScreenAlignedActors();
 
   /// Initialize the wire actors
@@ -177,12 +190,16 @@ protected:
   vtkSmartPointer<vtkImageActor>                        ImageActor;
   ///  Image slice mapper of image actor
   vtkSmartPointer<vtkImageSliceMapper>                  ImageMapper;
+  ///  Passes the displayed slice of the input to the image mapper and caches the slices around it
+  vtkSmartPointer<vtkPlusImageSliceCache>               SliceCache;
   ///  Polydata holding the result points (eg. stylus tip, segmented points)
   vtkSmartPointer<vtkPolyData>                          ResultPolyData;
-  ///  Actor for displaying the result points (eg. stylus tip, segmented points)
-  vtkSmartPointer<vtkActor>                             ResultActor;
-  ///  Glyph producer for result
-  vtkSmartPointer<vtkGlyph3D>                           ResultGlyph;
+  ///  Generates the overlay (result points, ROI, line segmentation and wire labels) in one pass
+  vtkSmartPointer<vtkPlusImageOverlaySource>            OverlaySource;
+  ///  Actor for displaying the result points, the ROI and the line segmentation
+  vtkSmartPointer<vtkActor>                             OverlayActor;
+  ///  Actor for displaying all the wire labels
+  vtkSmartPointer<vtkActor2D>                           LabelActor;
   ///  Camera of the scene
   vtkSmartPointer<vtkCamera>                            ImageCamera;
   ///  Assembly of actors for displaying the MF orientation
@@ -191,37 +208,21 @@ protected:
   vtkSmartPointer<vtkTextActor3D>                       HorizontalOrientationTextActor;
   ///  Specific reference to the vertical text actor
   vtkSmartPointer<vtkTextActor3D>                       VerticalOrientationTextActor;
-  ///  The current horizontal orientation of the orientation markers
-  double                                                ScreenAlignedCurrentXRotation;
-  ///  The current vertical orientation of the orientation markers
-  double                                                ScreenAlignedCurrentYRotation;
   ///  Record the current state of the marker orientation
   US_IMAGE_ORIENTATION                                  CurrentMarkerOrientation;
-  ///  List of objects maintained by the visualizer to be screen aligned
-  vtkSmartPointer<vtkProp3DCollection>                  ScreenAlignedProps;
-  ///  List of original positions of screen-aligned objects
-  std::vector<std::vector<double>>                      ScreenAlignedPropOriginalPosition;
+  ///  List of objects maintained by the visualizer to be screen aligned, in no particular order
+  std::vector<vtkSmartPointer<vtkProp3D> >              ScreenAlignedProps;
+  ///  Slot of each screen-aligned prop in ScreenAlignedProps
+  std::unordered_map<vtkProp3D*, size_t>                ScreenAlignedPropSlots;
+  ///  Transform from MF orientation to the current orientation (a mirroring and a translation by the image size),
+  ///  shared by all screen-aligned props as user matrix
+  vtkSmartPointer<vtkMatrix4x4>                         ScreenAlignedTransformMatrix;
   ///  Flag to hold value of show/hide ROI
   bool                                                  ShowROI;
-  ///  Assembly to hold all of the actors of the ROI for easy hide/show
-  vtkSmartPointer<vtkAssembly>                          ROIActorAssembly;
-  ///  Line source of left line (one side of the ROI rectangle)
-  vtkSmartPointer<vtkLineSource>                        LeftLineSource;
-  ///  Line source of top line (one side of the ROI rectangle)
-  vtkSmartPointer<vtkLineSource>                        TopLineSource;
-  ///  Line source of right line (one side of the ROI rectangle)
-  vtkSmartPointer<vtkLineSource>                        RightLineSource;
-  ///  Line source of bottom line (one side of the ROI rectangle)
-  vtkSmartPointer<vtkLineSource>                        BottomLineSource;
   ///  Array holding the bounds of the ROI
   double                                                RegionOfInterest[4];
   ///  The channel to visualize
   vtkPlusChannel*                                       SelectedChannel;
-  ///  Vector to hold the actors for each wire
-  std::vector<vtkSmartPointer<vtkTextActor3D>>          WireActors;
-  /// Line visualization members
-  vtkSmartPointer<vtkLineSource>                        LineSegmentationLineSource;
-  vtkSmartPointer<vtkActor>                             LineSegmentationActor;
 };
 
 #endif
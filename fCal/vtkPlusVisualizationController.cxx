@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "vtkPlusVisualizationController.h"
+#include "QPlusFrameProfiler.h"
 #include "vtkPlus3DObjectVisualizer.h"
 #include "vtkPlusImageVisualizer.h"
 
@@ -16,13 +17,20 @@ See License.txt for details.
 
 // VTK includes
 #include <QVTKWidget.h>
+#include <vtkCallbackCommand.h>
 #include <vtkDirectory.h>
 #include <vtkInteractorStyleTrackballCamera.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkPolyData.h>
+#include <vtkCamera.h>
+#include <vtkPropCollection.h>
 #include <vtkProperty.h>
 #include <vtkRenderWindow.h>
+#include <vtkRendererCollection.h>
 #include <vtkRenderWindowInteractor.h>
+#include <vtkTextActor.h>
+#include <vtkTextProperty.h>
 #include <vtkTransform.h>
 #include <vtkXMLUtilities.h>
 #include <vtksys/SystemTools.hxx>
@@ -32,6 +40,49 @@ See License.txt for details.
 #include <QEvent>
 #include <QTimer>
 
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Forward the model loading progress of the perspective visualizer as a Qt signal
+  void ModelLoadingProgressCallback(vtkObject* vtkNotUsed(aCaller), unsigned long vtkNotUsed(aEventId), void* aClientData, void* aCallData)
+  {
+    vtkPlusVisualizationController* controller = static_cast<vtkPlusVisualizationController*>(aClientData);
+    emit controller->ModelLoadingProgress(*static_cast<double*>(aCallData));
+  }
+
+  //----------------------------------------------------------------------------
+  // Get the most recent modification time of anything that is rendered in a render window: renderers, cameras, props and their input data
+  vtkMTimeType GetRenderWindowSceneMTime(vtkRenderWindow* aRenderWindow)
+  {
+    // Adding or removing renderers and props modifies the collections
+    vtkRendererCollection* renderers = aRenderWindow->GetRenderers();
+    vtkMTimeType sceneMTime = renderers->GetMTime();
+
+    vtkCollectionSimpleIterator rendererIt;
+    renderers->InitTraversal(rendererIt);
+    while (vtkRenderer* renderer = renderers->GetNextRenderer(rendererIt))
+    {
+      sceneMTime = std::max(sceneMTime, renderer->GetMTime());
+      if (renderer->IsActiveCameraCreated())
+      {
+        sceneMTime = std::max(sceneMTime, renderer->GetActiveCamera()->GetMTime());
+      }
+
+      vtkPropCollection* props = renderer->GetViewProps();
+      sceneMTime = std::max(sceneMTime, props->GetMTime());
+      vtkCollectionSimpleIterator propIt;
+      props->InitTraversal(propIt);
+      while (vtkProp* prop = props->GetNextProp(propIt))
+      {
+        // The redraw time includes the mapper input, e.g., the image or the point glyphs. Hidden props only matter if they are shown again.
+        sceneMTime = std::max(sceneMTime, prop->GetVisibility() ? prop->GetRedrawMTime() : prop->GetMTime());
+      }
+    }
+
+    return sceneMTime;
+  }
+}
+
 //-----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusVisualizationController);
@@ -41,11 +92,18 @@ vtkPlusVisualizationController::vtkPlusVisualizationController()
   : ImageVisualizer(vtkSmartPointer<vtkPlusImageVisualizer>::New())
   , PerspectiveVisualizer(vtkSmartPointer<vtkPlus3DObjectVisualizer>::New())
   , BlankRenderer(vtkSmartPointer<vtkRenderer>::New())
+  , SnapshotWorker(new QPlusFrameSnapshotWorker())
+  , SnapshotMatrix(vtkSmartPointer<vtkMatrix4x4>::New())
+  , DisplayedImageActor(NULL)
+  , DisplayedImageTimestamp(UNDEFINED_TIMESTAMP)
+  , FrameStatisticsActor(vtkSmartPointer<vtkTextActor>::New())
   , ResultPolyData(vtkSmartPointer<vtkPolyData>::New())
   , InputPolyData(vtkSmartPointer<vtkPolyData>::New())
   , CurrentMode(DISPLAY_MODE_NONE)
   , AcquisitionFrameRate(20)
   , TransformRepository(NULL)
+  , TransformRepositoryVersion(0)
+  , TransformRepositoryModified(true)
   , SelectedChannel(NULL)
   , DataCollector(NULL)
 {
@@ -61,9 +119,21 @@ vtkPlusVisualizationController::vtkPlusVisualizationController()
   this->ResultPolyData->SetPoints(this->ResultPoints);
 
   // Initialize timer
-  connect(&this->AcquisitionTimer, &QTimer::timeout, this, &vtkPlusVisualizationController::Update);
   this->AcquisitionTimer.start(1000.0 / this->AcquisitionFrameRate);
 
+  // Poll the selected channel in a separate thread, the snapshots are handed over to the GUI thread by a queued signal
+  this->SnapshotWorker->moveToThread(&this->SnapshotThread);
+  connect(this->SnapshotWorker, &QPlusFrameSnapshotWorker::SnapshotReady, this, &vtkPlusVisualizationController::SnapshotReady, Qt::QueuedConnection);
+  this->SnapshotThread.start();
+
+  // Frame statistics overlay
+  this->FrameStatisticsActor->GetTextProperty()->SetFontSize(12);
+  this->FrameStatisticsActor->GetTextProperty()->SetColor(1.0, 1.0, 0.0);
+  this->FrameStatisticsActor->GetTextProperty()->SetVerticalJustificationToTop();
+  this->FrameStatisticsActor->GetPositionCoordinate()->SetCoordinateSystemToNormalizedViewport();
+  this->FrameStatisticsActor->SetPosition(0.01, 0.99);
+  this->FrameStatisticsActor->VisibilityOff();
+
   // Create 2D visualizer
   this->ImageVisualizer->SetResultPolyData(this->ResultPolyData);
   this->ImageVisualizer->EnableROI(false);
@@ -81,9 +151,16 @@ vtkPlusVisualizationController::vtkPlusVisualizationController()
 //-----------------------------------------------------------------------------
 vtkPlusVisualizationController::~vtkPlusVisualizationController()
 {
-  disconnect(&this->AcquisitionTimer, &QTimer::timeout, this, &vtkPlusVisualizationController::Update);
   this->AcquisitionTimer.stop();
 
+  this->ClearChannelTiles();
+
+  QMetaObject::invokeMethod(this->SnapshotWorker, "Stop", Qt::BlockingQueuedConnection);
+  this->SnapshotThread.quit();
+  this->SnapshotThread.wait();
+  delete this->SnapshotWorker;
+  this->SnapshotWorker = NULL;
+
   if (this->GetDataCollector() != NULL)
   {
     this->GetDataCollector()->Stop();
@@ -428,30 +505,248 @@ PlusStatus vtkPlusVisualizationController::SetScreenRightDownAxesOrientation(US_
   if (this->ImageVisualizer != NULL)
   {
     this->ImageVisualizer->SetScreenRightDownAxesOrientation(aOrientation);
+    for (std::vector<ChannelTile>::iterator tileIt = this->ChannelTiles.begin(); tileIt != this->ChannelTiles.end(); ++tileIt)
+    {
+      tileIt->Visualizer->SetScreenRightDownAxesOrientation(aOrientation);
+    }
     return PLUS_SUCCESS;
   }
 
   return PLUS_FAIL;
 }
 
+//-----------------------------------------------------------------------------
+QPlusFrameSnapshotWorker::SnapshotConstPtr vtkPlusVisualizationController::GetLatestSnapshot() const
+{
+  return this->SnapshotWorker->GetLatestSnapshot();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetSnapshotPollingIntervalMsec(int aIntervalMsec)
+{
+  LOG_TRACE("vtkPlusVisualizationController::SetSnapshotPollingIntervalMsec(" << aIntervalMsec << ")");
+
+  QMetaObject::invokeMethod(this->SnapshotWorker, "Start", Qt::QueuedConnection, Q_ARG(int, aIntervalMsec));
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetTargetFrameRate(double aFramesPerSecond)
+{
+  LOG_TRACE("vtkPlusVisualizationController::SetTargetFrameRate(" << aFramesPerSecond << ")");
+
+  if (this->Canvas == NULL || this->Canvas->GetRenderWindow() == NULL)
+  {
+    LOG_ERROR("Unable to set target frame rate, canvas is not set!");
+    return;
+  }
+
+  // The interactor style switches the render window between these rates when the camera interaction starts and ends
+  vtkRenderWindow* renderWindow = this->Canvas->GetRenderWindow();
+  renderWindow->SetDesiredUpdateRate(aFramesPerSecond);
+  if (renderWindow->GetInteractor() != NULL)
+  {
+    renderWindow->GetInteractor()->SetDesiredUpdateRate(aFramesPerSecond);
+    renderWindow->GetInteractor()->SetStillUpdateRate(aFramesPerSecond);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::ShowFrameStatistics(bool aShow)
+{
+  this->FrameStatisticsActor->SetVisibility(aShow);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetFrameStatisticsText(const std::string& aText)
+{
+  this->FrameStatisticsActor->SetInput(aText.c_str());
+
+  // The active renderer changes with the display mode, so make sure the overlay is on the one that is shown
+  vtkRenderer* canvasRenderer = this->GetCanvasRenderer();
+  if (canvasRenderer == NULL || canvasRenderer->HasViewProp(this->FrameStatisticsActor))
+  {
+    return;
+  }
+  this->ImageVisualizer->GetCanvasRenderer()->RemoveViewProp(this->FrameStatisticsActor);
+  this->PerspectiveVisualizer->GetCanvasRenderer()->RemoveViewProp(this->FrameStatisticsActor);
+  canvasRenderer->AddViewProp(this->FrameStatisticsActor);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVisualizationController::AddChannelTile(vtkPlusChannel* aChannel, QVTKWidget* aCanvas)
+{
+  LOG_TRACE("vtkPlusVisualizationController::AddChannelTile");
+
+  if (aChannel == NULL || aCanvas == NULL || aCanvas->GetRenderWindow() == NULL)
+  {
+    LOG_ERROR("Unable to add channel tile, channel or canvas is invalid!");
+    return PLUS_FAIL;
+  }
+  if (!aChannel->GetVideoDataAvailable() || aChannel->GetBrightnessOutput() == NULL)
+  {
+    LOG_WARNING("Channel " << aChannel->GetChannelId() << " has no B-mode video data, it is not shown in the tiled view.");
+    return PLUS_FAIL;
+  }
+
+  ChannelTile tile;
+  tile.Channel = aChannel;
+  tile.Canvas = aCanvas;
+  tile.Visualizer = vtkSmartPointer<vtkPlusImageVisualizer>::New();
+  tile.DisplayedTimestamp = UNDEFINED_TIMESTAMP;
+  tile.LastRenderedSceneMTime = 0;
+  tile.CameraCanvasSize[0] = 0;
+  tile.CameraCanvasSize[1] = 0;
+
+  // Show the image the same way as in the canvas
+  aCanvas->GetRenderWindow()->AddRenderer(tile.Visualizer->GetCanvasRenderer());
+  tile.Visualizer->SetChannel(aChannel);
+  tile.Visualizer->SetScreenRightDownAxesOrientation(this->ImageVisualizer->GetCurrentMarkerOrientation());
+
+  this->ChannelTiles.push_back(tile);
+  this->UpdateWatchedChannels();
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::ClearChannelTiles()
+{
+  LOG_TRACE("vtkPlusVisualizationController::ClearChannelTiles");
+
+  for (std::vector<ChannelTile>::iterator tileIt = this->ChannelTiles.begin(); tileIt != this->ChannelTiles.end(); ++tileIt)
+  {
+    if (tileIt->Canvas->GetRenderWindow() != NULL)
+    {
+      tileIt->Canvas->GetRenderWindow()->RemoveRenderer(tileIt->Visualizer->GetCanvasRenderer());
+    }
+  }
+  this->ChannelTiles.clear();
+  this->UpdateWatchedChannels();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetHighlightedChannelTile(vtkPlusChannel* aChannel)
+{
+  for (std::vector<ChannelTile>::iterator tileIt = this->ChannelTiles.begin(); tileIt != this->ChannelTiles.end(); ++tileIt)
+  {
+    // Modifying the renderer makes RenderChannelTiles() render the tile again
+    tileIt->Visualizer->GetCanvasRenderer()->SetGradientBackground(tileIt->Channel == aChannel);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::UpdateWatchedChannels()
+{
+  std::vector<vtkPlusChannel*> channels;
+  for (std::vector<ChannelTile>::iterator tileIt = this->ChannelTiles.begin(); tileIt != this->ChannelTiles.end(); ++tileIt)
+  {
+    channels.push_back(tileIt->Channel);
+  }
+  this->SnapshotWorker->SetWatchedChannels(channels);
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusVisualizationController::RenderChannelTiles()
+{
+  QPlusFrameProfiler::Scope profilerScope("vtkPlusVisualizationController::RenderChannelTiles");
+
+  int numberOfRenderedTiles(0);
+  for (std::vector<ChannelTile>::iterator tileIt = this->ChannelTiles.begin(); tileIt != this->ChannelTiles.end(); ++tileIt)
+  {
+    if (!tileIt->Canvas->isVisible())
+    {
+      continue;
+    }
+
+    // Getting the brightness output copies the latest frame, so it is only done if the worker has seen a new frame
+    double timestamp = this->SnapshotWorker->GetLatestWatchedTimestamp(tileIt->Channel);
+    if (timestamp != tileIt->DisplayedTimestamp)
+    {
+      vtkImageData* brightnessOutput = tileIt->Channel->GetBrightnessOutput();
+      if (tileIt->Visualizer->GetInputData() != brightnessOutput)
+      {
+        tileIt->Visualizer->SetInputData(brightnessOutput);
+      }
+      tileIt->DisplayedTimestamp = timestamp;
+    }
+
+    // The tiles are resized by the layout, fit the image to the new size
+    if (tileIt->Canvas->width() != tileIt->CameraCanvasSize[0] || tileIt->Canvas->height() != tileIt->CameraCanvasSize[1])
+    {
+      tileIt->Visualizer->UpdateCameraPose();
+      tileIt->CameraCanvasSize[0] = tileIt->Canvas->width();
+      tileIt->CameraCanvasSize[1] = tileIt->Canvas->height();
+    }
+
+    if (GetRenderWindowSceneMTime(tileIt->Canvas->GetRenderWindow()) == tileIt->LastRenderedSceneMTime)
+    {
+      continue;
+    }
+    tileIt->Canvas->repaint();
+    tileIt->LastRenderedSceneMTime = GetRenderWindowSceneMTime(tileIt->Canvas->GetRenderWindow());
+    ++numberOfRenderedTiles;
+  }
+
+  return numberOfRenderedTiles;
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVisualizationController::Update()
 {
+  QPlusFrameProfiler::Scope profilerScope("vtkPlusVisualizationController::Update");
+
+  this->UpdateSnapshotTransformRepository();
+
+  // Take the snapshot of the frame that is rendered in this refresh cycle
+  QPlusFrameSnapshotWorker::SnapshotConstPtr latestSnapshot = this->SnapshotWorker->GetLatestSnapshot();
+  if (latestSnapshot)
+  {
+    this->TransformSnapshot = latestSnapshot;
+  }
+
   if (this->PerspectiveVisualizer != NULL && CurrentMode == DISPLAY_MODE_3D)
   {
-    this->PerspectiveVisualizer->Update();
+    // The 3D visualizer reads the object transforms from the repository. Without a channel (disconnected) or before
+    // the first snapshot there is nothing to show yet, that is not an error on every refresh.
+    if (this->SelectedChannel != NULL && this->TransformSnapshot && this->SetTransformsFromSnapshot(this->TransformSnapshot) == PLUS_SUCCESS)
+    {
+      this->PerspectiveVisualizer->Update();
+    }
   }
 
-  // Force update of the brightness image in the DataCollector,
-  // because it is the image that the image actors show
-  if (this->SelectedChannel != NULL && this->GetImageActor() != NULL)
+  // Update the brightness image in the DataCollector, because it is the image that the image actors show.
+  // Getting it copies the latest frame and makes the renderer upload it, so it is only done when a new frame arrived.
+  // The image data object stays the same between frames, so the texture of the actor is reused and only its content is replaced.
+  vtkImageActor* imageActor = this->GetImageActor();
+  if (this->SelectedChannel != NULL && imageActor != NULL)
   {
-    this->GetImageActor()->SetInputData(this->SelectedChannel->GetBrightnessOutput());
+    double frameTimestamp = (this->TransformSnapshot ? this->TransformSnapshot->Timestamp : UNDEFINED_TIMESTAMP);
+    if (imageActor != this->DisplayedImageActor || this->GetImageData() == NULL || frameTimestamp != this->DisplayedImageTimestamp)
+    {
+      vtkImageData* brightnessOutput = this->SelectedChannel->GetBrightnessOutput();
+      if (this->GetImageData() != brightnessOutput)
+      {
+        this->SetImageData(brightnessOutput);
+      }
+      this->DisplayedImageActor = imageActor;
+      this->DisplayedImageTimestamp = frameTimestamp;
+    }
   }
 
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+vtkMTimeType vtkPlusVisualizationController::GetSceneMTime()
+{
+  if (this->Canvas == NULL || this->Canvas->GetRenderWindow() == NULL)
+  {
+    return 0;
+  }
+
+  return GetRenderWindowSceneMTime(this->Canvas->GetRenderWindow());
+}
+
 //-----------------------------------------------------------------------------
 vtkRenderer* vtkPlusVisualizationController::GetCanvasRenderer()
 {
@@ -525,19 +820,38 @@ PlusStatus vtkPlusVisualizationController::GetTransformMatrix(const char* aTrans
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVisualizationController::GetTransformMatrix(igsioTransformName aTransform, vtkMatrix4x4* aOutputMatrix, ToolStatus* aStatus/* = NULL*/)
 {
-  igsioTrackedFrame trackedFrame;
-  if (this->SelectedChannel == NULL || this->SelectedChannel->GetTrackedFrame(trackedFrame) != PLUS_SUCCESS)
+  QPlusFrameSnapshotWorker::SnapshotConstPtr snapshot;
+  if (this->GetLatestTransformSnapshot(snapshot) != PLUS_SUCCESS)
   {
-    LOG_ERROR("Unable to get tracked frame from selected channel!");
     return PLUS_FAIL;
   }
-  if (this->TransformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
+
+  // The transform is normally computed by the snapshot worker. The first query of a transform and the queries after the
+  // repository has been modified are computed here from the frame transforms of the snapshot.
+  bool transformExists(false);
+  const QPlusFrameSnapshotWorker::Snapshot::ResolvedTransformEntry* resolvedTransform = this->GetResolvedTransform(snapshot, aTransform);
+  if (resolvedTransform != NULL)
   {
-    LOG_ERROR("Unable to set transforms from tracked frame!");
-    return PLUS_FAIL;
+    transformExists = resolvedTransform->Exists;
+    if (transformExists)
+    {
+      aOutputMatrix->DeepCopy(resolvedTransform->Matrix);
+      if (aStatus != NULL)
+      {
+        *aStatus = resolvedTransform->Status;
+      }
+    }
+  }
+  else
+  {
+    if (this->SetTransformsFromSnapshot(snapshot) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    transformExists = (this->TransformRepository->GetTransform(aTransform, aOutputMatrix, aStatus) == PLUS_SUCCESS);
   }
 
-  if (this->TransformRepository->GetTransform(aTransform, aOutputMatrix, aStatus) != PLUS_SUCCESS)
+  if (!transformExists)
   {
     std::string transformName;
     aTransform.GetTransformName(transformName);
@@ -548,6 +862,85 @@ PlusStatus vtkPlusVisualizationController::GetTransformMatrix(igsioTransformName
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVisualizationController::GetLatestTransformSnapshot(QPlusFrameSnapshotWorker::SnapshotConstPtr& aSnapshot)
+{
+  if (this->SelectedChannel == NULL)
+  {
+    LOG_ERROR("Unable to get tracked frame from selected channel!");
+    return PLUS_FAIL;
+  }
+
+  // Before the worker has published the first frame of the channel the snapshot is created directly from the channel
+  aSnapshot = this->SnapshotWorker->GetLatestSnapshot();
+  double timestamp(UNDEFINED_TIMESTAMP);
+  if (!aSnapshot
+      && (this->SelectedChannel->GetMostRecentTimestamp(timestamp) != PLUS_SUCCESS
+          || QPlusFrameSnapshotWorker::CreateSnapshot(this->SelectedChannel, timestamp, aSnapshot) != PLUS_SUCCESS))
+  {
+    LOG_ERROR("Unable to get tracked frame from selected channel!");
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+const QPlusFrameSnapshotWorker::Snapshot::ResolvedTransformEntry* vtkPlusVisualizationController::GetResolvedTransform(const QPlusFrameSnapshotWorker::SnapshotConstPtr& aSnapshot, const igsioTransformName& aTransform)
+{
+  this->UpdateSnapshotTransformRepository();
+
+  const QPlusFrameSnapshotWorker::Snapshot::ResolvedTransformEntry* resolvedTransform(NULL);
+  if (aSnapshot->TransformRepositoryVersion == this->TransformRepositoryVersion)
+  {
+    resolvedTransform = aSnapshot->FindResolvedTransform(aTransform);
+  }
+  if (resolvedTransform == NULL)
+  {
+    this->SnapshotWorker->AddResolvedTransformName(aTransform);
+  }
+  return resolvedTransform;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::UpdateSnapshotTransformRepository()
+{
+  if (!this->TransformRepositoryModified)
+  {
+    return;
+  }
+
+  ++this->TransformRepositoryVersion;
+  this->SnapshotWorker->SetTransformRepository(this->TransformRepository, this->TransformRepositoryVersion);
+  this->TransformRepositoryModified = false;
+}
+
+//-----------------------------------------------------------------------------
+vtkIGSIOTransformRepository* vtkPlusVisualizationController::GetTransformRepository()
+{
+  // The caller may modify the repository, so the snapshot worker gets a new copy before the next transform query
+  this->TransformRepositoryModified = true;
+  return this->TransformRepository;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVisualizationController::SetTransformsFromSnapshot(const QPlusFrameSnapshotWorker::SnapshotConstPtr& aSnapshot)
+{
+  // The repository is shared with the toolboxes, which may have set transforms of other frames since the last query,
+  // so the snapshot transforms are set every time. This is only a few matrix copies.
+  for (std::vector<QPlusFrameSnapshotWorker::Snapshot::TransformEntry>::const_iterator it = aSnapshot->Transforms.begin(); it != aSnapshot->Transforms.end(); ++it)
+  {
+    this->SnapshotMatrix->DeepCopy(it->Matrix);
+    if (this->TransformRepository->SetTransform(it->Name, this->SnapshotMatrix, it->Status) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Unable to set transforms from tracked frame!");
+      return PLUS_FAIL;
+    }
+  }
+
+  return PLUS_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVisualizationController::SetVolumeMapper(vtkPolyDataMapper* aContourMapper)
 {
@@ -592,15 +985,18 @@ PlusStatus vtkPlusVisualizationController::IsExistingTransform(const char* aTran
       return PLUS_FAIL;
     }
 
-    igsioTrackedFrame trackedFrame;
-    if (this->SelectedChannel->GetTrackedFrame(trackedFrame) != PLUS_SUCCESS)
+    QPlusFrameSnapshotWorker::SnapshotConstPtr snapshot;
+    if (this->GetLatestTransformSnapshot(snapshot) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Unable to get tracked frame from data collector!");
       return PLUS_FAIL;
     }
-    if (this->TransformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
+    const QPlusFrameSnapshotWorker::Snapshot::ResolvedTransformEntry* resolvedTransform = this->GetResolvedTransform(snapshot, transformName);
+    if (resolvedTransform != NULL)
+    {
+      return (resolvedTransform->Exists ? PLUS_SUCCESS : PLUS_FAIL);
+    }
+    if (this->SetTransformsFromSnapshot(snapshot) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Unable to set transforms from tracked frame!");
       return PLUS_FAIL;
     }
   }
@@ -620,7 +1016,7 @@ PlusStatus vtkPlusVisualizationController::DisconnectInput()
 {
   if (this->GetImageActor() != NULL)
   {
-    this->GetImageActor()->SetInputData(NULL);
+    this->SetImageData(NULL);
   }
 
   return PLUS_SUCCESS;
@@ -632,7 +1028,7 @@ PlusStatus vtkPlusVisualizationController::ConnectInput()
   vtkPlusChannel* aChannel(NULL);
   if (this->GetImageActor() != NULL && this->SelectedChannel != NULL)
   {
-    this->GetImageActor()->SetInputData(this->SelectedChannel->GetBrightnessOutput());
+    this->SetImageData(this->SelectedChannel->GetBrightnessOutput());
   }
 
   return PLUS_SUCCESS;
@@ -653,6 +1049,34 @@ vtkImageActor* vtkPlusVisualizationController::GetImageActor()
   return NULL;
 }
 
+//-----------------------------------------------------------------------------
+vtkImageData* vtkPlusVisualizationController::GetImageData()
+{
+  if (this->CurrentMode == DISPLAY_MODE_2D && this->ImageVisualizer != NULL)
+  {
+    return this->ImageVisualizer->GetInputData();
+  }
+  else if (this->CurrentMode == DISPLAY_MODE_3D && this->PerspectiveVisualizer != NULL)
+  {
+    return this->PerspectiveVisualizer->GetImageData();
+  }
+
+  return NULL;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetImageData(vtkImageData* aImage)
+{
+  if (this->CurrentMode == DISPLAY_MODE_2D && this->ImageVisualizer != NULL)
+  {
+    this->ImageVisualizer->SetInputData(aImage);
+  }
+  else if (this->CurrentMode == DISPLAY_MODE_3D && this->PerspectiveVisualizer != NULL)
+  {
+    this->PerspectiveVisualizer->SetImageData(aImage);
+  }
+}
+
 //-----------------------------------------------------------------------------
 bool vtkPlusVisualizationController::Is2DMode()
 {
@@ -729,12 +1153,20 @@ PlusStatus vtkPlusVisualizationController::ReadConfiguration(vtkXMLDataElement*
   {
     LOG_ERROR("Unable to initialize transform repository!");
   }
+  this->TransformRepositoryModified = true;
 
   // Pass on any configuration steps to children
   if (this->PerspectiveVisualizer != NULL)
   {
     this->PerspectiveVisualizer->SetTransformRepository(this->TransformRepository);
-    if (this->PerspectiveVisualizer->ReadConfiguration(aXMLElement) != PLUS_SUCCESS)
+
+    vtkSmartPointer<vtkCallbackCommand> progressCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+    progressCallback->SetCallback(ModelLoadingProgressCallback);
+    progressCallback->SetClientData(this);
+    unsigned long progressObserverTag = this->PerspectiveVisualizer->AddObserver(vtkCommand::ProgressEvent, progressCallback);
+    PlusStatus status = this->PerspectiveVisualizer->ReadConfiguration(aXMLElement);
+    this->PerspectiveVisualizer->RemoveObserver(progressObserverTag);
+    if (status != PLUS_SUCCESS)
     {
       LOG_ERROR("Unable to configure perspective visualizer.");
       return PLUS_FAIL;
@@ -787,6 +1219,7 @@ PlusStatus vtkPlusVisualizationController::StopAndDisconnectDataCollector()
   }
 
   this->DisconnectInput();
+  this->SnapshotWorker->SetChannel(NULL);
   SetDataCollector(NULL);   // the local smart pointer still keeps a reference
 
   dataCollector->Stop();
@@ -800,6 +1233,7 @@ PlusStatus vtkPlusVisualizationController::ClearTransformRepository()
 {
   vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
   this->SetTransformRepository(transformRepository);
+  this->TransformRepositoryModified = true;
 
   return PLUS_SUCCESS;
 }
@@ -947,6 +1381,9 @@ void vtkPlusVisualizationController::SetInputData(vtkImageData* input)
 void vtkPlusVisualizationController::SetSelectedChannel(vtkPlusChannel* aChannel)
 {
   this->SelectedChannel = aChannel;
+  this->SnapshotWorker->SetChannel(aChannel);
+  this->TransformSnapshot.reset();
+  this->DisplayedImageActor = NULL;
 
   if (this->ImageVisualizer != NULL)
   {
@@ -976,4 +1413,19 @@ void vtkPlusVisualizationController::SetSliceNumber(int number)
   {
     this->PerspectiveVisualizer->SetSliceNumber(number);
   }
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusVisualizationController::PrefetchSlices()
+{
+  if (this->CurrentMode == DISPLAY_MODE_2D && this->ImageVisualizer != NULL)
+  {
+    return this->ImageVisualizer->PrefetchSlices();
+  }
+  else if (this->CurrentMode == DISPLAY_MODE_3D && this->PerspectiveVisualizer != NULL)
+  {
+    return this->PerspectiveVisualizer->PrefetchSlices();
+  }
+
+  return 0;
 }
\ No newline at end of file
@@ -14,13 +14,20 @@ See License.txt for details.
 #include <vtkPlusDataCollector.h>
 #include <vtkIGSIOTransformRepository.h>
 
+// Local includes
+#include "QPlusFrameSnapshotWorker.h"
+
 // Qt includes
 #include <QObject>
+#include <QThread>
 #include <QTimer>
 
 // VTK includes
 #include <QVTKWidget.h>
 
+// STL includes
+#include <vector>
+
 class vtkPlusImageVisualizer;
 class vtkPlus3DObjectVisualizer;
 class vtkPlusDisplayableObject;
@@ -29,8 +36,10 @@ class vtkImageActor;
 class vtkMatrix4x4;
 class vtkPolyData;
 class vtkPolyDataMapper;
+class vtkRenderWindow;
 class vtkRenderer;
 class vtkSTLReader;
+class vtkTextActor;
 class vtkTransform;
 class vtkXMLDataElement;
 
@@ -39,14 +48,18 @@ class QResizeEvent;
 /*! \class vtkPlusVisualizationController
 \brief Class that is responsible for managing a connection with tracked data and managing the visualization of said data
 
-Usage: Instantiate, set the QVTKCanvas that is to be managed by this visualizer the call Initialize function. Updating the visualization is done by attaching Update() to a QTimer (self-managed).
-Before calling this, force the data collector to provide new data by calling GetDataCollector()->Modified() function.
+Usage: Instantiate, set the QVTKCanvas that is to be managed by this visualizer the call Initialize function. The selected channel is polled on a worker thread,
+which emits SnapshotReady() when a new tracked frame is available. Updating the visualization is done by calling Update() when the owner decides to render a new frame.
 
 It has three modes, DISPLAY_MODE_2D, DISPLAY_MODE_3D and DISPLAY_MODE_NONE. In DISPLAY_MODE_2D it shows only the video input in the whole window. In DISPLAY_MODE_3D, all the devices and
 the image is visible (that are defined in the device set configuration file's Rendering element). In DISPLAY_MODE_NONE the canvas is hidden and all renderers are detached.
 
 Devices and objects can be shown and hidden (HideAll(), ShowAllObjects(), ShowObjectsByCoordinateFrame(), ShowInput(), ShowResult()). Internally, this class forwards these requests to the underlying visualization classes.
 
+Further video channels can be shown next to the canvas in channel tiles (AddChannelTile()). Each tile has its own canvas and image visualizer.
+The channels of the tiles are polled by the same worker thread as the selected channel, and RenderChannelTiles() only fetches the image
+and renders the tiles whose channel has a new frame, so the cost of the tiled view grows with the number of new frames, not with the number of tiles.
+
 \ingroup PlusAppCommonWidgets
 */
 class vtkPlusVisualizationController : public QObject, public vtkObject
@@ -134,7 +147,9 @@ public:
   PlusStatus DumpBuffersToDirectory(const char* aDirectory);
 
   /*!
-  * Return acquisition timer (to be able to connect actions to it)
+  * Return acquisition timer (to be able to connect actions to it). Rendering is driven by the snapshots of the selected
+  * channel, the timer only samples the transforms at AcquisitionFrameRate for the stylus calibration and the phantom
+  * registration toolboxes.
   * \return Acquisition timer object
   */
   QTimer& GetAcquisitionTimer()
@@ -174,6 +189,61 @@ public:
   */
   PlusStatus IsExistingTransform(const char* aTransformFrom, const char* aTransformTo, bool aUseLatestTrackedFrame = true);
 
+  /*! Get the transforms of the most recent tracked frame of the selected channel. Returns an empty pointer if no frame has been received yet. */
+  QPlusFrameSnapshotWorker::SnapshotConstPtr GetLatestSnapshot() const;
+
+  /*!
+  * Set how often the selected channel is checked for new frames
+  * \param aIntervalMsec Polling interval in milliseconds
+  */
+  void SetSnapshotPollingIntervalMsec(int aIntervalMsec);
+
+  /*!
+  * Set the frame rate the canvas should keep. The render time of each frame is allocated accordingly, which makes
+  * level of detail actors (e.g., decimated models) switch to a lower resolution if the full resolution cannot be rendered in time.
+  * \param aFramesPerSecond Target frame rate, also used while the camera is being moved
+  */
+  void SetTargetFrameRate(double aFramesPerSecond);
+
+  /*!
+  * Show or hide the frame statistics text in the top left corner of the canvas
+  * \param aShow Show if true, else hide
+  */
+  void ShowFrameStatistics(bool aShow);
+
+  /*! Set the frame statistics text (e.g., frame rate and frame time) */
+  void SetFrameStatisticsText(const std::string& aText);
+
+  /*!
+  * Show a video channel in a tile of the tiled view
+  * \param aChannel Channel to show, it must have B-mode video data
+  * \param aCanvas Canvas of the tile. It is not owned by the controller, ClearChannelTiles() must be called before it is deleted.
+  */
+  PlusStatus AddChannelTile(vtkPlusChannel* aChannel, QVTKWidget* aCanvas);
+
+  /*! Remove all channel tiles and stop polling their channels */
+  void ClearChannelTiles();
+
+  /*! Highlight the tile of a channel (e.g., the selected one) with a gradient background, NULL to highlight none */
+  void SetHighlightedChannelTile(vtkPlusChannel* aChannel);
+
+  /*!
+  * Update the image of the channel tiles that have a new frame and render the tiles whose scene has changed since their last render
+  * \return Number of rendered tiles
+  */
+  int RenderChannelTiles();
+
+  /*!
+  * Forward any updates to members that require it
+  */
+  PlusStatus Update();
+
+  /*!
+  * Get the most recent modification time of anything that is rendered in the canvas: renderers, cameras, props and their
+  * input data. If it has not changed since the last render, then rendering again would produce the same picture.
+  */
+  vtkMTimeType GetSceneMTime();
+
   /*! Function to handle resize events */
   void resizeEvent(QResizeEvent* aEvent);
 
@@ -270,6 +340,13 @@ public:
   /*! Set the slice number in the image visualizer */
   void SetSliceNumber(int number);
 
+  /*!
+  * Extract some of the slices next to the displayed one if the image is a volume, so that scrolling through the slices
+  * does not have to wait for them. Cheap if there is nothing to extract, meant to be called when the GUI is idle.
+  * \return Number of slices extracted
+  */
+  int PrefetchSlices();
+
   /*! Set the location of the line actor for the line segmentation result */
   void SetLineSegmentationPoints(double startPoint_Image[2], double endPoint_Image[2]);
 
@@ -288,18 +365,26 @@ public:
   vtkSmartPointer<vtkPoints> GetResultPolyDataPoints();
   vtkSmartPointer<vtkPoints> GetInputPolyDataPoints();
 
-protected slots:
+signals:
+  /*! Emitted in the GUI thread when a new snapshot is available from the selected channel */
+  void SnapshotReady();
+
   /*!
-  * Forward any updates to members that require it
+  * Emitted while the model files are being loaded in ReadConfiguration
+  * \param aProgress Ratio of the loaded model files (0..1)
   */
-  PlusStatus Update();
+  void ModelLoadingProgress(double aProgress);
 
 public:
   // Set/Get macros for member variables
   PlusStatus SetAcquisitionFrameRate(int aFrameRate);
   vtkGetMacro(AcquisitionFrameRate, int);
 
-  vtkGetObjectMacro(TransformRepository, vtkIGSIOTransformRepository);
+  /*!
+  * Get the transform repository. The caller may modify it, so the snapshot worker gets a copy of it before the next
+  * transform query, and until it has computed the transforms with the new copy they are computed by the GUI.
+  */
+  vtkIGSIOTransformRepository* GetTransformRepository();
   vtkGetObjectMacro(DataCollector, vtkPlusDataCollector);
 
   vtkRenderer* GetCanvasRenderer();
@@ -315,11 +400,51 @@ protected:
 
   vtkImageActor* GetImageActor();
 
+  /*! Get/set the image shown by the image actor of the current mode (the actor gets the displayed slice of it) */
+  vtkImageData* GetImageData();
+  void SetImageData(vtkImageData* aImage);
+
+  /*!
+  * Get the transforms of the most recent frame of the selected channel for a transform query. Each query gets the latest
+  * snapshot of the worker, so queries driven by the acquisition timer see the newest frame and not the rendered one.
+  */
+  PlusStatus GetLatestTransformSnapshot(QPlusFrameSnapshotWorker::SnapshotConstPtr& aSnapshot);
+
+  /*! Set the transforms of a snapshot in the transform repository. The image data of the frame is not copied. */
+  PlusStatus SetTransformsFromSnapshot(const QPlusFrameSnapshotWorker::SnapshotConstPtr& aSnapshot);
+
+  /*!
+  * Get a transform that the snapshot worker has computed into a snapshot. Returns NULL if the snapshot does not contain it
+  * or it has been computed with an outdated copy of the repository. The worker then computes it into the following snapshots.
+  */
+  const QPlusFrameSnapshotWorker::Snapshot::ResolvedTransformEntry* GetResolvedTransform(const QPlusFrameSnapshotWorker::SnapshotConstPtr& aSnapshot, const igsioTransformName& aTransform);
+
+  /*! Give the snapshot worker a new copy of the transform repository if it may have been modified */
+  void UpdateSnapshotTransformRepository();
+
   QVTKWidget* GetCanvas()
   {
     return Canvas;
   }
 
+  /*! Poll the channels of the channel tiles in the snapshot worker */
+  void UpdateWatchedChannels();
+
+protected:
+  /*! A video channel shown in a tile of the tiled view */
+  struct ChannelTile
+  {
+    vtkPlusChannel*                         Channel;
+    QVTKWidget*                             Canvas;
+    vtkSmartPointer<vtkPlusImageVisualizer> Visualizer;
+    /*! Timestamp of the frame that the tile shows */
+    double                                  DisplayedTimestamp;
+    /*! Scene modification time after the last render of the tile */
+    vtkMTimeType                            LastRenderedSceneMTime;
+    /*! Canvas size when the camera was last positioned */
+    int                                     CameraCanvasSize[2];
+  };
+
 protected:
   /*!
   * Constructor
@@ -338,8 +463,23 @@ protected:
   vtkSmartPointer<vtkPlus3DObjectVisualizer>  PerspectiveVisualizer;
   /*! Renderer to use when there is nothing to show */
   vtkSmartPointer<vtkRenderer>                BlankRenderer;
-  /*! Timer for acquisition */
+  /*! Timer for sampling the transforms in the stylus calibration and phantom registration toolboxes */
   QTimer                                      AcquisitionTimer;
+  /*! Thread that polls the selected channel */
+  QThread                                     SnapshotThread;
+  /*! Produces the transform snapshots of the selected channel, lives in SnapshotThread */
+  QPlusFrameSnapshotWorker*                   SnapshotWorker;
+  /*! Transforms of the frame that is rendered, taken in Update(). Transform queries use the latest snapshot instead. */
+  QPlusFrameSnapshotWorker::SnapshotConstPtr  TransformSnapshot;
+  /*! Reused matrix for setting the snapshot transforms in the repository */
+  vtkSmartPointer<vtkMatrix4x4>               SnapshotMatrix;
+  /*! Image actor and frame timestamp of the last image update, the image is only fetched again if either changes */
+  vtkImageActor*                              DisplayedImageActor;
+  double                                      DisplayedImageTimestamp;
+  /*! Text actor showing the frame statistics on top of the active renderer */
+  vtkSmartPointer<vtkTextActor>               FrameStatisticsActor;
+  /*! Tiles of the tiled view, in addition to the canvas */
+  std::vector<ChannelTile>                    ChannelTiles;
   /*! Polydata holding the result points (eg. stylus tip, segmented points) */
   vtkSmartPointer<vtkPolyData>                ResultPolyData;
   vtkSmartPointer<vtkPoints>                  ResultPoints;
@@ -353,6 +493,10 @@ protected:
   /// Cached variables from other systems
   QVTKWidget*                                 Canvas;
   vtkIGSIOTransformRepository*                 TransformRepository;
+  /*! Version of the copy of the transform repository in the snapshot worker */
+  int                                         TransformRepositoryVersion;
+  /*! True if the transform repository may have been modified since it was copied to the snapshot worker */
+  bool                                        TransformRepositoryModified;
   vtkPlusChannel*                             SelectedChannel;
   vtkPlusDataCollector*                       DataCollector;
 };